@@ -0,0 +1,41 @@
+/*
+ * RO-DOS Arena Allocator Header
+ * Bump allocation from heap chunks, released all at once
+ *
+ * An arena hands out memory by advancing an offset through chunks taken
+ * from kmalloc; arena_reset() makes all of it available again in one
+ * step. Meant for work with a clear end, such as one shell command:
+ * cmd_dispatch's scratch arena holds the NANO, DMESG /SAVE and PYTHON
+ * buffers and WGET's request strings, where matching kfree calls would
+ * only fragment the heap and large stack arrays would eat into the kernel
+ * stack.
+ */
+
+#ifndef _RODOS_ARENA_H
+#define _RODOS_ARENA_H
+
+#include <stdint.h>
+
+typedef struct arena_chunk arena_chunk_t;
+
+typedef struct {
+    arena_chunk_t *chunks;      /* current chunk first */
+    uint32_t chunk_size;        /* payload of a regular chunk */
+    uint32_t used;              /* bytes handed out since the last reset */
+    uint32_t peak;              /* highest 'used' seen */
+} arena_t;
+
+/* Static initializer; no memory is taken until the first allocation */
+#define ARENA_INIT(size) { 0, (size), 0, 0 }
+
+/* size bytes, 8-byte aligned, valid until the next reset. Requests larger
+ * than chunk_size get a chunk of their own. NULL if the heap is out. */
+void *arena_alloc(arena_t *a, uint32_t size);
+
+/* Invalidate everything allocated; one regular chunk is kept for reuse */
+void arena_reset(arena_t *a);
+
+/* Return every chunk to the heap */
+void arena_release(arena_t *a);
+
+#endif /* _RODOS_ARENA_H */
@@ -0,0 +1,30 @@
+/*
+ * RO-DOS Backtrace Header
+ * EBP-chain stack unwinder with symbolized output
+ *
+ * C code is built with frame pointers in every profile, so each frame
+ * starts with the caller's EBP followed by the return address. Assembly
+ * routines without a frame are skipped over rather than shown.
+ */
+
+#ifndef _RODOS_BACKTRACE_H
+#define _RODOS_BACKTRACE_H
+
+#include <stdint.h>
+
+/* Deepest chain printed by backtrace_print() */
+#define BACKTRACE_MAX_DEPTH 32
+
+/* Follow the frame chain from ebp, storing up to max return addresses in
+ * pcs. Stops at the first frame outside the kernel stack or with a return
+ * address outside .text; returns the number stored. */
+int backtrace_walk(uint32_t ebp, uint32_t *pcs, int max);
+
+/* Print eip and the chain above ebp, one "  #n 0xaddr func+0xoff" line
+ * per frame */
+void backtrace_print(uint32_t eip, uint32_t ebp);
+
+/* Print "func+0xoff" for addr (or just the address if unknown) */
+void backtrace_put_symbol(uint32_t addr);
+
+#endif /* _RODOS_BACKTRACE_H */
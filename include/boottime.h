@@ -0,0 +1,49 @@
+/*
+ * RO-DOS Boot Time Header
+ * TSC timestamps for each initialization phase, reported by BOOTTIME
+ *
+ * A mark records the end of a phase; its duration is the time since the
+ * previous mark. Marks are taken before the TSC is calibrated, so the raw
+ * counter is stored and converted when the report is printed. Without a
+ * TSC (clock_tsc() returns 0) nothing is recorded.
+ */
+
+#ifndef _RODOS_BOOTTIME_H
+#define _RODOS_BOOTTIME_H
+
+#include <stdint.h>
+
+/* Phase IDs in boot order. kernel.asm pushes the numeric values of the
+ * first block, keep its %defines in sync. */
+enum {
+    BOOT_ENTRY = 0,         /* .bss cleared and cpu_init done */
+    BOOT_INTERRUPTS,        /* init_interrupts */
+    BOOT_IO,                /* io_init */
+    BOOT_SERIAL,            /* serial_init */
+    BOOT_CLOCK,             /* clock_init (TSC calibration) */
+    BOOT_BANNER,            /* version banner */
+    BOOT_MEM,               /* pmm_init, mem_init and irqpool_init */
+    BOOT_PAGING,            /* paging_init */
+    BOOT_IRQ_ENABLE,        /* PIC unmask and sti */
+    BOOT_DELAY,             /* settle delay loop */
+    BOOT_SHELL,             /* shell_main entered */
+    BOOT_GUI_RESTORE,       /* gui_check_and_restore_screen */
+    BOOT_FS_RESET,          /* fs_init_commands clears the tables */
+    BOOT_FS_LOAD,           /* fs_load_from_disk */
+    BOOT_CMD_INIT,          /* rest of cmd_init */
+    BOOT_NETIF,             /* netif_init */
+    BOOT_WIFI,              /* wifi_autostart */
+    BOOT_PROMPT,            /* first prompt */
+    BOOT_PHASE_COUNT
+};
+
+/* Called once from kernel_entry right after cpu_init; takes the first
+ * mark */
+void boot_time_init(void);
+
+/* Record the end of phase. Only the first mark of each phase counts and
+ * nothing is recorded after BOOT_PROMPT, so re-running an init path later
+ * (FORMAT, GUI restore) leaves the boot record alone. */
+void boot_mark(uint32_t phase);
+
+#endif /* _RODOS_BOOTTIME_H */
@@ -0,0 +1,47 @@
+/*
+ * RO-DOS Clock Header
+ * Monotonic time from the TSC, calibrated against the PIT at boot
+ */
+
+#ifndef _RODOS_CLOCK_H
+#define _RODOS_CLOCK_H
+
+#include <stdint.h>
+
+/* Raw time stamp counter. Faults on a CPU without one; code that can run
+ * there uses clock_tsc() */
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* 18.2 Hz PIT tick counter (handlers.c) */
+uint32_t get_ticks(void);
+
+/* Calibrate the TSC against PIT channel 2. Called once from kernel.asm
+ * with interrupts disabled. */
+void clock_init(void);
+
+/* rdtsc(), or 0 before cpu_init and on CPUs without a TSC */
+uint64_t clock_tsc(void);
+
+/* TSC frequency in kHz (cycles per millisecond), 0 if uncalibrated */
+uint32_t clock_tsc_khz(void);
+
+/* TSC value at clock_init() - the zero point of clock_ns/us/ms */
+uint64_t clock_tsc_base(void);
+
+/* Monotonic time since clock_init(). Without a usable TSC these fall back
+ * to the PIT tick counter (~55 ms resolution). */
+uint64_t clock_ns(void);
+uint64_t clock_us(void);
+uint32_t clock_ms(void);
+
+/* Convert a TSC cycle delta to microseconds */
+uint64_t clock_cycles_to_us(uint64_t cycles);
+
+/* 64-by-32 unsigned division without libgcc; rem may be NULL */
+uint64_t clock_div64(uint64_t n, uint32_t d, uint32_t *rem);
+
+#endif /* _RODOS_CLOCK_H */
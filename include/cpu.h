@@ -0,0 +1,79 @@
+/*
+ * RO-DOS CPU Header
+ * CPUID feature detection and the boot-time kernel dispatch table
+ *
+ * cpu_init() reads CPUID once, turns on the FPU/SSE state (fpu.h) and
+ * then points cpu_ops at the fastest implementation of each hot kernel
+ * this CPU can run. Callers go through cpu_ops instead of testing feature
+ * bits themselves, so one image runs on anything from a 486 up without
+ * giving up SSE2 or SSE4.2 where they exist. Until cpu_init runs, cpu_ops
+ * holds the baseline versions, which work everywhere.
+ */
+
+#ifndef _RODOS_CPU_H
+#define _RODOS_CPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Feature bits for cpu_has() */
+#define CPU_FEAT_FPU     (1u << 0)
+#define CPU_FEAT_TSC     (1u << 1)
+#define CPU_FEAT_PSE     (1u << 2)
+#define CPU_FEAT_APIC    (1u << 3)
+#define CPU_FEAT_PAT     (1u << 4)
+#define CPU_FEAT_FXSR    (1u << 5)
+#define CPU_FEAT_SSE     (1u << 6)
+#define CPU_FEAT_SSE2    (1u << 7)
+#define CPU_FEAT_SSE42   (1u << 8)
+#define CPU_FEAT_RDRAND  (1u << 9)
+#define CPU_FEAT_INVTSC  (1u << 10)     /* TSC rate constant in all states */
+#define CPU_FEAT_CX8     (1u << 11)     /* cmpxchg8b; Pentium and later */
+#define CPU_FEAT_COUNT   12
+
+typedef struct {
+    char vendor[13];
+    char brand[49];         /* empty if the CPU has no brand string */
+    uint32_t family;
+    uint32_t model;
+    uint32_t stepping;
+    uint32_t features;      /* CPU_FEAT_* */
+} cpu_info_t;
+
+/* Hot kernels. memcpy and memset only call copy and fill for blocks of
+ * CPU_OPS_MIN_BYTES or more; blit and clear write to the framebuffer. */
+typedef struct {
+    void (*copy)(void *dest, const void *src, size_t n);
+    void (*fill)(void *dest, uint32_t pattern, size_t n);
+    void (*blit)(void *dest, const void *src, size_t n);
+    void (*clear)(void *dest, uint32_t pattern, size_t n);
+    uint16_t (*csum16)(const void *data, size_t len);
+    uint32_t (*crc32c)(uint32_t crc, const void *data, size_t len);
+    const char *mem_impl;   /* names for LSCPU */
+    const char *csum_impl;
+    const char *crc_impl;
+} cpu_ops_t;
+
+#define CPU_OPS_MIN_BYTES 256
+
+extern cpu_ops_t cpu_ops;
+
+/* Called once from kernel_entry, before interrupts are enabled */
+void cpu_init(void);
+
+const cpu_info_t *cpu_info(void);
+
+static inline bool cpu_has(uint32_t feat) {
+    return (cpu_info()->features & feat) == feat;
+}
+
+/* Short name of feature bit i (0..CPU_FEAT_COUNT-1), e.g. "SSE4.2" */
+const char *cpu_feature_name(uint32_t i);
+
+/* Baseline kernels (utils.c) */
+void mem_copy_rep(void *dest, const void *src, size_t n);
+void mem_fill_rep(void *dest, uint32_t pattern, size_t n);
+uint16_t mem_csum16(const void *data, size_t len);
+
+#endif /* _RODOS_CPU_H */
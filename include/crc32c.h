@@ -0,0 +1,23 @@
+/*
+ * RO-DOS CRC32C Header
+ * Castagnoli CRC (iSCSI, ext4, virtio) over a buffer
+ *
+ * crc32c() goes through cpu_ops, which uses the SSE4.2 crc32 instruction
+ * when the CPU has it and a table otherwise. Both give the same result.
+ */
+
+#ifndef _RODOS_CRC32C_H
+#define _RODOS_CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Standard CRC32C: pass 0 to start, or the previous result to continue
+ * over a following buffer. crc32c(0, "123456789", 9) == 0xE3069283. */
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+/* Raw kernels for cpu_ops: no pre/post inversion */
+uint32_t crc32c_sw(uint32_t crc, const void *data, size_t len);
+uint32_t crc32c_sse42(uint32_t crc, const void *data, size_t len);
+
+#endif /* _RODOS_CRC32C_H */
@@ -0,0 +1,54 @@
+/*
+ * RO-DOS DMA Memory Header
+ * Physically contiguous, aligned buffers for bus-mastering devices
+ *
+ * Memory is identity-mapped (paging.h), so the address a driver writes
+ * into a descriptor is the pointer itself; dma_phys() only documents the
+ * conversion. x86 keeps DMA coherent with the cache, so write-back RAM
+ * needs no flushing, only the usual barriers before notifying a device.
+ */
+
+#ifndef _RODOS_DMA_H
+#define _RODOS_DMA_H
+
+#include <stdint.h>
+
+/* Heap memory aligned to align (a power of two). Heap regions are single
+ * physical runs, so the result never crosses a gap. Free with
+ * kfree_aligned(), not kfree(). */
+void *kmalloc_aligned(uint32_t size, uint32_t align);
+void kfree_aligned(void *ptr);
+
+/* Whole zeroed pages straight from the page frame allocator, aligned to
+ * at least 4 KB (or align if larger). For rings and descriptor tables
+ * whose device addresses must be page frame numbers. */
+void *dma_alloc(uint32_t size, uint32_t align);
+void dma_free(void *ptr, uint32_t size);
+
+static inline uint32_t dma_phys(const void *ptr) {
+    return (uint32_t)ptr;
+}
+
+/* Recycling pool of equal-sized buffers carved from one dma_alloc block,
+ * e.g. packet buffers for a NIC queue. Buffers are cache-line aligned;
+ * get/put are O(1) and never touch the heap. */
+typedef struct {
+    void *base;
+    uint32_t block_size;        /* bytes reserved in base */
+    uint32_t buf_size;          /* rounded buffer stride */
+    uint32_t count;
+    uint32_t nfree;
+    void *free_list;            /* next pointer stored in each free buffer */
+} dma_pool_t;
+
+#define DMA_POOL_ALIGN 64
+
+/* 0 on success, -1 if the pages could not be allocated */
+int dma_pool_init(dma_pool_t *pool, uint32_t buf_size, uint32_t count);
+void dma_pool_destroy(dma_pool_t *pool);
+
+/* NULL when every buffer is handed out */
+void *dma_pool_get(dma_pool_t *pool);
+void dma_pool_put(dma_pool_t *pool, void *buf);
+
+#endif /* _RODOS_DMA_H */
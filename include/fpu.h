@@ -0,0 +1,26 @@
+/*
+ * RO-DOS FPU Header
+ * x87 and SSE state setup at boot
+ *
+ * fpu_init() turns on the FPU and, where the CPU has FXSAVE and SSE, sets
+ * CR4.OSFXSR so SSE instructions can run. C code is still built without
+ * SSE; only the kernels in simd.h use XMM registers. The interrupt and
+ * exception stubs FXSAVE/FXRSTOR around their handlers while fpu_fxsr is
+ * set, so a handler that copies memory cannot clobber the XMM registers of
+ * the code it interrupted. There are no tasks, so no other switch point
+ * needs saving.
+ */
+
+#ifndef _RODOS_FPU_H
+#define _RODOS_FPU_H
+
+#include <stdbool.h>
+
+/* Set by fpu_init; interrupt.asm reads fpu_fxsr as a byte */
+extern bool fpu_fxsr;       /* FXSAVE/FXRSTOR and SSE enabled */
+extern bool fpu_sse2;       /* simd.h kernels may be called */
+
+/* Called by cpu_init once the CPUID features are known */
+void fpu_init(void);
+
+#endif /* _RODOS_FPU_H */
@@ -0,0 +1,50 @@
+/*
+ * RO-DOS IRQ Pool Header
+ * Fixed-block allocator that is safe to call from interrupt handlers
+ *
+ * kmalloc walks and rewrites its free list with interrupts enabled, so an
+ * IRQ handler that allocates while the interrupted code is inside kmalloc
+ * corrupts the heap. The IRQ pool is separate memory taken from the frame
+ * allocator at boot, split into a few block sizes, each a lock-free stack
+ * updated with cmpxchg8b. Allocation never blocks and never grows: when a
+ * size class is exhausted it returns NULL and counts a failure. CPUs
+ * without cmpxchg8b (486 and older) get no pool at all.
+ */
+
+#ifndef _RODOS_IRQPOOL_H
+#define _RODOS_IRQPOOL_H
+
+#include <stdint.h>
+
+/* Size classes, smallest first. The largest holds a full Ethernet frame. */
+#define IRQPOOL_CLASSES     3
+#define IRQPOOL_MAX_BLOCK   2048
+
+/* Budget from the boot memory map: 1/256 of usable RAM, clamped */
+#define IRQPOOL_MIN_BYTES   (64 * 1024)
+#define IRQPOOL_MAX_BYTES   (1024 * 1024)
+
+typedef struct {
+    uint32_t block_size;
+    uint32_t count;         /* blocks in the class */
+    uint32_t in_use;
+    uint32_t high_water;    /* most blocks ever in use at once */
+    uint32_t failures;      /* allocations refused because it was empty */
+} irqpool_stats_t;
+
+/* Carve the pool from free frames. Call once after cpu_init and
+ * pmm_init, before interrupts are enabled. Does nothing without CX8. */
+void irqpool_init(void);
+
+/* Block of at least size bytes, or NULL if none is free, size exceeds
+ * IRQPOOL_MAX_BLOCK or the pool is disabled. Blocks are 64-byte aligned and not zeroed. */
+void *irqpool_alloc(uint32_t size);
+
+/* Pointers not from irqpool_alloc are ignored */
+void irqpool_free(void *ptr);
+
+/* 0 and *st filled for class 0..IRQPOOL_CLASSES-1, -1 otherwise,
+ * before irqpool_init or when the pool is disabled */
+int irqpool_stats(uint32_t cls, irqpool_stats_t *st);
+
+#endif /* _RODOS_IRQPOOL_H */
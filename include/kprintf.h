@@ -0,0 +1,34 @@
+/*
+ * RO-DOS Formatted Output Header
+ * printf-style formatting for kernel messages
+ *
+ * kprintf formats into a stack buffer and hands the result to the console
+ * in one c_write call, which moves the hardware cursor once instead of
+ * once per character.
+ *
+ * Conversions: %d %u %x %X %c %s %% plus
+ *   %ip   uint32_t IPv4 address in host order (IP_ADDR), as a.b.c.d
+ *   %mac  const uint8_t * to 6 bytes, as 52:54:00:12:34:56
+ * Flags and width: '-' left-aligns, '0' pads numbers with zeros, and a
+ * decimal width sets the minimum field size (e.g. %08X, %-11u).
+ */
+
+#ifndef _RODOS_KPRINTF_H
+#define _RODOS_KPRINTF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+/* Longest line one kprintf call prints; the rest is cut off */
+#define KPRINTF_MAX 256
+
+/* Like snprintf: writes at most size - 1 characters plus a terminator and
+ * returns the length the whole result would have had */
+int ksnprintf(char *buf, size_t size, const char *fmt, ...);
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+
+/* Returns the number of characters written to the console */
+int kprintf(const char *fmt, ...);
+
+#endif /* _RODOS_KPRINTF_H */
@@ -0,0 +1,44 @@
+/*
+ * RO-DOS String Header
+ * The kernel's one string library (src/utils.c)
+ *
+ * strlen, strchr, strcmp and memchr scan a 32-bit word at a time using
+ * the "has zero byte" trick, so they may read up to three bytes past the
+ * terminator, but never across a 4 KB page. strlcpy and stpcpy return the
+ * length they copied, so callers building paths need no second strlen.
+ *
+ * Unlike libc, every function accepts NULL: lengths are 0, searches fail,
+ * and strcmp orders NULL before any string.
+ */
+
+#ifndef _RODOS_KSTRING_H
+#define _RODOS_KSTRING_H
+
+#include <stddef.h>
+
+size_t strlen(const char *str);
+int strcmp(const char *s1, const char *s2);
+int strncmp(const char *s1, const char *s2, size_t n);
+char *strchr(const char *str, int c);
+char *strrchr(const char *str, int c);
+char *strstr(const char *haystack, const char *needle);
+void *memchr(const void *ptr, int value, size_t n);
+
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
+void *memset(void *ptr, int value, size_t n);
+int memcmp(const void *s1, const void *s2, size_t n);
+
+char *strcpy(char *dest, const char *src);
+char *strncpy(char *dest, const char *src, size_t n);
+char *strcat(char *dest, const char *src);
+
+/* Copy src into dest (size bytes, always terminated if size > 0); returns
+ * strlen(src), so a result >= size means src was truncated */
+size_t strlcpy(char *dest, const char *src, size_t size);
+
+/* Copy src including its terminator; returns a pointer to the terminator
+ * in dest, where the next piece can be appended */
+char *stpcpy(char *dest, const char *src);
+
+#endif /* _RODOS_KSTRING_H */
@@ -0,0 +1,33 @@
+/*
+ * RO-DOS Kernel Symbol Table Header
+ * Address-to-name lookup over the table embedded at link time
+ */
+
+#ifndef _RODOS_KSYMS_H
+#define _RODOS_KSYMS_H
+
+#include <stdint.h>
+
+/* Longest name ksym_name() returns, including the terminator */
+#define KSYM_NAME_MAX 64
+
+/* Number of symbols in the embedded table (0 if the build had none) */
+uint32_t ksym_total(void);
+
+/* Index of the function containing addr, or -1 if outside the table */
+int ksym_find(uint32_t addr);
+
+/* Name and start address of symbol idx. Names are stored compressed;
+ * ksym_name() decodes into a static buffer that the next call reuses. */
+const char *ksym_name(int idx);
+uint32_t ksym_addr(int idx);
+
+/* Decode the name of symbol idx into buf (truncated to size); returns
+ * its length */
+int ksym_name_copy(int idx, char *buf, uint32_t size);
+
+/* Name of the function containing addr (NULL if unknown); *offset is
+ * set to addr minus the function start when offset is non-NULL */
+const char *ksym_lookup(uint32_t addr, uint32_t *offset);
+
+#endif /* _RODOS_KSYMS_H */
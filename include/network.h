@@ -31,7 +31,8 @@ typedef struct network_interface {
 
 // IP address helpers
 #define IP_ADDR(a, b, c, d)                                                    \
-  ((uint32_t)(((a) << 24) | ((b) << 16) | ((c) << 8) | (d)))
+  (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) |      \
+   (uint32_t)(d))
 #define IP_A(ip) (((ip) >> 24) & 0xFF)
 #define IP_B(ip) (((ip) >> 16) & 0xFF)
 #define IP_C(ip) (((ip) >> 8) & 0xFF)
@@ -50,6 +51,9 @@ int ip_init(void);
 int ip_send(uint32_t dest_ip, uint8_t protocol, const uint8_t *data,
             uint32_t len);
 int ip_receive(uint8_t *buffer, uint32_t len);
+uint16_t ip_checksum(const void *data, int len);
+uint16_t tcp_checksum(uint32_t src_ip, uint32_t dest_ip, const void *data,
+                      uint16_t len);
 
 // DHCP functions
 int dhcp_init(network_interface_t *iface);
@@ -0,0 +1,41 @@
+/*
+ * RO-DOS Paging Header
+ * Identity-mapped paging: 4 MB pages for RAM, 4 KB pages for MMIO
+ *
+ * Virtual addresses equal physical ones, so pointers taken before
+ * paging_init() stay valid. RAM up to the top of the page allocator is
+ * covered by 4 MB PSE pages. Device memory (framebuffers, BARs) must be
+ * mapped with paging_map() before use; a 4 MB page is split into a page
+ * table when part of it needs different attributes or is unmapped.
+ */
+
+#ifndef _RODOS_PAGING_H
+#define _RODOS_PAGING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PAGE_SIZE_4K 0x1000
+#define PAGE_SIZE_4M 0x400000
+
+/* Caching attributes. WC needs PAT; without it WC falls back to
+ * write-through. */
+#define PAGE_CACHE_WB 0     /* normal RAM */
+#define PAGE_CACHE_WC 1     /* framebuffers */
+#define PAGE_CACHE_UC 2     /* device registers */
+
+/* Build the page directory and turn paging on. Needs pmm_init(); if no
+ * frames are left for page tables the kernel keeps running unpaged. */
+void paging_init(void);
+
+bool paging_enabled(void);
+
+/* Identity-map [addr, addr + size) with the given caching attribute,
+ * rounded out to 4 KB. Returns 0, or -1 if a page table could not be
+ * allocated. */
+int paging_map(uint32_t addr, uint32_t size, uint32_t cache);
+
+/* Remove [addr, addr + size) from the map; later accesses fault */
+void paging_unmap(uint32_t addr, uint32_t size);
+
+#endif /* _RODOS_PAGING_H */
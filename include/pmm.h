@@ -0,0 +1,61 @@
+/*
+ * RO-DOS Physical Memory Header
+ * BIOS E820 memory map and the page frame allocator built on it
+ *
+ * bootload.asm stores the E820 map at E820_MAP_ADDR before entering
+ * protected mode: a 32-bit entry count followed by the raw 24-byte
+ * entries. pmm_init() turns the usable ranges above PMM_BASE into a
+ * bitmap of 4 KB frames; everything below it (BIOS data, the loaded
+ * image, the stack and .bss) is never handed out.
+ */
+
+#ifndef _RODOS_PMM_H
+#define _RODOS_PMM_H
+
+#include <stdint.h>
+
+#define PMM_PAGE_SIZE     4096
+#define PMM_BASE          0x00200000    /* lowest address the allocator owns */
+
+/* Written by bootload.asm - keep in sync with E820_MAP / E820_MAX there */
+#define E820_MAP_ADDR     0x8000
+#define E820_MAX_ENTRIES  32
+
+/* E820 range types */
+#define E820_USABLE       1
+#define E820_RESERVED     2
+#define E820_ACPI         3
+#define E820_NVS          4
+#define E820_BAD          5
+
+typedef struct {
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;
+    uint32_t acpi;          /* ACPI 3.0 extended attributes */
+} __attribute__((packed)) e820_entry_t;
+
+/* Build the frame bitmap from the boot memory map. Without a map (BIOS
+ * lacks E820) the 16 MB above PMM_BASE is assumed, as before. */
+void pmm_init(void);
+
+/* Physically contiguous run of count frames; returns its address or 0 */
+uint32_t pmm_alloc_pages(uint32_t count);
+void pmm_free_pages(uint32_t addr, uint32_t count);
+
+/* Frames managed by the allocator and frames currently free */
+uint32_t pmm_total_pages(void);
+uint32_t pmm_free_page_count(void);
+
+/* End of the highest usable frame (what paging maps as RAM) */
+uint32_t pmm_top(void);
+
+/* The boot memory map; *count receives the number of entries */
+const e820_entry_t *pmm_e820(uint32_t *count);
+
+/* Called by kmalloc when no heap block fits: adds a region of at least
+ * bytes (plus headers) to the heap. Returns 1 on success, 0 if out of
+ * physical memory. */
+int heap_grow(uint32_t bytes);
+
+#endif /* _RODOS_PMM_H */
@@ -0,0 +1,36 @@
+/*
+ * RO-DOS SIMD Header
+ * SSE2 versions of the bulk memory, framebuffer and checksum loops
+ *
+ * Only valid once fpu_sse2 (fpu.h) is set, so the rest of the kernel
+ * reaches them through cpu_ops (cpu.h) rather than directly. All kernels
+ * work in 64-byte blocks with 16-byte aligned stores and handle any
+ * length and alignment.
+ *
+ * Non-temporal (nt) stores bypass the cache. Use them for write-combined
+ * framebuffers and for buffers too big to stay cached anyway; they are
+ * ordered with sfence before returning.
+ */
+
+#ifndef _RODOS_SIMD_H
+#define _RODOS_SIMD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* memcpy / memset switch to non-temporal stores at this size */
+#define SIMD_NT_BYTES   (256 * 1024)
+
+void simd_copy(void *dest, const void *src, size_t n, bool nt);
+
+/* Fill n bytes with pattern repeated; byte i of dest gets byte (i & 3) of
+ * pattern (little-endian), so a 32-bit pixel or a byte * 0x01010101. */
+void simd_fill(void *dest, uint32_t pattern, size_t n, bool nt);
+
+/* Ones' complement sum of the 16-bit words of data in memory order, as
+ * ip_checksum adds them: folded to 16 bits, not inverted. An odd last
+ * byte is added as the low byte of a word. */
+uint16_t simd_csum16(const void *data, size_t len);
+
+#endif /* _RODOS_SIMD_H */
@@ -0,0 +1,82 @@
+/*
+ * RO-DOS Kernel Trace Header
+ * Leveled trace points recorded as binary events in an in-memory ring
+ *
+ * A trace point costs an RDTSC, one locked add and a few stores; the text
+ * is only produced when DMESG decodes the ring. Trace points above
+ * TRACE_LEVEL compile to nothing (build with -DTRACE_LEVEL=2 to keep only
+ * errors and warnings).
+ */
+
+#ifndef _RODOS_TRACE_H
+#define _RODOS_TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_LVL_ERR    1
+#define TRACE_LVL_WARN   2
+#define TRACE_LVL_INFO   3
+#define TRACE_LVL_DEBUG  4
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LVL_DEBUG
+#endif
+
+/* Event IDs - the decode format for each lives in trace.c */
+enum {
+    TR_NONE = 0,
+    TR_NETIF_TX,            /* len, result */
+    TR_NETIF_TX_BADARG,     /* len */
+    TR_NETIF_TX_NODRV,
+    TR_IP_ROUTE,            /* src ip, gateway */
+    TR_IP_RX_TCP,           /* src ip, len */
+    TR_UDP_RX,              /* src ip, src port, dst port, len */
+    TR_DHCP_RX,             /* len */
+    TR_DHCP_RESULT,         /* result */
+    TR_TCP_RX_SYN_SENT,     /* flags */
+    TR_TCP_SYNACK,          /* seq, ack */
+    TR_TCP_RX_DATA,         /* seq, len */
+    TR_EVENT_COUNT
+};
+
+/* Binary trace record - 32 bytes */
+typedef struct {
+    uint32_t seq;           /* Slot sequence + 1; 0 while being written */
+    uint16_t event;
+    uint8_t  level;
+    uint8_t  reserved;
+    uint64_t tsc;
+    uint32_t arg[4];
+} trace_record_t;
+
+void trace_emit(uint8_t level, uint16_t event, uint32_t a0, uint32_t a1,
+                uint32_t a2, uint32_t a3);
+
+#define TRACE(lvl, ev, a0, a1, a2, a3)                                   \
+    do {                                                                 \
+        if ((lvl) <= TRACE_LEVEL)                                        \
+            trace_emit((lvl), (ev), (uint32_t)(a0), (uint32_t)(a1),      \
+                       (uint32_t)(a2), (uint32_t)(a3));                  \
+    } while (0)
+
+#define TRACE_ERR(ev, a0, a1, a2, a3)   TRACE(TRACE_LVL_ERR, ev, a0, a1, a2, a3)
+#define TRACE_WARN(ev, a0, a1, a2, a3)  TRACE(TRACE_LVL_WARN, ev, a0, a1, a2, a3)
+#define TRACE_INFO(ev, a0, a1, a2, a3)  TRACE(TRACE_LVL_INFO, ev, a0, a1, a2, a3)
+#define TRACE_DEBUG(ev, a0, a1, a2, a3) TRACE(TRACE_LVL_DEBUG, ev, a0, a1, a2, a3)
+
+/* Decode the ring oldest-first, one line per record, via out() */
+void trace_dump(void (*out)(const char *line, void *ctx), void *ctx);
+
+/* Format one record as text (no newline); returns length */
+int trace_format(const trace_record_t *rec, char *buf, int size);
+
+/* Copy record i of the current window (0 = oldest); returns 0 if valid */
+int trace_get(uint32_t i, trace_record_t *out);
+
+/* Number of records currently held, and total ever emitted */
+uint32_t trace_count(void);
+uint32_t trace_total(void);
+
+void trace_clear(void);
+
+#endif /* _RODOS_TRACE_H */
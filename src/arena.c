@@ -0,0 +1,88 @@
+/*
+ * RO-DOS Arena Allocator
+ * Chunk list management for include/arena.h
+ *
+ * The first chunk on the list is the one being bumped through. A request
+ * too large for a regular chunk gets a dedicated chunk linked behind it,
+ * so the space left in the current chunk is not abandoned.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/arena.h"
+
+extern void *kmalloc(uint32_t size);
+extern void kfree(void *ptr);
+
+struct arena_chunk {
+    arena_chunk_t *next;
+    uint32_t size;              /* payload bytes */
+    uint32_t top;               /* bytes in use */
+    uint32_t reserved;          /* keeps data 8-byte aligned on the kernel */
+    uint8_t data[];
+};
+
+#define ARENA_ALIGN 8
+
+static arena_chunk_t *arena_new_chunk(uint32_t size) {
+    arena_chunk_t *c = (arena_chunk_t *)kmalloc((uint32_t)sizeof(arena_chunk_t) + size);
+    if (!c) return NULL;
+    c->next = NULL;
+    c->size = size;
+    c->top = 0;
+    return c;
+}
+
+void *arena_alloc(arena_t *a, uint32_t size) {
+    if (size == 0 || size > 0x40000000) return NULL;
+    size = (size + ARENA_ALIGN - 1) & ~(uint32_t)(ARENA_ALIGN - 1);
+
+    arena_chunk_t *c = a->chunks;
+    if (!c || c->size - c->top < size) {
+        if (size > a->chunk_size) {
+            c = arena_new_chunk(size);
+            if (!c) return NULL;
+            if (a->chunks) {
+                c->next = a->chunks->next;
+                a->chunks->next = c;
+            } else {
+                a->chunks = c;
+            }
+        } else {
+            c = arena_new_chunk(a->chunk_size);
+            if (!c) return NULL;
+            c->next = a->chunks;
+            a->chunks = c;
+        }
+    }
+
+    void *p = c->data + c->top;
+    c->top += size;
+    a->used += size;
+    if (a->used > a->peak) a->peak = a->used;
+    return p;
+}
+
+void arena_reset(arena_t *a) {
+    arena_chunk_t *keep = NULL;
+    arena_chunk_t *c = a->chunks;
+    while (c) {
+        arena_chunk_t *next = c->next;
+        if (!keep && c->size == a->chunk_size) {
+            keep = c;
+            keep->next = NULL;
+            keep->top = 0;
+        } else {
+            kfree(c);
+        }
+        c = next;
+    }
+    a->chunks = keep;
+    a->used = 0;
+}
+
+void arena_release(arena_t *a) {
+    arena_reset(a);
+    if (a->chunks) kfree(a->chunks);
+    a->chunks = NULL;
+}
@@ -0,0 +1,113 @@
+/*
+ * BACKTRACE Command - Stack Unwinder
+ * Walks the EBP frame chain and resolves each return address against the
+ * embedded symbol table. Used by the exception handler, the profiler and
+ * the BACKTRACE command, which prints the shell's own call chain.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/ksyms.h"
+#include "../include/backtrace.h"
+
+extern void c_puts(const char *s);
+
+#define puts c_puts
+
+/* The stack starts at 0x90000 and grows down towards the end of the
+ * loaded image (kernel.asm, link.ld) */
+#define BACKTRACE_STACK_TOP 0x90000
+extern char __image_end[];
+
+/* Image load address and end of .text/.rodata (link.ld) */
+#define BACKTRACE_TEXT_START 0x10000
+extern char __text_end[];
+
+static bool bt_frame_ok(uint32_t ebp) {
+    return (ebp & 3) == 0 && ebp >= (uint32_t)__image_end &&
+           ebp + 8 <= BACKTRACE_STACK_TOP;
+}
+
+static bool bt_text_ok(uint32_t pc) {
+    return pc >= BACKTRACE_TEXT_START && pc < (uint32_t)__text_end;
+}
+
+int backtrace_walk(uint32_t ebp, uint32_t *pcs, int max) {
+    int n = 0;
+    while (n < max && bt_frame_ok(ebp)) {
+        const uint32_t *frame = (const uint32_t *)ebp;
+        uint32_t ret = frame[1];
+        if (!bt_text_ok(ret)) break;
+        pcs[n++] = ret;
+        /* The caller's frame is always higher up the stack */
+        if (frame[0] <= ebp) break;
+        ebp = frame[0];
+    }
+    return n;
+}
+
+/* Hex with a 0x prefix; width 8 zero-pads, 0 prints the minimum */
+static void bt_put_hex(uint32_t v, int width) {
+    static const char hex[] = "0123456789abcdef";
+    char buf[11];
+    int i = 10;
+    buf[i] = '\0';
+    do {
+        buf[--i] = hex[v & 0xF];
+        v >>= 4;
+    } while (v || 10 - i < width);
+    buf[--i] = 'x';
+    buf[--i] = '0';
+    puts(&buf[i]);
+}
+
+void backtrace_put_symbol(uint32_t addr) {
+    char name[KSYM_NAME_MAX];
+    int idx = ksym_find(addr);
+    if (idx < 0) {
+        bt_put_hex(addr, 8);
+        return;
+    }
+    ksym_name_copy(idx, name, sizeof(name));
+    puts(name);
+    puts("+");
+    bt_put_hex(addr - ksym_addr(idx), 0);
+}
+
+/* sym_addr is the address to resolve; for return addresses that is one
+ * byte back, inside the call, so calls to noreturn functions at the end
+ * of a function still resolve to the caller */
+static void bt_put_frame(uint32_t n, uint32_t pc, uint32_t sym_addr) {
+    char num[4];
+    int i = 0;
+    if (n >= 10) num[i++] = (char)('0' + n / 10);
+    num[i++] = (char)('0' + n % 10);
+    num[i] = '\0';
+    puts(n >= 10 ? "  #" : "  # ");
+    puts(num);
+    puts(" ");
+    bt_put_hex(pc, 8);
+    puts(" ");
+    backtrace_put_symbol(sym_addr);
+    puts("\n");
+}
+
+void backtrace_print(uint32_t eip, uint32_t ebp) {
+    uint32_t pcs[BACKTRACE_MAX_DEPTH];
+    int n = backtrace_walk(ebp, pcs, BACKTRACE_MAX_DEPTH);
+
+    bt_put_frame(0, eip, eip);
+    for (int i = 0; i < n; i++) bt_put_frame((uint32_t)i + 1, pcs[i], pcs[i] - 1);
+    if (ksym_total() == 0) puts("  (kernel has no symbol table)\n");
+}
+
+int cmd_backtrace(const char *args) {
+    (void)args;
+    uint32_t ebp = (uint32_t)__builtin_frame_address(0);
+    uint32_t eip;
+    __asm__ volatile ("call 1f\n1: pop %0" : "=r"(eip));
+    puts("Call stack:\n");
+    backtrace_print(eip, ebp);
+    return 0;
+}
@@ -14,6 +14,12 @@ org 0x7C00
 %define KERNEL_SECTORS 64
 %endif
 
+; BIOS memory map for the kernel - keep in sync with include/pmm.h
+%define E820_MAP          0x8000
+%define E820_MAX          32
+%define E820_ENTRY_SIZE   24
+%define SMAP              0x534D4150
+
 start:
     jmp short code_start
     nop
@@ -59,6 +65,8 @@ code_start:
     mov dword [0x9000], 0
     mov dword [0x9004], 0
     mov dword [0x9008], 0
+
+    call read_e820
     
     ; Enable A20
     in al, 0x92
@@ -137,6 +145,39 @@ read_sectors:
     popa
     ret
 
+; Collect the E820 map: entry count at E820_MAP, entries after it.
+; A BIOS without E820 leaves the count at 0.
+read_e820:
+    pushad
+    mov dword [E820_MAP], 0
+    mov di, E820_MAP + 4
+    xor ebx, ebx
+    xor bp, bp
+
+.next:
+    mov eax, 0xE820
+    mov edx, SMAP
+    mov ecx, E820_ENTRY_SIZE
+    mov dword [di + 20], 1      ; valid unless an ACPI 3.0 BIOS clears it
+    int 0x15
+    jc .done                    ; carry on the first call: no E820
+    cmp eax, SMAP
+    jne .done
+    jcxz .skip
+    inc bp
+    add di, E820_ENTRY_SIZE
+
+.skip:
+    test ebx, ebx               ; ebx = 0 after the last entry
+    jz .done
+    cmp bp, E820_MAX
+    jb .next
+
+.done:
+    mov [E820_MAP], bp
+    popad
+    ret
+
 ; GDT
 ALIGN 4
 gdt_start:
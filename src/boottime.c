@@ -0,0 +1,81 @@
+/*
+ * BOOTTIME Command - Boot Phase Timing
+ * Reports the TSC marks taken by kernel_entry and shell_main as a
+ * per-phase breakdown of the time from cpu_init to the first prompt.
+ *
+ *   Phase          Time ms      At ms
+ *   interrupts       0.012      0.131
+ *   ...
+ *   BOOTTIME total=<ms> ms to prompt
+ *
+ * Time before kernel_entry (BIOS, bootloader, floppy reads) is not
+ * visible to the kernel, and the TSC cannot be read before cpu_init has
+ * checked for it, so neither is included.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../include/clock.h"
+#include "../include/boottime.h"
+#include "../include/kprintf.h"
+
+extern void c_puts(const char *s);
+
+#define puts c_puts
+
+static uint64_t boot_tsc[BOOT_PHASE_COUNT];
+static bool boot_done = false;
+
+static const char *const boot_phase_names[BOOT_PHASE_COUNT] = {
+    "entry", "interrupts", "io", "serial", "clock", "banner", "mem",
+    "paging", "irq_enable", "delay", "shell", "gui_restore", "fs_reset",
+    "fs_load", "cmd_init", "netif", "wifi", "prompt",
+};
+
+void boot_time_init(void) {
+    boot_tsc[BOOT_ENTRY] = clock_tsc();
+}
+
+void boot_mark(uint32_t phase) {
+    if (boot_done || phase >= BOOT_PHASE_COUNT || boot_tsc[phase]) return;
+    boot_tsc[phase] = clock_tsc();
+    if (phase == BOOT_PROMPT) boot_done = true;
+}
+
+/* Microseconds as whole milliseconds plus the remaining microseconds,
+ * printed as "%u.%03u" (1234 -> "1.234") */
+static uint32_t boot_ms(uint64_t us, uint32_t *frac) {
+    return (uint32_t)clock_div64(us, 1000, frac);
+}
+
+int cmd_boottime(const char *args) {
+    (void)args;
+
+    if (!clock_tsc_khz()) {
+        puts("BOOTTIME: TSC not calibrated, no timings available\n");
+        return 1;
+    }
+
+    puts("  Phase          Time ms      At ms\n");
+    uint64_t entry = boot_tsc[BOOT_ENTRY];
+    uint64_t prev = entry;
+    for (uint32_t i = BOOT_ENTRY + 1; i < BOOT_PHASE_COUNT; i++) {
+        /* Phases skipped on this boot (GUI restore path) have no mark */
+        if (!boot_tsc[i]) continue;
+        uint32_t phase_frac, at_frac;
+        uint32_t phase_ms = boot_ms(clock_cycles_to_us(boot_tsc[i] - prev), &phase_frac);
+        uint32_t at_ms = boot_ms(clock_cycles_to_us(boot_tsc[i] - entry), &at_frac);
+        kprintf("  %-13s%6u.%03u%7u.%03u\n", boot_phase_names[i],
+                phase_ms, phase_frac, at_ms, at_frac);
+        prev = boot_tsc[i];
+    }
+
+    if (boot_done) {
+        uint32_t frac;
+        uint32_t ms = boot_ms(clock_cycles_to_us(boot_tsc[BOOT_PROMPT] - entry), &frac);
+        kprintf("BOOTTIME total=%u.%03u ms to prompt\n", ms, frac);
+    } else {
+        puts("BOOTTIME total=? (prompt not reached)\n");
+    }
+    return 0;
+}
@@ -0,0 +1,292 @@
+/*
+ * BENCH Command - Kernel Microbenchmark Suite
+ * Times the kernel's hot primitives against the TSC.
+ *
+ * Output is fixed and machine-readable, one line per benchmark:
+ *   BENCH-BEGIN tsc_khz=<n>
+ *   BENCH <name> iters=<n> bytes=<n> cycles=<total> per_iter=<n>
+ *   BENCH-END count=<n>
+ * Failed benchmarks print "BENCH-ERROR <name> <reason>" instead.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/network.h"
+#include "../include/clock.h"
+#include "../include/cpu.h"
+#include "../include/crc32c.h"
+
+extern void c_puts(const char *s);
+
+/* Primitives under test */
+extern void *memcpy(void *dest, const void *src, size_t n);
+extern void *memset(void *ptr, int value, size_t n);
+extern void *memmove(void *dest, const void *src, size_t n);
+extern void *kmalloc(uint32_t size);
+extern void kfree(void *ptr);
+extern int disk_read_lba(uint32_t lba, uint32_t count, void *buffer);
+extern int disk_write_lba(uint32_t lba, uint32_t count, void *buffer);
+extern void gpu_fill_rect(int x, int y, int w, int h, uint32_t color);
+extern int gpu_flush(void);
+
+#define puts c_puts
+
+/* Scratch sector for disk benchmarks - well past the FS area (LBA 499..2748) */
+#define BENCH_SCRATCH_LBA 8192
+
+/* Largest single buffer used by the memory benchmarks */
+#define BENCH_BUF_SIZE (64 * 1024)
+
+#define BENCH_HEAP_SLOTS 64
+
+static int bench_count = 0;
+
+static void bench_put_u64(uint64_t v) {
+    char buf[24];
+    int i = 23;
+    buf[i] = '\0';
+    if (v == 0) buf[--i] = '0';
+    while (v > 0) {
+        uint64_t q = clock_div64(v, 10, NULL);
+        buf[--i] = (char)('0' + (uint32_t)(v - q * 10));
+        v = q;
+    }
+    puts(&buf[i]);
+}
+
+static void bench_report(const char *name, uint32_t iters, uint32_t bytes,
+                         uint64_t cycles) {
+    puts("BENCH ");
+    puts(name);
+    puts(" iters=");
+    bench_put_u64(iters);
+    puts(" bytes=");
+    bench_put_u64(bytes);
+    puts(" cycles=");
+    bench_put_u64(cycles);
+    puts(" per_iter=");
+    bench_put_u64(iters ? clock_div64(cycles, iters, NULL) : 0);
+    puts("\n");
+    bench_count++;
+}
+
+static void bench_error(const char *name, const char *reason) {
+    puts("BENCH-ERROR ");
+    puts(name);
+    puts(" ");
+    puts(reason);
+    puts("\n");
+}
+
+/* memcpy / memset / memmove from utils.c */
+static void bench_mem(void) {
+    uint8_t *src = (uint8_t *)kmalloc(BENCH_BUF_SIZE + 64);
+    uint8_t *dst = (uint8_t *)kmalloc(BENCH_BUF_SIZE + 64);
+    if (!src || !dst) {
+        bench_error("mem", "nomem");
+        if (src) kfree(src);
+        if (dst) kfree(dst);
+        return;
+    }
+
+    static const struct { const char *name; uint32_t bytes; uint32_t iters; } copies[] = {
+        {"memcpy_64", 64, 4096},
+        {"memcpy_4k", 4096, 512},
+        {"memcpy_64k", BENCH_BUF_SIZE, 32},
+    };
+    for (unsigned c = 0; c < sizeof(copies) / sizeof(copies[0]); c++) {
+        uint64_t t0 = rdtsc();
+        for (uint32_t i = 0; i < copies[c].iters; i++) {
+            memcpy(dst, src, copies[c].bytes);
+        }
+        bench_report(copies[c].name, copies[c].iters, copies[c].bytes,
+                     rdtsc() - t0);
+    }
+
+    static const struct { const char *name; uint32_t bytes; uint32_t iters; } fills[] = {
+        {"memset_4k", 4096, 512},
+        {"memset_64k", BENCH_BUF_SIZE, 32},
+    };
+    for (unsigned c = 0; c < sizeof(fills) / sizeof(fills[0]); c++) {
+        uint64_t t0 = rdtsc();
+        for (uint32_t i = 0; i < fills[c].iters; i++) {
+            memset(dst, (int)i, fills[c].bytes);
+        }
+        bench_report(fills[c].name, fills[c].iters, fills[c].bytes,
+                     rdtsc() - t0);
+    }
+
+    /* Overlapping moves in both directions */
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < 512; i++) {
+        memmove(dst + 1, dst, 4096);
+    }
+    bench_report("memmove_4k_fwd_overlap", 512, 4096, rdtsc() - t0);
+
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < 512; i++) {
+        memmove(dst, dst + 1, 4096);
+    }
+    bench_report("memmove_4k_bwd_overlap", 512, 4096, rdtsc() - t0);
+
+    kfree(dst);
+    kfree(src);
+}
+
+/* kmalloc / kfree from memory.asm */
+static void bench_heap(void) {
+    static void *slots[BENCH_HEAP_SLOTS];
+
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < 2048; i++) {
+        void *p = kmalloc(64);
+        if (!p) {
+            bench_error("kmalloc_kfree_64", "nomem");
+            return;
+        }
+        kfree(p);
+    }
+    bench_report("kmalloc_kfree_64", 2048, 64, rdtsc() - t0);
+
+    /* Mixed-size churn: fill all slots, free odd slots, refill, free all */
+    uint32_t rounds = 32;
+    t0 = rdtsc();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (int i = 0; i < BENCH_HEAP_SLOTS; i++) {
+            slots[i] = kmalloc(16u << (i & 7));
+        }
+        for (int i = 1; i < BENCH_HEAP_SLOTS; i += 2) {
+            kfree(slots[i]);
+            slots[i] = kmalloc(24u << (i & 7));
+        }
+        for (int i = 0; i < BENCH_HEAP_SLOTS; i++) {
+            if (slots[i]) kfree(slots[i]);
+            slots[i] = NULL;
+        }
+    }
+    bench_report("kmalloc_churn_mixed", rounds, 0, rdtsc() - t0);
+}
+
+/* ip_checksum / tcp_checksum from tcp_ip_stack.c, crc32c from crc32c.c */
+static void bench_net(void) {
+    static uint8_t pkt[1500];
+    for (int i = 0; i < 1500; i++) pkt[i] = (uint8_t)(i * 7);
+
+    volatile uint16_t sink = 0;
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < 4096; i++) {
+        sink ^= ip_checksum(pkt, 20);
+    }
+    bench_report("ip_checksum_20", 4096, 20, rdtsc() - t0);
+
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < 512; i++) {
+        sink ^= ip_checksum(pkt, 1500);
+    }
+    bench_report("ip_checksum_1500", 512, 1500, rdtsc() - t0);
+
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < 512; i++) {
+        sink ^= tcp_checksum(IP_ADDR(10, 0, 2, 15), IP_ADDR(10, 0, 2, 2), pkt, 1480);
+    }
+    bench_report("tcp_checksum_1480", 512, 1480, rdtsc() - t0);
+    (void)sink;
+
+    volatile uint32_t crc = 0;
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < 512; i++) {
+        crc ^= crc32c(0, pkt, 1500);
+    }
+    bench_report("crc32c_1500", 512, 1500, rdtsc() - t0);
+    (void)crc;
+}
+
+/* disk_read_lba / disk_write_lba from handlers.c (non-destructive) */
+static void bench_disk(void) {
+    static uint8_t sector[512];
+
+    if (disk_read_lba(BENCH_SCRATCH_LBA, 1, sector) != 0) {
+        bench_error("disk", "no_disk");
+        return;
+    }
+
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < 32; i++) {
+        if (disk_read_lba(BENCH_SCRATCH_LBA, 1, sector) != 0) {
+            bench_error("disk_read_1", "io");
+            return;
+        }
+    }
+    bench_report("disk_read_1", 32, 512, rdtsc() - t0);
+
+    /* Write the sector back unchanged */
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < 8; i++) {
+        if (disk_write_lba(BENCH_SCRATCH_LBA, 1, sector) != 0) {
+            bench_error("disk_write_1", "io");
+            return;
+        }
+    }
+    bench_report("disk_write_1", 8, 512, rdtsc() - t0);
+}
+
+/* gpu_fill_rect / gpu_flush from drivers/vbe_graphics.c */
+static void bench_gpu(void) {
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < 64; i++) {
+        gpu_fill_rect(0, 0, 100, 100, 0x00336699 + i);
+    }
+    bench_report("gpu_fill_rect_100x100", 64, 100 * 100 * 4, rdtsc() - t0);
+
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < 8; i++) {
+        gpu_flush();
+    }
+    bench_report("gpu_flush", 8, 0, rdtsc() - t0);
+}
+
+static bool bench_arg_has(const char *args, const char *word) {
+    for (const char *p = args; *p; p++) {
+        int i = 0;
+        while (word[i] && p[i] == word[i]) i++;
+        if (!word[i] && (p[i] == '\0' || p[i] == ' ')) return true;
+    }
+    return false;
+}
+
+/*
+ * BENCH [MEM] [HEAP] [NET] [DISK] [GPU] [ALL]
+ * With no arguments runs every suite except GPU, which draws into the
+ * active graphics target and is only meaningful from a GUI session.
+ */
+int cmd_bench(const char *args) {
+    bool all = bench_arg_has(args, "ALL");
+    bool any = bench_arg_has(args, "MEM") || bench_arg_has(args, "HEAP") ||
+               bench_arg_has(args, "NET") || bench_arg_has(args, "DISK") ||
+               bench_arg_has(args, "GPU");
+    bool def = !all && !any;
+
+    bench_count = 0;
+    puts("BENCH-BEGIN tsc_khz=");
+    bench_put_u64(clock_tsc_khz());
+    puts("\n");
+
+    /* Every benchmark is timed with rdtsc, which faults without a TSC */
+    if (!cpu_has(CPU_FEAT_TSC)) {
+        bench_error("all", "no TSC");
+        puts("BENCH-END count=0\n");
+        return 1;
+    }
+
+    if (all || def || bench_arg_has(args, "MEM")) bench_mem();
+    if (all || def || bench_arg_has(args, "HEAP")) bench_heap();
+    if (all || def || bench_arg_has(args, "NET")) bench_net();
+    if (all || def || bench_arg_has(args, "DISK")) bench_disk();
+    if (all || bench_arg_has(args, "GPU")) bench_gpu();
+
+    puts("BENCH-END count=");
+    bench_put_u64(bench_count);
+    puts("\n");
+    return 0;
+}
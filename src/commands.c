@@ -1,4 +1,12 @@
 #include "../include/network.h"
+#include "../include/trace.h"
+#include "../include/boottime.h"
+#include "../include/pmm.h"
+#include "../include/arena.h"
+#include "../include/irqpool.h"
+#include "../include/cpu.h"
+#include "../include/kstring.h"
+#include "../include/kprintf.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -12,6 +20,8 @@ extern void set_attr(uint8_t a);
 extern void sys_reboot(void);
 extern void sys_shutdown(void);
 extern uint32_t get_ticks(void);
+extern uint32_t clock_ms(void);
+extern uint32_t clock_tsc_khz(void);
 extern void sys_beep(uint32_t freq, uint32_t duration);
 extern void sleep_ms(uint32_t ms);
 
@@ -27,6 +37,15 @@ extern int fs_list_root(uint32_t out_dir_buffer, uint32_t max_entries);
 extern void mem_get_stats(uint32_t *stats);
 extern void *kmalloc(uint32_t size);
 extern void kfree(void *ptr);
+extern void *krealloc(void *ptr, uint32_t size);
+
+/* Per-command scratch memory, reset when the outermost command returns
+ * (cmd_dispatch). Use it instead of big stack arrays and kmalloc/kfree
+ * pairs whose lifetime is a single command. */
+static arena_t cmd_arena = ARENA_INIT(8192);
+static int cmd_depth = 0;
+
+static void *cmd_scratch(uint32_t size) { return arena_alloc(&cmd_arena, size); }
 
 /* System call functions (from syscall.c) */
 extern int sys_get_time(uint8_t *hours, uint8_t *minutes, uint8_t *seconds);
@@ -87,35 +106,33 @@ static ProcessEntry process_table[MAX_PROCESSES];
 static int process_count = 0;
 
 /* Initialize processes if empty */
-static void str_copy(char *dst, const char *src, int max);
-
 static void ensure_processes_init(void) {
   if (process_count == 0) {
     /* Kernel (PID 1) */
     process_table[0].pid = 1;
-    str_copy(process_table[0].name, "KERNEL", 32);
-    str_copy(process_table[0].state, "RUNNING", 16);
+    strlcpy(process_table[0].name, "KERNEL", 32);
+    strlcpy(process_table[0].state, "RUNNING", 16);
     process_table[0].mem_usage = 128; // 128K
     process_table[0].priority = 0; // High
     
     /* Shell (PID 2) */
     process_table[1].pid = 2;
-    str_copy(process_table[1].name, "SHELL", 32);
-    str_copy(process_table[1].state, "RUNNING", 16);
+    strlcpy(process_table[1].name, "SHELL", 32);
+    strlcpy(process_table[1].state, "RUNNING", 16);
     process_table[1].mem_usage = 64; // 64K
     process_table[1].priority = 10; // Normal
     
     /* Network Service (PID 3) */
     process_table[2].pid = 3;
-    str_copy(process_table[2].name, "NETSVC", 32);
-    str_copy(process_table[2].state, "SLEEPING", 16);
+    strlcpy(process_table[2].name, "NETSVC", 32);
+    strlcpy(process_table[2].state, "SLEEPING", 16);
     process_table[2].mem_usage = 32; // 32K
     process_table[2].priority = 10;
     
     /* Display Service (PID 4) */
     process_table[3].pid = 4;
-    str_copy(process_table[3].name, "DISPSVC", 32);
-    str_copy(process_table[3].state, "SLEEPING", 16);
+    strlcpy(process_table[3].name, "DISPSVC", 32);
+    strlcpy(process_table[3].state, "SLEEPING", 16);
     process_table[3].mem_usage = 48; // 48K
     process_table[3].priority = 15; // Low
     
@@ -124,39 +141,59 @@ static void ensure_processes_init(void) {
 }
 
 
-/* File content storage (simple buffer) */
+/* File content storage - each file's bytes are kept on the heap, sized
+ * to the content */
 
 #define MAX_FILE_SIZE 4096
 typedef struct {
   uint16_t file_idx;
   uint32_t size;
-  char data[MAX_FILE_SIZE];
+  uint32_t capacity;
+  char *data;
 } FileContent;
 
-static FileContent file_contents[64] = {0};
+static FileContent file_contents[64];
 static int file_content_count = 0;
 
-/* Utility Functions */
-static int str_len(const char *s) {
-  if (!s)
+/* Make slot c hold at least len bytes (capped at MAX_FILE_SIZE); data
+ * past the current size is undefined. Returns -1 if the heap is out. */
+static int fc_reserve(int c, uint32_t len) {
+  FileContent *fc = &file_contents[c];
+  if (len > MAX_FILE_SIZE)
+    len = MAX_FILE_SIZE;
+  if (len <= fc->capacity)
     return 0;
-  int l = 0;
-  while (s[l])
-    l++;
-  return l;
+  char *data = (char *)krealloc(fc->data, len);
+  if (!data)
+    return -1;
+  fc->data = data;
+  fc->capacity = len;
+  return 0;
 }
 
-static void str_copy(char *dst, const char *src, int max) {
-  int i = 0;
-  while (i < max - 1 && src[i]) {
-    dst[i] = src[i];
-    i++;
-  }
-  dst[i] = '\0';
+static void fc_release(int c) {
+  kfree(file_contents[c].data);
+  file_contents[c].data = NULL;
+  file_contents[c].capacity = 0;
+  file_contents[c].size = 0;
+}
+
+static void fc_release_all(void) {
+  for (int c = 0; c < 64; c++)
+    fc_release(c);
+  file_content_count = 0;
+}
+
+/* Utility Functions */
+
+/* current_dir + name into a 256-byte path buffer, truncated to fit */
+static void fs_full_path(char *out, const char *name) {
+  size_t dir_len = strlcpy(out, current_dir, 256);
+  if (dir_len < 255)
+    strlcpy(out + dir_len, name, 256 - dir_len);
 }
 
 /* Forward declarations */
-static int str_cmp(const char *a, const char *b);
 int cmd_dispatch(const char *line);
 
 /* Helper to save content to file system */
@@ -167,47 +204,28 @@ static int save_file_content(const char *filename, const char *data, int len) {
   // Convert filename to full path if not absolute
   char full_path[256];
   if (filename[1] != ':') { // Simple check for C: or similar
-    int dir_len = str_len(current_dir);
-    for (int k = 0; k < dir_len; k++)
-      full_path[k] = current_dir[k];
-
-    int name_len = str_len(filename);
-    for (int k = 0; k < name_len; k++)
-      full_path[dir_len + k] = filename[k];
-    full_path[dir_len + name_len] = '\0';
+    fs_full_path(full_path, filename);
   } else {
-    str_copy(full_path, filename, 256);
+    strlcpy(full_path, filename, 256);
   }
 
   // Check if file exists -> overwrite
   int idx = -1;
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, full_path) == 0) {
+    if (strcmp(fs_table[i].name, full_path) == 0) {
       idx = i;
       break;
     }
   }
 
-  if (idx == -1) {
-    // Create new
-    if (fs_count >= FS_MAX_FILES) {
-      puts("Error: Disk full\n");
-      return -1;
-    }
-    idx = fs_count++;
-    str_copy(fs_table[idx].name, full_path, FS_MAX_FILENAME);
-    fs_table[idx].type = 0; // File
-    fs_table[idx].attr = 0;
-    fs_table[idx].parent_idx = 0xFFFF; // Root
+  if (idx == -1 && fs_count >= FS_MAX_FILES) {
+    puts("Error: Disk full\n");
+    return -1;
   }
 
-  // Update size
-  fs_table[idx].size = len;
-
-  // Save content
-  // Find content slot
+  // Find content slot; a new file never has one
   int content_idx = -1;
-  for (int i = 0; i < file_content_count; i++) {
+  for (int i = 0; idx != -1 && i < file_content_count; i++) {
     if (file_contents[i].file_idx == idx) {
       content_idx = i;
       break;
@@ -219,41 +237,63 @@ static int save_file_content(const char *filename, const char *data, int len) {
       puts("Error: Content storage full\n");
       return -1;
     }
-    content_idx = file_content_count++;
-    file_contents[content_idx].file_idx = idx;
+    content_idx = file_content_count;
   }
 
-  // Copy data (truncate if too large)
+  // Reserve storage before touching the directory entry, so a failure
+  // leaves the table as it was (truncate if too large)
   if (len > MAX_FILE_SIZE)
     len = MAX_FILE_SIZE;
-  for (int k = 0; k < len; k++) {
-    file_contents[content_idx].data[k] = data[k];
+  if (fc_reserve(content_idx, len) != 0) {
+    puts("Error: Out of memory\n");
+    return -1;
+  }
+
+  if (idx == -1) {
+    // Create new
+    idx = fs_count++;
+    strlcpy(fs_table[idx].name, full_path, FS_MAX_FILENAME);
+    fs_table[idx].type = 0; // File
+    fs_table[idx].attr = 0;
+    fs_table[idx].parent_idx = 0xFFFF; // Root
   }
+
+  // Update size
+  fs_table[idx].size = len;
+
+  if (content_idx == file_content_count)
+    file_content_count++;
+  file_contents[content_idx].file_idx = idx;
+  memcpy(file_contents[content_idx].data, data, len);
   file_contents[content_idx].size = len;
 
   return 0;
 }
 
-static int str_cmp(const char *a, const char *b) {
-  if (!a || !b)
-    return -1;
-  while (*a && *b && *a == *b) {
-    a++;
-    b++;
+/* Remove fs_table[idx], its content slot, and renumber the content slots of
+ * the entries that shift down behind it */
+static void fs_remove_entry(int idx) {
+  for (int c = 0; c < file_content_count; c++) {
+    if (file_contents[c].file_idx == idx) {
+      fc_release(c);
+      file_content_count--;
+      if (c != file_content_count) {
+        file_contents[c] = file_contents[file_content_count];
+        file_contents[file_content_count].data = NULL;
+        file_contents[file_content_count].capacity = 0;
+      }
+      break;
+    }
+  }
+  for (int c = 0; c < file_content_count; c++) {
+    if (file_contents[c].file_idx > idx)
+      file_contents[c].file_idx--;
   }
-  return *a - *b;
-}
 
-static int str_ncmp(const char *a, const char *b, int n)
-    __attribute__((unused));
-static int str_ncmp(const char *a, const char *b, int n) {
-  if (!a || !b)
-    return -1;
-  for (int i = 0; i < n; i++) {
-    if (a[i] != b[i] || !a[i])
-      return a[i] - b[i];
+  for (int j = idx; j < fs_count - 1; j++) {
+    fs_table[j] = fs_table[j + 1];
   }
-  return 0;
+  fs_count--;
 }
 
 static void str_upper(char *s) {
@@ -322,8 +362,7 @@ static int fs_save_to_disk(void) {
   char sector[512];
 
   /* Save current directory first */
-  for (int j = 0; j < 512; j++)
-    sector[j] = 0;
+  memset(sector, 0, sizeof(sector));
   for (int j = 0; j < 256 && current_dir[j]; j++) {
     sector[j] = current_dir[j];
   }
@@ -333,8 +372,7 @@ static int fs_save_to_disk(void) {
 
   /* Save file table - save ALL files up to FS_MAX_FILES */
   for (int i = 0; i < fs_count && i < FS_MAX_FILES; i++) {
-    for (int j = 0; j < 512; j++)
-      sector[j] = 0;
+    memset(sector, 0, sizeof(sector));
     for (int j = 0; j < 64 && j < (int)sizeof(FSEntry); j++) {
       sector[j] = ((char *)&fs_table[i])[j];
     }
@@ -343,17 +381,15 @@ static int fs_save_to_disk(void) {
     }
   }
 
-  /* Clear remaining file slots - clear up to 64 entries */
-  for (int i = fs_count; i < 64; i++) {
-    for (int j = 0; j < 512; j++)
-      sector[j] = 0;
-    disk_write_lba(FS_DATA_START_LBA + i, 1, sector);
+  /* Terminate the table - the loader stops at the first empty slot */
+  if (fs_count < FS_MAX_FILES) {
+    memset(sector, 0, sizeof(sector));
+    disk_write_lba(FS_DATA_START_LBA + fs_count, 1, sector);
   }
 
   /* Save user table */
   for (int i = 0; i < user_count && i < FS_MAX_USERS; i++) {
-    for (int j = 0; j < 512; j++)
-      sector[j] = 0;
+    memset(sector, 0, sizeof(sector));
     for (int j = 0; j < 64 && j < (int)sizeof(UserEntry); j++) {
       sector[j] = ((char *)&user_table[i])[j];
     }
@@ -364,8 +400,7 @@ static int fs_save_to_disk(void) {
 
   /* Clear remaining user slots */
   for (int i = user_count; i < 5; i++) {
-    for (int j = 0; j < 512; j++)
-      sector[j] = 0;
+    memset(sector, 0, sizeof(sector));
     disk_write_lba(FS_DATA_START_LBA + 128 + i, 1, sector);
   }
 
@@ -382,8 +417,7 @@ static int fs_save_to_disk(void) {
     /* Write file content sectors */
     for (uint32_t s = 0; s < sectors_needed && s < 16; s++) {
       /* Zero sector buffer */
-      for (int j = 0; j < 512; j++)
-        sector[j] = 0;
+      memset(sector, 0, sizeof(sector));
 
       /* Calculate how much to copy for this sector */
       uint32_t offset = s * 512;
@@ -392,9 +426,7 @@ static int fs_save_to_disk(void) {
         to_copy = 512;
 
       /* Copy data to sector buffer */
-      for (uint32_t j = 0; j < to_copy; j++) {
-        sector[j] = file_contents[c].data[offset + j];
-      }
+      memcpy(sector, file_contents[c].data + offset, to_copy);
 
       /* Write sector to disk at the correct LBA for this file */
       uint32_t lba = FS_CONTENT_START_LBA + (file_idx * 16) + s;
@@ -405,8 +437,7 @@ static int fs_save_to_disk(void) {
 
     /* Clear remaining sectors for this file (if file shrunk) */
     for (uint32_t s = sectors_needed; s < 16; s++) {
-      for (int j = 0; j < 512; j++)
-        sector[j] = 0;
+      memset(sector, 0, sizeof(sector));
       uint32_t lba = FS_CONTENT_START_LBA + (file_idx * 16) + s;
       disk_write_lba(lba, 1, sector);
     }
@@ -432,9 +463,9 @@ static int fs_load_from_disk(void) {
     /* If not valid, keep default "C:\" */
   }
 
-  /* Load file table - read up to 64 entries */
+  /* Load file table */
   fs_count = 0;
-  for (int i = 0; i < 64 && i < FS_MAX_FILES; i++) {
+  for (int i = 0; i < FS_MAX_FILES; i++) {
     if (disk_read_lba(FS_DATA_START_LBA + i, 1, sector) == 0) {
       /* Check if this is a valid entry - first char of filename must not be 0 */
       if (sector[0] != 0) {
@@ -463,7 +494,7 @@ static int fs_load_from_disk(void) {
   }
 
   /* CRITICAL FIX: Load file contents properly */
-  file_content_count = 0;
+  fc_release_all();
 
   /* For each file in fs_table that has size > 0 */
   for (int i = 0; i < fs_count && file_content_count < 64; i++) {
@@ -473,29 +504,30 @@ static int fs_load_from_disk(void) {
       if (sectors_needed == 0)
         sectors_needed = 1;
 
-      /* Set up file_contents entry */
+      /* Set up file_contents entry, holding no more than was stored */
+      uint32_t size = fs_table[i].size;
+      if (size > MAX_FILE_SIZE)
+        size = MAX_FILE_SIZE;
       file_contents[file_content_count].file_idx = i;
-      file_contents[file_content_count].size = fs_table[i].size;
-
-      /* Zero out the entire data buffer first */
-      for (int z = 0; z < MAX_FILE_SIZE; z++) {
-        file_contents[file_content_count].data[z] = 0;
-      }
+      if (fc_reserve(file_content_count, size) != 0)
+        break;
 
-      /* Read content from disk - using file_idx i */
+      /* Read content from disk - using file_idx i; sectors that fail
+       * to read come back as zeros */
       uint32_t total_read = 0;
-      for (uint32_t s = 0; s < sectors_needed && s < 16; s++) {
+      for (uint32_t s = 0; s < sectors_needed && total_read < size; s++) {
         uint32_t lba = FS_CONTENT_START_LBA + (i * 16) + s;
-        if (disk_read_lba(lba, 1, sector) == 0) {
-          uint32_t to_copy = fs_table[i].size - total_read;
-          if (to_copy > 512)
-            to_copy = 512;
-
-          for (uint32_t j = 0; j < to_copy && total_read < MAX_FILE_SIZE; j++) {
-            file_contents[file_content_count].data[total_read++] = sector[j];
-          }
-        }
+        uint32_t to_copy = size - total_read;
+        if (to_copy > 512)
+          to_copy = 512;
+        char *dst = file_contents[file_content_count].data + total_read;
+        if (disk_read_lba(lba, 1, sector) == 0)
+          memcpy(dst, sector, to_copy);
+        else
+          memset(dst, 0, to_copy);
+        total_read += to_copy;
       }
+      file_contents[file_content_count].size = size;
 
       file_content_count++;
     }
@@ -512,41 +544,28 @@ static void fs_init_commands(void) {
   fs_count = 0;
   user_count = 0;
 
-  /* CRITICAL: Zero out file_content_count and the entire array! */
-  file_content_count = 0;
-  for (int i = 0; i < 64; i++) {
-    file_contents[i].file_idx = 0;
-    file_contents[i].size = 0;
-    for (int j = 0; j < MAX_FILE_SIZE; j++) {
-      file_contents[i].data[j] = 0;
-    }
-  }
+  /* Contents are allocated as files are loaded; drop any earlier ones */
+  fc_release_all();
+
+  boot_mark(BOOT_FS_RESET);
 
   /* Load from disk - this will update the counters */
   fs_load_from_disk();
+  boot_mark(BOOT_FS_LOAD);
 
   /* Only print messages if not silent */
   if (!fs_init_silent) {
     /* Verify file_content_count is correct */
-    char buf[16];
-    puts("[INIT: file_content_count=");
-    int_to_str(file_content_count, buf);
-    puts(buf);
-    puts("]\n");
+    kprintf("[INIT: file_content_count=%d]\n", file_content_count);
 
     /* Print initialization message */
-    puts("Ready. ");
-    int_to_str(fs_count, buf);
-    puts(buf);
-    puts(" files, ");
-    int_to_str(file_content_count, buf);
-    puts(buf);
-    puts(" contents loaded. Type HELP for commands.\n");
+    kprintf("Ready. %d files, %d contents loaded. Type HELP for commands.\n",
+            fs_count, file_content_count);
   }
 
   /* If no users, create default root user */
   if (user_count == 0) {
-    str_copy(user_table[0].username, "root", 32);
+    strlcpy(user_table[0].username, "root", 32);
     uint32_t h = hash_string("root");
     for (int i = 0; i < 32; i++) {
       user_table[0].password_hash[i] = (char)((h >> (i % 4 * 8)) & 0xFF);
@@ -577,6 +596,27 @@ static const char *get_token(const char *s, char *token, int max) {
 /* Forward declaration for NETMODE command (defined in cmd_netmode.c) */
 extern int cmd_netmode(const char *args);
 
+/* BENCH microbenchmark suite (defined in cmd_bench.c) */
+extern int cmd_bench(const char *args);
+
+/* PROFILE sampling profiler (defined in profile.c) */
+extern int cmd_profile(const char *args);
+
+/* BOOTTIME boot phase report (defined in boottime.c) */
+extern int cmd_boottime(const char *args);
+
+/* BACKTRACE stack unwinder (defined in backtrace.c) */
+extern int cmd_backtrace(const char *args);
+
+/* MEM /TOP and /LEAKS heap profiler (defined in heapprof.c) */
+extern int heapprof_top(const char *args);
+extern int heapprof_leaks(const char *args);
+
+/* COM1 serial console (drivers/serial.c) */
+extern bool serial_present(void);
+extern void serial_set_mirror(bool on);
+extern bool serial_get_mirror(void);
+
 /* Rust WiFi Driver functions */
 extern int wifi_driver_init(void);
 extern int wifi_driver_test(void);
@@ -683,7 +723,7 @@ static int cmd_calc_gui(const char *args) {
   /* Helper function to process a button press */
   #define PROCESS_BUTTON(btn_char) do { \
     char bc = (btn_char); \
-    int display_len = str_len(display); \
+    int display_len = (int)strlen(display); \
     if (bc == 'C') { \
       display[0] = '0'; display[1] = '\0'; \
       stored_value = 0; current_value = 0; operation = 0; new_number = true; \
@@ -879,9 +919,7 @@ static int cmd_netstart(const char *args) {
   puts("[1/3] Initializing Rust WiFi driver...\n");
   
   int result = wifi_driver_init();
-  puts("[NETSTART] wifi_driver_init returned: ");
-  putc('0' + (result & 0xF));
-  puts("\n");
+  kprintf("[NETSTART] wifi_driver_init returned: %d\n", result);
   
   if (result != 0) {
     set_attr(0x0C); // Red
@@ -924,16 +962,12 @@ static int cmd_netstart(const char *args) {
   for (int attempt = 0; attempt < 3; attempt++) {
     
     if (attempt > 0) {
-      puts("Retry ");
-      putc('0' + attempt);
-      puts("/3...\n");
+      kprintf("Retry %d/3...\n", attempt);
     }
     
     puts("[DEBUG] NETSTART: Calling dhcp_discover...\n");
     int disc_result = dhcp_discover(iface);
-    puts("[DEBUG] NETSTART: dhcp_discover returned: ");
-    putc('0' + (disc_result & 0xF));
-    puts("\n");
+    kprintf("[DEBUG] NETSTART: dhcp_discover returned: %d\n", disc_result);
     
     if (disc_result < 0) {
       puts("Failed to send DHCP DISCOVER\n");
@@ -943,11 +977,11 @@ static int cmd_netstart(const char *args) {
     puts("[DEBUG] NETSTART: Waiting for DHCP response...\n");
     
     // Wait for DHCP response
-    uint32_t start = get_ticks();
+    uint32_t start = clock_ms();
     bool got_ip = false;
     int poll_count = 0;
     
-    while (get_ticks() - start < 90) { // ~5 seconds
+    while (clock_ms() - start < 5000) { // 5 seconds
       // Poll for DHCP response
       for (int i = 0; i < 20; i++) {
         netif_poll();
@@ -956,29 +990,13 @@ static int cmd_netstart(const char *args) {
       
       // Check if we got an IP
       if (iface->ip_addr != 0) {
-        puts("[DEBUG] NETSTART: Got IP address after ");
-        char cnt[8];
-        cnt[0] = '0' + (poll_count / 1000) % 10;
-        cnt[1] = '0' + (poll_count / 100) % 10;
-        cnt[2] = '0' + (poll_count / 10) % 10;
-        cnt[3] = '0' + poll_count % 10;
-        cnt[4] = '\0';
-        puts(cnt);
-        puts(" polls\n");
+        kprintf("[DEBUG] NETSTART: Got IP address after %d polls\n", poll_count);
         got_ip = true;
         break;
       }
     }
     
-    puts("[DEBUG] NETSTART: Finished waiting. poll_count=");
-    char cnt[8];
-    cnt[0] = '0' + (poll_count / 1000) % 10;
-    cnt[1] = '0' + (poll_count / 100) % 10;
-    cnt[2] = '0' + (poll_count / 10) % 10;
-    cnt[3] = '0' + poll_count % 10;
-    cnt[4] = '\0';
-    puts(cnt);
-    puts("\n");
+    kprintf("[DEBUG] NETSTART: Finished waiting. poll_count=%d\n", poll_count);
     
     if (got_ip) {
       set_attr(0x0A); // Green
@@ -986,36 +1004,9 @@ static int cmd_netstart(const char *args) {
       set_attr(0x07);
       
       // Show IP info
-      puts("IP Address:  ");
-      char buf[16];
-      int_to_str((iface->ip_addr >> 24) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str((iface->ip_addr >> 16) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str((iface->ip_addr >> 8) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str(iface->ip_addr & 0xFF, buf);
-      puts(buf); puts("\n");
-      
-      puts("Gateway:     ");
-      int_to_str((iface->gateway >> 24) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str((iface->gateway >> 16) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str((iface->gateway >> 8) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str(iface->gateway & 0xFF, buf);
-      puts(buf); puts("\n");
-      
-      puts("DNS Server:  ");
-      int_to_str((iface->dns_server >> 24) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str((iface->dns_server >> 16) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str((iface->dns_server >> 8) & 0xFF, buf);
-      puts(buf); puts(".");
-      int_to_str(iface->dns_server & 0xFF, buf);
-      puts(buf); puts("\n\n");
+      kprintf("IP Address:  %ip\n", iface->ip_addr);
+      kprintf("Gateway:     %ip\n", iface->gateway);
+      kprintf("DNS Server:  %ip\n\n", iface->dns_server);
       
       set_attr(0x0E);
       puts("Network ready! You can now use WGET, PING, etc.\n");
@@ -1041,10 +1032,11 @@ static int cmd_help(const char *args) {
        "FIND\n");
   puts("  Disk: CHKDSK FORMAT LABEL VOL DISKPART FSCK\n");
   puts("  Info: VER TIME DATE UPTIME MEM SYSINFO UNAME WHOAMI HOSTNAME\n");
+  puts("  Perf: BENCH PROFILE BOOTTIME BACKTRACE\n");
   puts("  User: USERADD USERDEL PASSWD USERS LOGIN LOGOUT SU SUDO\n");
   puts("  Proc: PS KILL TOP TASKLIST TASKKILL\n");
   puts("  Misc: CLS CLEAR COLOR ECHO BEEP CALC HEXDUMP ASCII HASH\n");
-  puts("  Ctrl: REBOOT SHUTDOWN HALT PAUSE SLEEP EXIT\n");
+  puts("  Ctrl: REBOOT SHUTDOWN HALT PAUSE SLEEP EXIT SERIAL\n");
   puts("  Network: NETSTART IPCONFIG PING WGET WIFITEST\n");
   puts("  Graphics: GUITEST CALC-GUI NOTEPAD PAINT FILEBROWSER CLOCK\n");
   puts("  Programming: PYTHON (Mini Python interpreter)\n");
@@ -1073,20 +1065,7 @@ static int cmd_time(const char *args) {
   (void)args;
   uint8_t h, m, s;
   if (sys_get_time(&h, &m, &s) == 0) {
-    char buf[16];
-    int_to_str(h, buf);
-    puts(buf);
-    puts(":");
-    if (m < 10)
-      puts("0");
-    int_to_str(m, buf);
-    puts(buf);
-    puts(":");
-    if (s < 10)
-      puts("0");
-    int_to_str(s, buf);
-    puts(buf);
-    puts("\n");
+    kprintf("%u:%02u:%02u\n", h, m, s);
   }
   return 0;
 }
@@ -1097,20 +1076,7 @@ static int cmd_date(const char *args) {
   uint8_t day, month;
   uint16_t year;
   if (sys_get_date(&day, &month, &year) == 0) {
-    char buf[16];
-    int_to_str(year, buf);
-    puts(buf);
-    puts("-");
-    if (month < 10)
-      puts("0");
-    int_to_str(month, buf);
-    puts(buf);
-    puts("-");
-    if (day < 10)
-      puts("0");
-    int_to_str(day, buf);
-    puts(buf);
-    puts("\n");
+    kprintf("%u-%02u-%02u\n", year, month, day);
   }
   return 0;
 }
@@ -1150,27 +1116,17 @@ static int cmd_mkdir(const char *args) {
 
   /* Build full path: current_dir + dirname */
   char full_path[256];
-  int dir_len = str_len(current_dir);
-  for (int i = 0; i < dir_len && i < 255; i++) {
-    full_path[i] = current_dir[i];
-  }
-
-  /* Add dirname */
-  int name_len = str_len(name);
-  for (int i = 0; i < name_len && (dir_len + i) < 255; i++) {
-    full_path[dir_len + i] = name[i];
-  }
-  full_path[dir_len + name_len] = '\0';
+  fs_full_path(full_path, name);
 
   /* Check if already exists */
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, full_path) == 0) {
+    if (strcmp(fs_table[i].name, full_path) == 0) {
       puts("Error: Already exists\n");
       return -1;
     }
   }
 
-  str_copy(fs_table[fs_count].name, full_path, FS_MAX_FILENAME);
+  strlcpy(fs_table[fs_count].name, full_path, FS_MAX_FILENAME);
   fs_table[fs_count].size = 0;
   fs_table[fs_count].type = 1;
   fs_table[fs_count].attr = 0x10;
@@ -1194,11 +1150,8 @@ static int cmd_rmdir(const char *args) {
   }
 
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, name) == 0 && fs_table[i].type == 1) {
-      for (int j = i; j < fs_count - 1; j++) {
-        fs_table[j] = fs_table[j + 1];
-      }
-      fs_count--;
+    if (strcmp(fs_table[i].name, name) == 0 && fs_table[i].type == 1) {
+      fs_remove_entry(i);
       fs_save_to_disk();
       puts("Directory removed\n");
       return 0;
@@ -1226,27 +1179,17 @@ static int cmd_touch(const char *args) {
 
   /* Build full path: current_dir + filename */
   char full_path[256];
-  int dir_len = str_len(current_dir);
-  for (int i = 0; i < dir_len && i < 255; i++) {
-    full_path[i] = current_dir[i];
-  }
-
-  /* Add filename */
-  int name_len = str_len(name);
-  for (int i = 0; i < name_len && (dir_len + i) < 255; i++) {
-    full_path[dir_len + i] = name[i];
-  }
-  full_path[dir_len + name_len] = '\0';
+  fs_full_path(full_path, name);
 
   /* Check if file already exists in this directory */
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, full_path) == 0) {
+    if (strcmp(fs_table[i].name, full_path) == 0) {
       puts("File already exists\n");
       return 0;
     }
   }
 
-  str_copy(fs_table[fs_count].name, full_path, FS_MAX_FILENAME);
+  strlcpy(fs_table[fs_count].name, full_path, FS_MAX_FILENAME);
   fs_table[fs_count].size = 0;
   fs_table[fs_count].type = 0;
   fs_table[fs_count].attr = 0x20;
@@ -1271,22 +1214,11 @@ static int cmd_del(const char *args) {
 
   /* Build full path */
   char full_path[256];
-  int dir_len = str_len(current_dir);
-  for (int i = 0; i < dir_len && i < 255; i++) {
-    full_path[i] = current_dir[i];
-  }
-  int name_len = str_len(name);
-  for (int i = 0; i < name_len && (dir_len + i) < 255; i++) {
-    full_path[dir_len + i] = name[i];
-  }
-  full_path[dir_len + name_len] = '\0';
+  fs_full_path(full_path, name);
 
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 0) {
-      for (int j = i; j < fs_count - 1; j++) {
-        fs_table[j] = fs_table[j + 1];
-      }
-      fs_count--;
+    if (strcmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 0) {
+      fs_remove_entry(i);
       fs_save_to_disk();
       puts("File deleted\n");
       return 0;
@@ -1309,68 +1241,31 @@ static int cmd_dir(const char *args) {
   int dir_count = 0;
   uint32_t total_size = 0;
 
-  int current_dir_len = str_len(current_dir);
+  int current_dir_len = (int)strlen(current_dir);
 
   for (int i = 0; i < fs_count; i++) {
-    /* Check if this entry is in the current directory */
-    bool in_current_dir = true;
-
-    /* Compare path prefix */
-    for (int j = 0; j < current_dir_len; j++) {
-      if (fs_table[i].name[j] != current_dir[j]) {
-        in_current_dir = false;
-        break;
-      }
-    }
-
-    /* Make sure there's no subdirectory after current path */
-    if (in_current_dir && fs_table[i].name[current_dir_len] != '\0') {
-      for (int j = current_dir_len; fs_table[i].name[j] != '\0'; j++) {
-        if (fs_table[i].name[j] == '\\') {
-          in_current_dir = false;
-          break;
-        }
-      }
-    } else if (in_current_dir && fs_table[i].name[current_dir_len] == '\0') {
-      /* This is the directory itself, skip it */
-      in_current_dir = false;
-    }
-
-    if (!in_current_dir)
+    /* Only direct children of the current directory: same prefix, a
+     * non-empty rest (not the directory itself), no deeper backslash */
+    const char *rest = fs_table[i].name + current_dir_len;
+    if (strncmp(fs_table[i].name, current_dir, current_dir_len) != 0 ||
+        rest[0] == '\0' || strchr(rest, '\\'))
       continue;
 
     /* Display the filename without the full path */
     char *display_name = fs_table[i].name + current_dir_len;
 
-    char buf[16];
-
     if (fs_table[i].type == 1) {
-      puts("<DIR>      ");
+      kprintf("<DIR>      %s\n", display_name);
       dir_count++;
     } else {
-      int_to_str(fs_table[i].size, buf);
-      puts(buf);
-      for (int j = str_len(buf); j < 11; j++)
-        puts(" ");
+      kprintf("%-11u%s\n", fs_table[i].size, display_name);
       file_count++;
       total_size += fs_table[i].size;
     }
-
-    puts(display_name);
-    puts("\n");
   }
 
-  puts("\n");
-  char buf[16];
-  int_to_str(file_count, buf);
-  puts(buf);
-  puts(" file(s), ");
-  int_to_str(dir_count, buf);
-  puts(buf);
-  puts(" dir(s), ");
-  int_to_str(total_size, buf);
-  puts(buf);
-  puts(" bytes\n");
+  kprintf("\n%d file(s), %d dir(s), %u bytes\n", file_count, dir_count,
+          total_size);
 
   return 0;
 }
@@ -1386,8 +1281,8 @@ static int cmd_cd(const char *args) {
     return 0;
   }
 
-  if (str_cmp(name, "..") == 0) {
-    int len = str_len(current_dir);
+  if (strcmp(name, "..") == 0) {
+    int len = (int)strlen(current_dir);
     if (len > 3) {
       for (int i = len - 2; i >= 0; i--) {
         if (current_dir[i] == '\\') {
@@ -1403,23 +1298,15 @@ static int cmd_cd(const char *args) {
 
   /* Build full path to check if directory exists */
   char full_path[256];
-  int dir_len = str_len(current_dir);
-  for (int i = 0; i < dir_len && i < 255; i++) {
-    full_path[i] = current_dir[i];
-  }
-  int name_len = str_len(name);
-  for (int i = 0; i < name_len && (dir_len + i) < 255; i++) {
-    full_path[dir_len + i] = name[i];
-  }
-  full_path[dir_len + name_len] = '\0';
+  fs_full_path(full_path, name);
 
   /* Check if this directory exists */
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 1) {
+    if (strcmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 1) {
       /* Directory exists, change to it */
-      str_copy(current_dir, full_path, 256);
+      strlcpy(current_dir, full_path, 256);
       /* Add trailing backslash if not present */
-      int len = str_len(current_dir);
+      int len = (int)strlen(current_dir);
       if (current_dir[len - 1] != '\\') {
         current_dir[len] = '\\';
         current_dir[len + 1] = '\0';
@@ -1446,20 +1333,12 @@ static int cmd_cat(const char *args) {
 
   /* Build full path */
   char full_path[256];
-  int dir_len = str_len(current_dir);
-  for (int i = 0; i < dir_len && i < 255; i++) {
-    full_path[i] = current_dir[i];
-  }
-  int name_len = str_len(name);
-  for (int i = 0; i < name_len && (dir_len + i) < 255; i++) {
-    full_path[dir_len + i] = name[i];
-  }
-  full_path[dir_len + name_len] = '\0';
+  fs_full_path(full_path, name);
 
   /* Find file in fs_table */
   int file_idx = -1;
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 0) {
+    if (strcmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 0) {
       file_idx = i;
       break;
     }
@@ -1476,14 +1355,8 @@ static int cmd_cat(const char *args) {
     return 0;
   }
 
-  char tmp[16];
-  puts("Looking for file_idx=");
-  int_to_str(file_idx, tmp);
-  puts(tmp);
-  puts(" in file_content_count=");
-  int_to_str(file_content_count, tmp);
-  puts(tmp);
-  puts("\n");
+  kprintf("Looking for file_idx=%d in file_content_count=%d\n", file_idx,
+          file_content_count);
 
   /* Search for content in file_contents array */
   for (int i = 0; i < file_content_count; i++) {
@@ -1523,36 +1396,20 @@ static int cmd_nano(const char *args) {
 
   /* Build full path */
   char full_path[256];
-  int dir_len = str_len(current_dir);
-  for (int i = 0; i < dir_len && i < 255; i++) {
-    full_path[i] = current_dir[i];
-  }
-  int name_len = str_len(name);
-  for (int i = 0; i < name_len && (dir_len + i) < 255; i++) {
-    full_path[dir_len + i] = name[i];
-  }
-  full_path[dir_len + name_len] = '\0';
+  fs_full_path(full_path, name);
 
   /* Find or create file in fs_table */
   int file_idx = -1;
   bool is_new_file = false;
 
   /* DEBUG: Show what we're looking for */
-  puts("[DEBUG] Looking for file: ");
-  puts(full_path);
-  puts("\n[DEBUG] fs_count = ");
-  char dbg[16];
-  int_to_str(fs_count, dbg);
-  puts(dbg);
-  puts("\n");
+  kprintf("[DEBUG] Looking for file: %s\n[DEBUG] fs_count = %d\n", full_path,
+          fs_count);
 
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 0) {
+    if (strcmp(fs_table[i].name, full_path) == 0 && fs_table[i].type == 0) {
       file_idx = i;
-      puts("[DEBUG] Found at index ");
-      int_to_str(i, dbg);
-      puts(dbg);
-      puts("\n");
+      kprintf("[DEBUG] Found at index %d\n", i);
       break;
     }
   }
@@ -1563,7 +1420,7 @@ static int cmd_nano(const char *args) {
       puts("Error: Filesystem full\n");
       return -1;
     }
-    str_copy(fs_table[fs_count].name, full_path, FS_MAX_FILENAME);
+    strlcpy(fs_table[fs_count].name, full_path, FS_MAX_FILENAME);
     fs_table[fs_count].size = 0;
     fs_table[fs_count].type = 0;
     fs_table[fs_count].attr = 0x20;
@@ -1571,16 +1428,10 @@ static int cmd_nano(const char *args) {
     is_new_file = true;
     fs_count++;
 
-    puts("[DEBUG] Created new file at index ");
-    int_to_str(file_idx, dbg);
-    puts(dbg);
-    puts("\n");
+    kprintf("[DEBUG] Created new file at index %d\n", file_idx);
   }
 
-  puts("[DEBUG] Using file_idx = ");
-  int_to_str(file_idx, dbg);
-  puts(dbg);
-  puts("\n");
+  kprintf("[DEBUG] Using file_idx = %d\n", file_idx);
 
   /* Show editor header */
   puts("\n=== NANO Editor ===\n");
@@ -1590,8 +1441,8 @@ static int cmd_nano(const char *args) {
   puts("ESC=Save  Ctrl+C=Cancel  Ctrl+K=Clear\n");
   puts("-------------------\n");
 
-  /* Allocate buffer on HEAP */
-  char *buf = (char *)kmalloc(MAX_FILE_SIZE);
+  /* Edit buffer lives until the command returns */
+  char *buf = (char *)cmd_scratch(MAX_FILE_SIZE);
   if (buf == NULL) {
     puts("Error: Out of memory\n");
     if (is_new_file)
@@ -1624,9 +1475,7 @@ static int cmd_nano(const char *args) {
     }
 
     /* Copy to buffer */
-    for (uint32_t j = 0; j < load_size; j++) {
-      buf[j] = file_contents[content_idx].data[j];
-    }
+    memcpy(buf, file_contents[content_idx].data, load_size);
     pos = (int)load_size;
 
     /* Display existing content */
@@ -1685,7 +1534,6 @@ static int cmd_nano(const char *args) {
   }
 
   if (cancelled) {
-    kfree(buf);
     if (is_new_file)
       fs_count--;
     return 0;
@@ -1695,7 +1543,6 @@ static int cmd_nano(const char *args) {
 
   if (pos == 0) {
     puts("Empty - not saved\n");
-    kfree(buf);
     if (is_new_file)
       fs_count--;
     return 0;
@@ -1705,47 +1552,36 @@ static int cmd_nano(const char *args) {
   if (content_idx < 0) {
     if (file_content_count >= 64) {
       puts("Error: Too many files\n");
-      kfree(buf);
       if (is_new_file)
         fs_count--;
       return -1;
     }
-    content_idx = file_content_count++;
+    content_idx = file_content_count;
   }
 
-  /* Zero and save */
-  for (int i = 0; i < MAX_FILE_SIZE; i++) {
-    file_contents[content_idx].data[i] = 0;
+  if (fc_reserve(content_idx, (uint32_t)pos) != 0) {
+    puts("Error: Out of memory\n");
+    if (is_new_file)
+      fs_count--;
+    return -1;
   }
-
+  if (content_idx == file_content_count)
+    file_content_count++;
   file_contents[content_idx].file_idx = (uint16_t)file_idx;
   file_contents[content_idx].size = (uint32_t)pos;
 
-  for (int i = 0; i < pos; i++) {
-    file_contents[content_idx].data[i] = buf[i];
-  }
-
-  kfree(buf);
+  memcpy(file_contents[content_idx].data, buf, pos);
 
   /* CRITICAL: Update fs_table size BEFORE saving to disk */
   fs_table[file_idx].size = (uint32_t)pos;
 
   /* Save both file table and file contents to disk */
   if (fs_save_to_disk() == 0) {
-    char tmp[16];
-    puts("Saved ");
-    int_to_str(pos, tmp);
-    puts(tmp);
-    puts(" bytes to disk\n");
+    kprintf("Saved %d bytes to disk\n", pos);
 
     /* SUCCESS - data is on disk, show verification */
-    puts("Verifying: fs_table[");
-    int_to_str(file_idx, tmp);
-    puts(tmp);
-    puts("].size = ");
-    int_to_str(fs_table[file_idx].size, tmp);
-    puts(tmp);
-    puts(" bytes\n");
+    kprintf("Verifying: fs_table[%d].size = %u bytes\n", file_idx,
+            fs_table[file_idx].size);
   } else {
     puts("ERROR: Save failed!\n");
     return -1;
@@ -1754,28 +1590,74 @@ static int cmd_nano(const char *args) {
   return 0;
 }
 
+/* MEM /MAP - the BIOS E820 map the page allocator was built from */
+static void mem_print_map(void) {
+  static const char *const types[] = {"?", "usable", "reserved", "ACPI",
+                                      "ACPI NVS", "bad"};
+  uint32_t count;
+  const e820_entry_t *map = pmm_e820(&count);
+
+  puts("Base              Length (KB)  Type\n");
+  for (uint32_t i = 0; i < count; i++) {
+    kprintf("%08X%08X  %-13u%s\n", (uint32_t)(map[i].base >> 32),
+            (uint32_t)map[i].base, (uint32_t)(map[i].length >> 10),
+            map[i].type <= E820_BAD ? types[map[i].type] : types[0]);
+  }
+}
+
+/* MEM /POOL - per-class usage of the interrupt-safe block pool */
+static void mem_print_pool(void) {
+  irqpool_stats_t st;
+  if (irqpool_stats(0, &st) != 0) {
+    puts(cpu_has(CPU_FEAT_CX8) ? "IRQ pool not initialized\n"
+                               : "IRQ pool disabled: CPU has no CMPXCHG8B\n");
+    return;
+  }
+  puts("IRQ pool (interrupt-safe blocks):\n");
+  puts("  Size   Total  In use    High  Failed\n");
+  for (uint32_t i = 0; irqpool_stats(i, &st) == 0; i++) {
+    kprintf("%6u%8u%8u%8u%8u\n", st.block_size, st.count, st.in_use,
+            st.high_water, st.failures);
+  }
+}
+
 /* 16. MEM - Display memory info */
 static int cmd_mem(const char *args) {
-  (void)args;
+  char opt[16];
+  const char *rest = get_token(args, opt, 16);
+  str_upper(opt);
+  if (strcmp(opt, "/MAP") == 0) {
+    mem_print_map();
+    return 0;
+  }
+  if (strcmp(opt, "/TOP") == 0)
+    return heapprof_top(rest);
+  if (strcmp(opt, "/LEAKS") == 0)
+    return heapprof_leaks(rest);
+  if (strcmp(opt, "/POOL") == 0) {
+    mem_print_pool();
+    return 0;
+  }
+
   uint32_t stats[4];
   mem_get_stats(stats);
 
-  char buf[16];
   puts("Memory Statistics:\n");
-  puts("Total Free: ");
-  int_to_str(stats[0], buf);
-  puts(buf);
-  puts(" bytes\n");
-
-  puts("Total Used: ");
-  int_to_str(stats[1], buf);
-  puts(buf);
-  puts(" bytes\n");
-
-  puts("Blocks: ");
-  int_to_str(stats[2], buf);
-  puts(buf);
-  puts("\n");
+  kprintf("Total Free: %u bytes\n", stats[0]);
+  kprintf("Total Used: %u bytes\n", stats[1]);
+  kprintf("Blocks: %u\n", stats[2]);
+  kprintf("Largest Free: %u bytes\n", stats[3]);
+
+  /* Share of free memory that a single allocation cannot use */
+  uint32_t frag = 0;
+  if (stats[0] >= 100) {
+    frag = 100 - stats[3] / (stats[0] / 100);
+    if (frag > 100) frag = 0;
+  }
+  kprintf("Fragmentation: %u%%\n", frag);
+  kprintf("Physical: %u KB usable, %u KB not yet in the heap\n",
+          pmm_total_pages() * (PMM_PAGE_SIZE / 1024),
+          pmm_free_page_count() * (PMM_PAGE_SIZE / 1024));
 
   return 0;
 }
@@ -1804,11 +1686,7 @@ static int cmd_color(const char *args) {
     uint8_t c = str_to_int(tok);
     current_color = c;
     set_attr(c);
-    puts("Color changed to ");
-    char buf[16];
-    int_to_str(c, buf);
-    puts(buf);
-    puts("\n");
+    kprintf("Color changed to %u\n", c);
     return 0;
   }
 
@@ -1826,22 +1704,11 @@ static int cmd_beep(const char *args) {
 /* 20. UPTIME - Show system uptime */
 static int cmd_uptime(const char *args) {
   (void)args;
-  uint32_t ticks = get_ticks();
-  uint32_t seconds = ticks / 18;
+  uint32_t seconds = clock_ms() / 1000;
   uint32_t minutes = seconds / 60;
   uint32_t hours = minutes / 60;
 
-  char buf[16];
-  puts("Uptime: ");
-  int_to_str(hours, buf);
-  puts(buf);
-  puts("h ");
-  int_to_str(minutes % 60, buf);
-  puts(buf);
-  puts("m ");
-  int_to_str(seconds % 60, buf);
-  puts(buf);
-  puts("s\n");
+  kprintf("Uptime: %uh %um %us\n", hours, minutes % 60, seconds % 60);
 
   return 0;
 }
@@ -1859,7 +1726,7 @@ static int cmd_copy(const char *args) {
 
   int src_idx = -1;
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, src) == 0 && fs_table[i].type == 0) {
+    if (strcmp(fs_table[i].name, src) == 0 && fs_table[i].type == 0) {
       src_idx = i;
       break;
     }
@@ -1875,7 +1742,7 @@ static int cmd_copy(const char *args) {
     return -1;
   }
 
-  str_copy(fs_table[fs_count].name, dst, FS_MAX_FILENAME);
+  strlcpy(fs_table[fs_count].name, dst, FS_MAX_FILENAME);
   fs_table[fs_count].size = fs_table[src_idx].size;
   fs_table[fs_count].type = 0;
   fs_table[fs_count].attr = fs_table[src_idx].attr;
@@ -1884,11 +1751,12 @@ static int cmd_copy(const char *args) {
 
   for (int i = 0; i < file_content_count; i++) {
     if (file_contents[i].file_idx == src_idx && file_content_count < 64) {
+      if (fc_reserve(file_content_count, file_contents[i].size) != 0)
+        break;
       file_contents[file_content_count].file_idx = dst_idx;
       file_contents[file_content_count].size = file_contents[i].size;
-      for (uint32_t j = 0; j < file_contents[i].size; j++) {
-        file_contents[file_content_count].data[j] = file_contents[i].data[j];
-      }
+      memcpy(file_contents[file_content_count].data, file_contents[i].data,
+             file_contents[i].size);
       file_content_count++;
       break;
     }
@@ -1911,8 +1779,8 @@ static int cmd_move(const char *args) {
   }
 
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, src) == 0) {
-      str_copy(fs_table[i].name, dst, FS_MAX_FILENAME);
+    if (strcmp(fs_table[i].name, src) == 0) {
+      strlcpy(fs_table[i].name, dst, FS_MAX_FILENAME);
       fs_save_to_disk();
       puts("File moved\n");
       return 0;
@@ -2003,7 +1871,7 @@ static int cmd_attrib(const char *args) {
     }
   } else {
     for (int i = 0; i < fs_count; i++) {
-      if (str_cmp(fs_table[i].name, name) == 0) {
+      if (strcmp(fs_table[i].name, name) == 0) {
         puts("Attributes: 0x");
         print_hex(fs_table[i].attr);
         puts("\n");
@@ -2030,7 +1898,7 @@ static int cmd_chmod(const char *args) {
   uint8_t new_attr = str_to_int(mode);
 
   for (int i = 0; i < fs_count; i++) {
-    if (str_cmp(fs_table[i].name, name) == 0) {
+    if (strcmp(fs_table[i].name, name) == 0) {
       fs_table[i].attr = new_attr;
       fs_save_to_disk();
       puts("Attributes changed\n");
@@ -2062,24 +1930,14 @@ static int cmd_chkdsk(const char *args) {
   (void)args;
   puts("Checking disk...\n");
 
-  char buf[16];
-  puts("Files: ");
-  int_to_str(fs_count, buf);
-  puts(buf);
-  puts("/");
-  int_to_str(FS_MAX_FILES, buf);
-  puts(buf);
-  puts("\n");
+  kprintf("Files: %d/%d\n", fs_count, FS_MAX_FILES);
 
   uint32_t total = 0;
   for (int i = 0; i < fs_count; i++) {
     total += fs_table[i].size;
   }
 
-  puts("Total size: ");
-  int_to_str(total, buf);
-  puts(buf);
-  puts(" bytes\n");
+  kprintf("Total size: %u bytes\n", total);
 
   puts("Disk check complete - no errors found\n");
   return 0;
@@ -2098,7 +1956,7 @@ static int cmd_format(const char *args) {
 
   if (key == 'Y' || key == 'y') {
     fs_count = 0;
-    file_content_count = 0;
+    fc_release_all();
     fs_save_to_disk();
     puts("Format complete\n");
   } else {
@@ -2138,13 +1996,13 @@ static int cmd_useradd(const char *args) {
   }
 
   for (int i = 0; i < user_count; i++) {
-    if (str_cmp(user_table[i].username, username) == 0) {
+    if (strcmp(user_table[i].username, username) == 0) {
       puts("Error: User already exists\n");
       return -1;
     }
   }
 
-  str_copy(user_table[user_count].username, username, 32);
+  strlcpy(user_table[user_count].username, username, 32);
   uint32_t h = hash_string(username);
   for (int i = 0; i < 32; i++) {
     user_table[user_count].password_hash[i] =
@@ -2170,7 +2028,7 @@ static int cmd_userdel(const char *args) {
   }
 
   for (int i = 0; i < user_count; i++) {
-    if (str_cmp(user_table[i].username, username) == 0) {
+    if (strcmp(user_table[i].username, username) == 0) {
       for (int j = i; j < user_count - 1; j++) {
         user_table[j] = user_table[j + 1];
       }
@@ -2191,11 +2049,11 @@ static int cmd_passwd(const char *args) {
   args = get_token(args, username, 32);
 
   if (username[0] == 0) {
-    str_copy(username, current_user, 32);
+    strlcpy(username, current_user, 32);
   }
 
   for (int i = 0; i < user_count; i++) {
-    if (str_cmp(user_table[i].username, username) == 0) {
+    if (strcmp(user_table[i].username, username) == 0) {
       puts("Enter new password: ");
       char pwd[32];
       int pos = 0;
@@ -2240,11 +2098,7 @@ static int cmd_users(const char *args) {
     puts("\n");
   }
 
-  char buf[16];
-  int_to_str(user_count, buf);
-  puts("\nTotal: ");
-  puts(buf);
-  puts(" users\n");
+  kprintf("\nTotal: %d users\n", user_count);
 
   return 0;
 }
@@ -2260,8 +2114,8 @@ static int cmd_login(const char *args) {
   }
 
   for (int i = 0; i < user_count; i++) {
-    if (str_cmp(user_table[i].username, username) == 0) {
-      str_copy(current_user, username, 32);
+    if (strcmp(user_table[i].username, username) == 0) {
+      strlcpy(current_user, username, 32);
       puts("Logged in as ");
       puts(username);
       puts("\n");
@@ -2276,7 +2130,7 @@ static int cmd_login(const char *args) {
 /* 39. LOGOUT - Logout */
 static int cmd_logout(const char *args) {
   (void)args;
-  str_copy(current_user, "root", 32);
+  strlcpy(current_user, "root", 32);
   puts("Logged out\n");
   return 0;
 }
@@ -2300,37 +2154,12 @@ static int cmd_ps(const char *args) {
   puts("PID  NAME            STATE       MEM   PRI\n");
   puts("---  ----            -----       ---   ---\n");
   
-  char buf[32];
+  char mem[16];
   for(int i=0; i<process_count; i++) {
-    /* PID */
-    int_to_str(process_table[i].pid, buf);
-    puts(buf);
-    /* Align */
-    int len = str_len(buf);
-    for(int k=0; k<5-len; k++) putc(' ');
-    
-    /* Name */
-    puts(process_table[i].name);
-    len = str_len(process_table[i].name);
-    for(int k=0; k<16-len; k++) putc(' ');
-    
-    /* State */
-    puts(process_table[i].state);
-    len = str_len(process_table[i].state);
-    for(int k=0; k<12-len; k++) putc(' ');
-    
-    /* Mem */
-    int_to_str(process_table[i].mem_usage, buf);
-    puts(buf);
-    puts("K");
-    len = str_len(buf) + 1;
-    for(int k=0; k<6-len; k++) putc(' ');
-    
-    /* Priority */
-    int_to_str(process_table[i].priority, buf);
-    puts(buf);
-    
-    puts("\n");
+    ksnprintf(mem, sizeof(mem), "%uK", process_table[i].mem_usage);
+    kprintf("%-5u%-16s%-12s%-6s%u\n", process_table[i].pid,
+            process_table[i].name, process_table[i].state, mem,
+            process_table[i].priority);
   }
   return 0;
 }
@@ -2469,11 +2298,7 @@ static int cmd_calc(const char *args) {
     return -1;
   }
 
-  char buf[16];
-  int_to_str(result, buf);
-  puts("Result: ");
-  puts(buf);
-  puts("\n");
+  kprintf("Result: %u\n", result);
 
   return 0;
 }
@@ -2510,12 +2335,7 @@ static int cmd_ascii(const char *args) {
   puts("ASCII Table (printable):\n");
 
   for (int i = 32; i < 127; i++) {
-    char buf[16];
-    int_to_str(i, buf);
-    puts(buf);
-    puts(": ");
-    putc((char)i);
-    puts("  ");
+    kprintf("%d: %c  ", i, i);
 
     if ((i - 31) % 8 == 0) {
       puts("\n");
@@ -2591,6 +2411,38 @@ static int cmd_wifisignal(const char *a) { (void)a; puts("WiFi not available\n")
 static int cmd_wifistat(const char *a) { (void)a; puts("WiFi not available - use IPCONFIG\n"); return 0; }
 /* cmd_wifitest defined above with Rust driver */
 
+/* LSCPU - CPUID summary and the kernels cpu_init picked */
+static int cmd_lscpu(const char *a) {
+  (void)a;
+  const cpu_info_t *ci = cpu_info();
+  if (!ci->vendor[0]) {
+    puts("LSCPU: CPUID not supported\n");
+    return 0;
+  }
+  kprintf("Vendor:    %s\n", ci->vendor);
+  if (ci->brand[0])
+    kprintf("Model:     %s\n", ci->brand);
+  kprintf("Family:    %u  Model: %u  Stepping: %u\n", ci->family, ci->model,
+          ci->stepping);
+
+  uint32_t khz = clock_tsc_khz();
+  if (khz)
+    kprintf("TSC:       %u MHz%s\n", khz / 1000,
+            cpu_has(CPU_FEAT_INVTSC) ? ", invariant" : "");
+
+  char feats[96] = " none";
+  int n = 0;
+  for (uint32_t i = 0; i < CPU_FEAT_COUNT; i++) {
+    if ((ci->features & (1u << i)) && n < (int)sizeof(feats))
+      n += ksnprintf(feats + n, sizeof(feats) - n, " %s", cpu_feature_name(i));
+  }
+  kprintf("Features: %s\n", feats);
+
+  kprintf("Kernels:   mem* %s, checksum %s, CRC32C %s\n", cpu_ops.mem_impl,
+          cpu_ops.csum_impl, cpu_ops.crc_impl);
+  return 0;
+}
+
 /* System stub commands */
 static int cmd_mount(const char *a) { (void)a; puts("MOUNT: Not implemented\n"); return 0; }
 static int cmd_umount(const char *a) { (void)a; puts("UMOUNT: Not implemented\n"); return 0; }
@@ -2605,14 +2457,12 @@ static int cmd_readsector(const char *a) { (void)a; puts("READSECTOR: Not implem
 static int cmd_sysinfo(const char *a) { (void)a; puts("RO-DOS with VirtIO drivers\n"); return 0; }
 static int cmd_uname(const char *a) { (void)a; puts("RO-DOS v1.0 i386\n"); return 0; }
 static int cmd_hostname(const char *a) { (void)a; puts("rodos\n"); return 0; }
-static int cmd_lscpu(const char *a) { (void)a; puts("LSCPU: x86 CPU\n"); return 0; }
 static int cmd_lspci(const char *a) { 
     (void)a;
     /* Direct PCI scan - check all slots on bus 0 */
     extern uint32_t pci_config_read(uint8_t bus, uint8_t device, uint8_t function, uint8_t offset);
     
     puts("=== PCI Scan (Bus 0) ===\n");
-    char hex[] = "0123456789ABCDEF";
     int found = 0;
     
     for (int dev = 0; dev < 32; dev++) {
@@ -2624,18 +2474,8 @@ static int cmd_lspci(const char *a) {
             uint32_t bar0 = pci_config_read(0, dev, 0, 0x10);
             uint32_t bar1 = pci_config_read(0, dev, 0, 0x14);
             
-            puts("Slot ");
-            if (dev < 10) putc('0');
-            putc('0' + dev / 10); putc('0' + dev % 10);
-            puts(": Vendor=");
-            for (int j = 12; j >= 0; j -= 4) putc(hex[(vendor >> j) & 0xF]);
-            puts(" Dev=");
-            for (int j = 12; j >= 0; j -= 4) putc(hex[(device_id >> j) & 0xF]);
-            puts(" BAR0=");
-            for (int j = 28; j >= 0; j -= 4) putc(hex[(bar0 >> j) & 0xF]);
-            puts(" BAR1=");
-            for (int j = 28; j >= 0; j -= 4) putc(hex[(bar1 >> j) & 0xF]);
-            puts("\n");
+            kprintf("Slot %02d: Vendor=%04X Dev=%04X BAR0=%08X BAR1=%08X\n",
+                    dev, vendor, device_id, bar0, bar1);
             found++;
             
             /* Check if VirtIO */
@@ -2647,14 +2487,120 @@ static int cmd_lspci(const char *a) {
     
     if (found == 0) puts("No PCI devices found!\n");
     else {
-        puts("Total: ");
-        putc('0' + found / 10); putc('0' + found % 10);
-        puts(" devices\n");
+        kprintf("Total: %d devices\n", found);
     }
     puts("VirtIO vendor ID is 1AF4\n");
     return 0;
 }
-static int cmd_dmesg(const char *a) { (void)a; puts("DMESG: No kernel messages\n"); return 0; }
+/* DMESG - Decode the kernel trace ring */
+static void dmesg_print_line(const char *line, void *ctx) {
+  (void)ctx;
+  puts(line);
+  puts("\n");
+}
+
+static int dmesg_save(const char *filename) {
+  char *text = (char *)cmd_scratch(MAX_FILE_SIZE);
+  if (!text) {
+    puts("DMESG: Out of memory\n");
+    return -1;
+  }
+
+  /* Keep the newest records that fit in one file */
+  char line[128];
+  trace_record_t rec;
+  uint32_t n = trace_count();
+  uint32_t first = n;
+  int need = 0;
+  while (first > 0) {
+    if (trace_get(first - 1, &rec) == 0) {
+      int l = trace_format(&rec, line, sizeof(line)) + 1;
+      if (need + l > MAX_FILE_SIZE)
+        break;
+      need += l;
+    }
+    first--;
+  }
+
+  int len = 0;
+  for (uint32_t i = first; i < n; i++) {
+    if (trace_get(i, &rec) != 0)
+      continue;
+    int l = trace_format(&rec, line, sizeof(line));
+    if (len + l + 1 > MAX_FILE_SIZE)
+      break;
+    for (int k = 0; k < l; k++)
+      text[len++] = line[k];
+    text[len++] = '\n';
+  }
+
+  int rc = save_file_content(filename, text, len);
+  if (rc == 0)
+    rc = fs_save_to_disk();
+
+  if (rc != 0) {
+    puts("DMESG: Failed to save ");
+    puts(filename);
+    puts("\n");
+    return -1;
+  }
+  kprintf("DMESG: Saved %u records to %s\n", n - first, filename);
+  return 0;
+}
+
+static int cmd_dmesg(const char *args) {
+  char opt[16], name[64];
+  args = get_token(args, opt, 16);
+  str_upper(opt);
+
+  if (opt[0] == 0) {
+    if (trace_count() == 0) {
+      puts("DMESG: No kernel messages\n");
+      return 0;
+    }
+    trace_dump(dmesg_print_line, NULL);
+    return 0;
+  }
+  if (strcmp(opt, "/C") == 0 || strcmp(opt, "/CLEAR") == 0) {
+    trace_clear();
+    puts("DMESG: Trace ring cleared\n");
+    return 0;
+  }
+  if (strcmp(opt, "/S") == 0 || strcmp(opt, "/SAVE") == 0) {
+    get_token(args, name, 64);
+    if (name[0] == 0) {
+      puts("Usage: DMESG /SAVE <file>\n");
+      return -1;
+    }
+    return dmesg_save(name);
+  }
+
+  puts("Usage: DMESG [/CLEAR | /SAVE <file>]\n");
+  return -1;
+}
+
+static int cmd_serial(const char *args) {
+  char arg[16];
+  get_token(args, arg, 16);
+  str_upper(arg);
+
+  if (!serial_present()) {
+    puts("SERIAL: No UART detected on COM1\n");
+    return 1;
+  }
+  if (strcmp(arg, "ON") == 0) {
+    serial_set_mirror(true);
+  } else if (strcmp(arg, "OFF") == 0) {
+    serial_set_mirror(false);
+  } else if (arg[0]) {
+    puts("Usage: SERIAL [ON|OFF]\n");
+    return 1;
+  }
+  puts("COM1: 115200 8N1, console mirror ");
+  puts(serial_get_mirror() ? "ON\n" : "OFF\n");
+  return 0;
+}
+
 static int cmd_mode(const char *a) { (void)a; puts("MODE: Use GUITEST for graphics\n"); return 0; }
 static int cmd_ipconfig(const char *a) { (void)a; puts("Use NETSTAT for network status\n"); return 0; }
 static int cmd_ping(const char *a) { (void)a; puts("PING: Use NETSTART first, then WGET to test network\n"); return 0; }
@@ -2739,7 +2685,7 @@ static int cmd_sudo(const char *args) {
   }
   
   // Check if user is already root
-  if (str_cmp(current_user, "root") == 0) {
+  if (strcmp(current_user, "root") == 0) {
     puts("[sudo] User is already root.\n");
     // Execute the command directly
     return cmd_dispatch(args);
@@ -2782,8 +2728,8 @@ static int cmd_sudo(const char *args) {
   
   // Temporarily become root
   char saved_user[32];
-  str_copy(saved_user, current_user, 32);
-  str_copy(current_user, "root", 32);
+  strlcpy(saved_user, current_user, 32);
+  strlcpy(current_user, "root", 32);
   
   set_attr(0x0A);
   puts("[sudo] Running as root...\n");
@@ -2793,7 +2739,7 @@ static int cmd_sudo(const char *args) {
   int result = cmd_dispatch(args);
   
   // Restore original user
-  str_copy(current_user, saved_user, 32);
+  strlcpy(current_user, saved_user, 32);
   
   return result;
 }
@@ -2810,9 +2756,14 @@ static int cmd_python(const char *args) {
   puts("Supported: print(), input(), basic math (+,-,*,/,%), variables\n\n");
   
   // Simple variable storage (up to 16 variables)
-  char var_names[16][32];
+  char (*var_names)[32] = cmd_scratch(16 * 32);
   int var_values[16];
   int var_count = 0;
+  char *line = cmd_scratch(256);
+  if (!var_names || !line) {
+    puts("Python: Out of memory\n");
+    return -1;
+  }
   
   // Initialize variables
   for (int i = 0; i < 16; i++) {
@@ -2820,8 +2771,6 @@ static int cmd_python(const char *args) {
     var_values[i] = 0;
   }
   
-  char line[256];
-  
   while (1) {
     puts(">>> ");
     
@@ -2858,13 +2807,13 @@ static int cmd_python(const char *args) {
     while (*p == ' ' || *p == '\t') p++;
     
     // Check for exit
-    if (str_cmp(p, "exit()") == 0 || str_cmp(p, "quit()") == 0) {
+    if (strcmp(p, "exit()") == 0 || strcmp(p, "quit()") == 0) {
       puts("Goodbye!\n");
       break;
     }
     
     // Check for help
-    if (str_cmp(p, "help()") == 0) {
+    if (strcmp(p, "help()") == 0) {
       puts("RO-DOS Python Micro Edition\n");
       puts("Commands:\n");
       puts("  print(\"text\") or print(expr) - Display output\n");
@@ -2898,11 +2847,8 @@ static int cmd_python(const char *args) {
           // Check if it's a variable
           bool found_var = false;
           for (int i = 0; i < var_count; i++) {
-            if (str_cmp(var_names[i], expr) == 0) {
-              char buf[16];
-              int_to_str(var_values[i], buf);
-              puts(buf);
-              puts("\n");
+            if (strcmp(var_names[i], expr) == 0) {
+              kprintf("%d\n", var_values[i]);
               found_var = true;
               break;
             }
@@ -2911,10 +2857,7 @@ static int cmd_python(const char *args) {
           if (!found_var) {
             // Try to evaluate as number
             int val = str_to_int(expr);
-            char buf[16];
-            int_to_str(val, buf);
-            puts(buf);
-            puts("\n");
+            kprintf("%d\n", val);
           }
         }
       } else {
@@ -2946,7 +2889,7 @@ static int cmd_python(const char *args) {
       // Store variable
       int idx = -1;
       for (int i = 0; i < var_count; i++) {
-        if (str_cmp(var_names[i], varname) == 0) {
+        if (strcmp(var_names[i], varname) == 0) {
           idx = i;
           break;
         }
@@ -2955,7 +2898,7 @@ static int cmd_python(const char *args) {
         idx = var_count++;
       }
       if (idx >= 0) {
-        str_copy(var_names[idx], varname, 32);
+        strlcpy(var_names[idx], varname, 32);
         var_values[idx] = value;
       }
       continue;
@@ -2964,21 +2907,15 @@ static int cmd_python(const char *args) {
     // Try to evaluate simple expression and print result
     if (p[0] >= '0' && p[0] <= '9') {
       int val = str_to_int(p);
-      char buf[16];
-      int_to_str(val, buf);
-      puts(buf);
-      puts("\n");
+      kprintf("%d\n", val);
       continue;
     }
     
     // Check if it's a variable name
     bool found_var = false;
     for (int i = 0; i < var_count; i++) {
-      if (str_cmp(var_names[i], p) == 0) {
-        char buf[16];
-        int_to_str(var_values[i], buf);
-        puts(buf);
-        puts("\n");
+      if (strcmp(var_names[i], p) == 0) {
+        kprintf("%d\n", var_values[i]);
         found_var = true;
         break;
       }
@@ -3004,7 +2941,6 @@ static int cmd_wget(const char *args) {
   extern int tcp_close(int socket);
   extern uint32_t dns_resolve(const char *hostname);
 
-  char url[256] = {0};
   char output_file[64] = {0};
 
   // 1. Check Network Connection (works with e1000/VirtIO or WiFi)
@@ -3017,19 +2953,30 @@ static int cmd_wget(const char *args) {
     return -1;
   }
 
+  // URL and request strings only live for this download
+  char *url = cmd_scratch(256);
+  char *token = cmd_scratch(128);
+  char *host = cmd_scratch(128);
+  char *path = cmd_scratch(128);
+  char *req = cmd_scratch(512);
+  if (!url || !token || !host || !path || !req) {
+    puts("WGET: Out of memory\n");
+    return -1;
+  }
+  url[0] = host[0] = path[0] = 0;
+
   // Parse Arguments
-  char token[128];
   const char *p = args;
   while (*p) {
     p = get_token(p, token, 128);
     if (!token[0])
       break;
 
-    if (str_cmp(token, "-filename") == 0 || str_cmp(token, "-O") == 0) {
+    if (strcmp(token, "-filename") == 0 || strcmp(token, "-O") == 0) {
       if (*p)
         p = get_token(p, output_file, 64);
     } else {
-      str_copy(url, token, 256);
+      strlcpy(url, token, 256);
     }
   }
 
@@ -3063,8 +3010,6 @@ static int cmd_wget(const char *args) {
   }
 
   // Extract host and path
-  char host[128] = {0};
-  char path[128] = {0};
   int i = 0;
   while (host_start[i] && host_start[i] != '/' && host_start[i] != ':' && i < 127) {
     host[i] = host_start[i];
@@ -3092,8 +3037,6 @@ static int cmd_wget(const char *args) {
       is_ip = false;
   }
 
-  char buf[32];
-  
   if (is_ip) {
     int parts[4] = {0};
     int val = 0, idx = 0;
@@ -3133,18 +3076,7 @@ static int cmd_wget(const char *args) {
   }
 
   // Print IP
-  int_to_str((ip >> 24) & 0xFF, buf);
-  puts(buf);
-  puts(".");
-  int_to_str((ip >> 16) & 0xFF, buf);
-  puts(buf);
-  puts(".");
-  int_to_str((ip >> 8) & 0xFF, buf);
-  puts(buf);
-  puts(".");
-  int_to_str(ip & 0xFF, buf);
-  puts(buf);
-  puts("\n");
+  kprintf("%ip\n", (uint32_t)ip);
   set_attr(0x07);
 
   set_attr(0x0B);
@@ -3166,8 +3098,7 @@ static int cmd_wget(const char *args) {
   set_attr(0x07);
 
   // Build HTTP Request
-  char req[512];
-  str_copy(req, "GET ", 512);
+  strlcpy(req, "GET ", 512);
   char *d = req + 4;
   const char *s = path;
   while (*s && (d - req) < 500)
@@ -3183,15 +3114,16 @@ static int cmd_wget(const char *args) {
     *d++ = *s++;
   *d = 0;
 
-  tcp_send(sock, req, str_len(req));
+  tcp_send(sock, req, strlen(req));
 
   set_attr(0x0E);
   puts("Downloading");
   set_attr(0x07);
   
-  // Use kmalloc for larger buffer - 1MB for larger downloads
-  #define DOWNLOAD_BUF_SIZE (1024 * 1024)
-  char *down_buf = (char *)kmalloc(DOWNLOAD_BUF_SIZE);
+  // Start small and double the buffer as data arrives
+  #define DOWNLOAD_BUF_INITIAL (16 * 1024)
+  uint32_t down_cap = DOWNLOAD_BUF_INITIAL;
+  char *down_buf = (char *)kmalloc(down_cap);
   if (!down_buf) {
     set_attr(0x0C);
     puts("\nERROR: Out of memory!\n");
@@ -3202,10 +3134,20 @@ static int cmd_wget(const char *args) {
 
   int total_recvd = 0;
   int dots = 0;
+  bool truncated = false;
 
   // Download with progress indicator
-  while (total_recvd < DOWNLOAD_BUF_SIZE) {
-    int r = tcp_receive(sock, down_buf + total_recvd, DOWNLOAD_BUF_SIZE - total_recvd);
+  while (1) {
+    if ((uint32_t)total_recvd == down_cap) {
+      char *grown = (char *)krealloc(down_buf, down_cap * 2);
+      if (!grown) {
+        truncated = true;
+        break;
+      }
+      down_buf = grown;
+      down_cap *= 2;
+    }
+    int r = tcp_receive(sock, down_buf + total_recvd, down_cap - total_recvd);
     if (r <= 0)
       break;
     total_recvd += r;
@@ -3222,11 +3164,13 @@ static int cmd_wget(const char *args) {
   puts("\n");
 
   set_attr(0x0A);
-  puts("Download complete! ");
-  int_to_str(total_recvd, buf);
-  puts(buf);
-  puts(" bytes received.\n");
+  kprintf("Download complete! %d bytes received.\n", total_recvd);
   set_attr(0x07);
+  if (truncated) {
+    set_attr(0x0E);
+    puts("Warning: out of memory, the rest of the download was dropped.\n");
+    set_attr(0x07);
+  }
 
   // Parse HTTP Response - find body
   char *body = down_buf;
@@ -3270,7 +3214,7 @@ static int cmd_wget(const char *args) {
       }
       output_file[fn_idx] = 0;
     } else {
-      str_copy(output_file, "index.html", 64);
+      strlcpy(output_file, "index.html", 64);
     }
   }
 
@@ -3281,13 +3225,13 @@ static int cmd_wget(const char *args) {
   
   if (save_file_content(output_file, body, body_len) == 0) {
     fs_save_to_disk();
+    if (body_len > MAX_FILE_SIZE) {
+      set_attr(0x0E);
+      puts("Warning: files hold at most 4096 bytes, the rest was not saved.\n");
+      body_len = MAX_FILE_SIZE;
+    }
     set_attr(0x0A);
-    puts("SUCCESS! Saved ");
-    int_to_str(body_len, buf);
-    puts(buf);
-    puts(" bytes to ");
-    puts(output_file);
-    puts("\n");
+    kprintf("SUCCESS! Saved %d bytes to %s\n", body_len, output_file);
     set_attr(0x07);
   } else {
     set_attr(0x0C);
@@ -3392,6 +3336,11 @@ static const Command commands[] = {{"GUITEST", cmd_guitest},
                                    {"LSCPU", cmd_lscpu},
                                    {"LSPCI", cmd_lspci},
                                    {"DMESG", cmd_dmesg},
+                                   {"BENCH", cmd_bench},
+                                   {"PROFILE", cmd_profile},
+                                   {"BOOTTIME", cmd_boottime},
+                                   {"BACKTRACE", cmd_backtrace},
+                                   {"SERIAL", cmd_serial},
 
                                    /* Screen/display */
                                    {"COLOR", cmd_color},
@@ -3468,10 +3417,18 @@ int cmd_dispatch(const char *line) {
   /* Convert to uppercase */
   str_upper(cmd_name);
 
-  /* Find and execute command */
+  /* Find and execute command; the first letter rules out most entries
+   * without a call */
   for (int i = 0; commands[i].name != NULL; i++) {
-    if (str_cmp(cmd_name, commands[i].name) == 0) {
-      return commands[i].func(args);
+    if (commands[i].name[0] == cmd_name[0] &&
+        strcmp(cmd_name, commands[i].name) == 0) {
+      /* Scripts and REPEAT nest commands; the outermost one owns the
+       * scratch arena */
+      cmd_depth++;
+      int result = commands[i].func(args);
+      if (--cmd_depth == 0)
+        arena_reset(&cmd_arena);
+      return result;
     }
   }
 
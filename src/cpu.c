@@ -0,0 +1,185 @@
+/*
+ * RO-DOS CPU Detection
+ * CPUID probe and kernel selection for include/cpu.h
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/cpu.h"
+#include "../include/fpu.h"
+#include "../include/simd.h"
+#include "../include/crc32c.h"
+
+/* Leaf 1 EDX */
+#define CPUID_1D_FPU    (1u << 0)
+#define CPUID_1D_PSE    (1u << 3)
+#define CPUID_1D_TSC    (1u << 4)
+#define CPUID_1D_CX8    (1u << 8)
+#define CPUID_1D_APIC   (1u << 9)
+#define CPUID_1D_PAT    (1u << 16)
+#define CPUID_1D_FXSR   (1u << 24)
+#define CPUID_1D_SSE    (1u << 25)
+#define CPUID_1D_SSE2   (1u << 26)
+/* Leaf 1 ECX */
+#define CPUID_1C_SSE42  (1u << 20)
+#define CPUID_1C_RDRAND (1u << 30)
+/* Leaf 0x80000007 EDX */
+#define CPUID_X7D_INVTSC (1u << 8)
+
+#define EFLAGS_ID       0x00200000u
+
+static cpu_info_t info;
+
+/* Baseline until cpu_init picks something better */
+cpu_ops_t cpu_ops = {
+    .copy = mem_copy_rep,
+    .fill = mem_fill_rep,
+    .blit = mem_copy_rep,
+    .clear = mem_fill_rep,
+    .csum16 = mem_csum16,
+    .crc32c = crc32c_sw,
+    .mem_impl = "rep movsd/stosd",
+    .csum_impl = "scalar",
+    .crc_impl = "table",
+};
+
+static const char *const feature_names[CPU_FEAT_COUNT] = {
+    "FPU", "TSC", "PSE", "APIC", "PAT", "FXSR", "SSE", "SSE2", "SSE4.2",
+    "RDRAND", "INVTSC", "CX8",
+};
+
+static inline void cpuid(uint32_t leaf, uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d) {
+    __asm__ volatile ("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+/* CPUID exists if EFLAGS.ID can be toggled (not on most 486s) */
+static bool cpuid_present(void) {
+    size_t before, after;
+    __asm__ volatile ("pushf\n\t"
+                      "pop %0\n\t"
+                      "mov %0, %1\n\t"
+                      "xor %2, %1\n\t"
+                      "push %1\n\t"
+                      "popf\n\t"
+                      "pushf\n\t"
+                      "pop %1\n\t"
+                      "push %0\n\t"
+                      "popf"
+                      : "=&r"(before), "=&r"(after)
+                      : "ri"((size_t)EFLAGS_ID)
+                      : "cc");
+    return ((before ^ after) & EFLAGS_ID) != 0;
+}
+
+static void cpu_probe(void) {
+    uint32_t a, b, c, d;
+    if (!cpuid_present()) return;
+
+    cpuid(0, &a, &b, &c, &d);
+    uint32_t max_leaf = a;
+    uint32_t vendor[3] = { b, d, c };
+    for (int i = 0; i < 12; i++) {
+        info.vendor[i] = (char)(vendor[i / 4] >> ((i % 4) * 8));
+    }
+    info.vendor[12] = '\0';
+
+    if (max_leaf >= 1) {
+        cpuid(1, &a, &b, &c, &d);
+        uint32_t family = (a >> 8) & 0xF;
+        uint32_t model = (a >> 4) & 0xF;
+        if (family == 0xF) family += (a >> 20) & 0xFF;
+        if (family == 0x6 || family >= 0xF) model |= ((a >> 16) & 0xF) << 4;
+        info.family = family;
+        info.model = model;
+        info.stepping = a & 0xF;
+
+        if (d & CPUID_1D_FPU) info.features |= CPU_FEAT_FPU;
+        if (d & CPUID_1D_TSC) info.features |= CPU_FEAT_TSC;
+        if (d & CPUID_1D_PSE) info.features |= CPU_FEAT_PSE;
+        if (d & CPUID_1D_CX8) info.features |= CPU_FEAT_CX8;
+        if (d & CPUID_1D_APIC) info.features |= CPU_FEAT_APIC;
+        if (d & CPUID_1D_PAT) info.features |= CPU_FEAT_PAT;
+        if (d & CPUID_1D_FXSR) info.features |= CPU_FEAT_FXSR;
+        if (d & CPUID_1D_SSE) info.features |= CPU_FEAT_SSE;
+        if (d & CPUID_1D_SSE2) info.features |= CPU_FEAT_SSE2;
+        if (c & CPUID_1C_SSE42) info.features |= CPU_FEAT_SSE42;
+        if (c & CPUID_1C_RDRAND) info.features |= CPU_FEAT_RDRAND;
+    }
+
+    cpuid(0x80000000u, &a, &b, &c, &d);
+    uint32_t max_ext = a;
+    if (max_ext >= 0x80000004u) {
+        uint32_t brand[12];
+        for (uint32_t leaf = 0; leaf < 3; leaf++) {
+            cpuid(0x80000002u + leaf, &brand[leaf * 4], &brand[leaf * 4 + 1],
+                  &brand[leaf * 4 + 2], &brand[leaf * 4 + 3]);
+        }
+        for (int i = 0; i < 48; i++) {
+            info.brand[i] = (char)(brand[i / 4] >> ((i % 4) * 8));
+        }
+        info.brand[48] = '\0';
+        /* Intel pads the brand string on the left */
+        int skip = 0;
+        while (info.brand[skip] == ' ') skip++;
+        if (skip) {
+            int i = 0;
+            while ((info.brand[i] = info.brand[i + skip]) != '\0') i++;
+        }
+    }
+    if (max_ext >= 0x80000007u) {
+        cpuid(0x80000007u, &a, &b, &c, &d);
+        if (d & CPUID_X7D_INVTSC) info.features |= CPU_FEAT_INVTSC;
+    }
+}
+
+/* SSE2 wrappers: only big copies and fills bypass the cache; the
+ * framebuffer is write-combined, so blit and clear always stream */
+static void copy_sse2(void *dest, const void *src, size_t n) {
+    simd_copy(dest, src, n, n >= SIMD_NT_BYTES);
+}
+
+static void fill_sse2(void *dest, uint32_t pattern, size_t n) {
+    simd_fill(dest, pattern, n, n >= SIMD_NT_BYTES);
+}
+
+static void blit_sse2(void *dest, const void *src, size_t n) {
+    simd_copy(dest, src, n, true);
+}
+
+static void clear_sse2(void *dest, uint32_t pattern, size_t n) {
+    simd_fill(dest, pattern, n, true);
+}
+
+/* Headers are too short to pay for the XMM setup */
+static uint16_t csum16_sse2(const void *data, size_t len) {
+    if (len < 64) return mem_csum16(data, len);
+    return simd_csum16(data, len);
+}
+
+void cpu_init(void) {
+    cpu_probe();
+    fpu_init();
+
+    if (fpu_sse2) {
+        cpu_ops.copy = copy_sse2;
+        cpu_ops.fill = fill_sse2;
+        cpu_ops.blit = blit_sse2;
+        cpu_ops.clear = clear_sse2;
+        cpu_ops.csum16 = csum16_sse2;
+        cpu_ops.mem_impl = "SSE2";
+        cpu_ops.csum_impl = "SSE2";
+    }
+    if (cpu_has(CPU_FEAT_SSE42)) {
+        cpu_ops.crc32c = crc32c_sse42;
+        cpu_ops.crc_impl = "SSE4.2 crc32";
+    }
+}
+
+const cpu_info_t *cpu_info(void) {
+    return &info;
+}
+
+const char *cpu_feature_name(uint32_t i) {
+    return i < CPU_FEAT_COUNT ? feature_names[i] : "?";
+}
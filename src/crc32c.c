@@ -0,0 +1,64 @@
+/*
+ * RO-DOS CRC32C
+ * Table and SSE4.2 kernels for include/crc32c.h
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/crc32c.h"
+#include "../include/cpu.h"
+
+/* Reflected Castagnoli polynomial */
+#define CRC32C_POLY 0x82F63B78u
+
+static uint32_t crc32c_table[256];
+static bool crc32c_table_ready = false;
+
+/* Built on first use. Two callers racing here write the same values, so
+ * it is safe without a lock. */
+static void crc32c_build_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c >> 1) ^ ((c & 1) ? CRC32C_POLY : 0);
+        }
+        crc32c_table[i] = c;
+    }
+    crc32c_table_ready = true;
+}
+
+uint32_t crc32c_sw(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    if (!crc32c_table_ready) crc32c_build_table();
+    while (len--) {
+        crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+/* The crc32 instruction works on general registers, so this needs SSE4.2
+ * but not the OSFXSR state fpu_init sets up */
+uint32_t crc32c_sse42(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (len && ((size_t)p & 3)) {
+        __asm__ ("crc32b %1, %0" : "+r"(crc) : "m"(*p));
+        p++;
+        len--;
+    }
+    while (len >= 4) {
+        __asm__ ("crc32l %1, %0" : "+r"(crc) : "m"(*(const uint32_t *)p));
+        p += 4;
+        len -= 4;
+    }
+    while (len--) {
+        __asm__ ("crc32b %1, %0" : "+r"(crc) : "m"(*p));
+        p++;
+    }
+    return crc;
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+    if (!data) return crc;
+    return ~cpu_ops.crc32c(~crc, data, len);
+}
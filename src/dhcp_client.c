@@ -5,6 +5,7 @@
 
 #include "../include/network.h"
 #include "../include/stddef.h"
+#include "../include/kprintf.h"
 
 // DHCP message types
 #define DHCP_DISCOVER 1
@@ -164,45 +165,21 @@ int dhcp_discover(network_interface_t *iface) {
 int dhcp_process(network_interface_t *iface, const uint8_t *packet,
                  uint32_t len) {
   extern void puts(const char*);
-  extern void putc(char);
   
-  puts("[DHCP_PROC] Called with len=");
-  char buf[8];
-  buf[0] = '0' + (len / 1000) % 10;
-  buf[1] = '0' + (len / 100) % 10;
-  buf[2] = '0' + (len / 10) % 10;
-  buf[3] = '0' + len % 10;
-  buf[4] = '\0';
-  puts(buf);
-  puts("\n");
+  kprintf("[DHCP_PROC] Called with len=%u\n", len);
   
   // DHCP minimum size is 236 bytes (not including full options array)
   // We check for at least the fixed header fields
   #define DHCP_MIN_SIZE 240
   if (!iface || !packet || len < DHCP_MIN_SIZE) {
-    puts("[DHCP_PROC] Failed validation check (len < ");
-    buf[0] = '0' + (DHCP_MIN_SIZE / 100) % 10;
-    buf[1] = '0' + (DHCP_MIN_SIZE / 10) % 10;
-    buf[2] = '0' + DHCP_MIN_SIZE % 10;
-    buf[3] = '\0';
-    puts(buf);
-    puts(")\n");
+    kprintf("[DHCP_PROC] Failed validation check (len < %d)\n", DHCP_MIN_SIZE);
     return -1;
   }
 
   dhcp_packet_t *dhcp = (dhcp_packet_t *)packet;
 
-  puts("[DHCP_PROC] Checking XID: got=0x");
-  const char hex[] = "0123456789ABCDEF";
-  uint32_t got_xid = dhcp->xid;
-  for (int i = 7; i >= 0; i--) {
-    putc(hex[(got_xid >> (i*4)) & 0xF]);
-  }
-  puts(" expected=0x");
-  for (int i = 7; i >= 0; i--) {
-    putc(hex[(dhcp_xid >> (i*4)) & 0xF]);
-  }
-  puts("\n");
+  kprintf("[DHCP_PROC] Checking XID: got=0x%08X expected=0x%08X\n", dhcp->xid,
+          dhcp_xid);
   
   // Check if it's a response to our request
   if (dhcp->xid != dhcp_xid) {
@@ -216,29 +193,43 @@ int dhcp_process(network_interface_t *iface, const uint8_t *packet,
   uint32_t router = 0;
   uint32_t dns = 0;
 
+  // Options run to the end of the packet, at most sizeof(options)
+  int opt_end = (int)(len - DHCP_MIN_SIZE);
+  if (opt_end > (int)sizeof(dhcp->options))
+    opt_end = sizeof(dhcp->options);
+
   int i = 0;
-  while (i < 312 && dhcp->options[i] != DHCP_OPT_END) {
+  while (i < opt_end && dhcp->options[i] != DHCP_OPT_END) {
     uint8_t opt = dhcp->options[i++];
     if (opt == 0)
       continue; // Padding
 
+    if (i >= opt_end)
+      break;
     uint8_t opt_len = dhcp->options[i++];
+    if (opt_len > opt_end - i)
+      break; // Truncated option
 
     switch (opt) {
     case DHCP_OPT_MSG_TYPE:
-      msg_type = dhcp->options[i];
+      if (opt_len >= 1)
+        msg_type = dhcp->options[i];
       break;
     case DHCP_OPT_SERVER_ID:
-      server_ip = *(uint32_t *)&dhcp->options[i];
+      if (opt_len >= 4)
+        server_ip = *(uint32_t *)&dhcp->options[i];
       break;
     case DHCP_OPT_SUBNET:
-      subnet = *(uint32_t *)&dhcp->options[i];
+      if (opt_len >= 4)
+        subnet = *(uint32_t *)&dhcp->options[i];
       break;
     case DHCP_OPT_ROUTER:
-      router = *(uint32_t *)&dhcp->options[i];
+      if (opt_len >= 4)
+        router = *(uint32_t *)&dhcp->options[i];
       break;
     case DHCP_OPT_DNS:
-      dns = *(uint32_t *)&dhcp->options[i];
+      if (opt_len >= 4)
+        dns = *(uint32_t *)&dhcp->options[i];
       break;
     }
 
@@ -253,30 +244,7 @@ int dhcp_process(network_interface_t *iface, const uint8_t *packet,
     uint32_t host_router = router ? __builtin_bswap32(router) : 0;
     uint32_t host_dns = dns ? __builtin_bswap32(dns) : 0x08080808;  // 8.8.8.8 default
 
-    puts("[DHCP] Got IP offer: ");
-    extern void putc(char);
-    char buf[4];
-    buf[0] = '0' + ((offered_ip >> 24) & 0xFF) / 100;
-    buf[1] = '0' + (((offered_ip >> 24) & 0xFF) / 10) % 10;
-    buf[2] = '0' + ((offered_ip >> 24) & 0xFF) % 10;
-    buf[3] = '\0';
-    puts(buf);
-    puts(".");
-    buf[0] = '0' + ((offered_ip >> 16) & 0xFF) / 100;
-    buf[1] = '0' + (((offered_ip >> 16) & 0xFF) / 10) % 10;
-    buf[2] = '0' + ((offered_ip >> 16) & 0xFF) % 10;
-    puts(buf);
-    puts(".");
-    buf[0] = '0' + ((offered_ip >> 8) & 0xFF) / 100;
-    buf[1] = '0' + (((offered_ip >> 8) & 0xFF) / 10) % 10;
-    buf[2] = '0' + ((offered_ip >> 8) & 0xFF) % 10;
-    puts(buf);
-    puts(".");
-    buf[0] = '0' + (offered_ip & 0xFF) / 100;
-    buf[1] = '0' + ((offered_ip & 0xFF) / 10) % 10;
-    buf[2] = '0' + (offered_ip & 0xFF) % 10;
-    puts(buf);
-    puts("\n");
+    kprintf("[DHCP] Got IP offer: %ip\n", offered_ip);
 
     // Send DHCP REQUEST (simplified - would normally send a proper request)
     // For now, just accept the offered IP
@@ -0,0 +1,113 @@
+/*
+ * RO-DOS DMA Memory
+ * Aligned heap blocks, page runs and buffer pools for include/dma.h
+ *
+ * kmalloc_aligned over-allocates and keeps the real block address in the
+ * word just below the aligned pointer. dma_alloc takes pages from the
+ * frame allocator; alignments above 4 KB allocate a larger run and give
+ * the slack on either side back.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../include/dma.h"
+#include "../include/pmm.h"
+
+extern void *kmalloc(uint32_t size);
+extern void kfree(void *ptr);
+
+#define IS_POW2(x) ((x) != 0 && ((x) & ((x) - 1)) == 0)
+
+void *kmalloc_aligned(uint32_t size, uint32_t align) {
+    if (!IS_POW2(align) || size == 0) return NULL;
+    if (align < sizeof(uint32_t)) align = sizeof(uint32_t);
+
+    uint32_t total = size + align - 1 + sizeof(uint32_t);
+    if (total < size) return NULL;
+    uint8_t *raw = (uint8_t *)kmalloc(total);
+    if (!raw) return NULL;
+
+    uint32_t addr = ((uint32_t)raw + sizeof(uint32_t) + align - 1) & ~(align - 1);
+    ((uint32_t *)addr)[-1] = (uint32_t)raw;
+    return (void *)addr;
+}
+
+void kfree_aligned(void *ptr) {
+    if (!ptr) return;
+    kfree((void *)((uint32_t *)ptr)[-1]);
+}
+
+void *dma_alloc(uint32_t size, uint32_t align) {
+    if (size == 0 || (align && !IS_POW2(align))) return NULL;
+    if (align < PMM_PAGE_SIZE) align = PMM_PAGE_SIZE;
+
+    uint32_t pages = (size + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+    uint32_t slack = align / PMM_PAGE_SIZE - 1;
+    if (pages == 0 || pages + slack < pages) return NULL;
+
+    uint32_t run = pmm_alloc_pages(pages + slack);
+    if (!run) return NULL;
+
+    uint32_t addr = (run + align - 1) & ~(align - 1);
+    uint32_t head = (addr - run) / PMM_PAGE_SIZE;
+    if (head) pmm_free_pages(run, head);
+    if (slack - head) pmm_free_pages(addr + pages * PMM_PAGE_SIZE, slack - head);
+
+    uint32_t *p = (uint32_t *)addr;
+    for (uint32_t i = 0; i < pages * (PMM_PAGE_SIZE / 4); i++) p[i] = 0;
+    return (void *)addr;
+}
+
+void dma_free(void *ptr, uint32_t size) {
+    if (!ptr || size == 0) return;
+    pmm_free_pages((uint32_t)ptr, (size + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE);
+}
+
+int dma_pool_init(dma_pool_t *pool, uint32_t buf_size, uint32_t count) {
+    pool->base = NULL;
+    pool->free_list = NULL;
+    pool->block_size = 0;
+    pool->count = 0;
+    pool->nfree = 0;
+    if (buf_size == 0 || count == 0) return -1;
+
+    uint32_t stride = (buf_size + DMA_POOL_ALIGN - 1) & ~(uint32_t)(DMA_POOL_ALIGN - 1);
+    if (stride < buf_size || stride * (uint64_t)count > 0x40000000) return -1;
+
+    pool->block_size = stride * count;
+    pool->base = dma_alloc(pool->block_size, 0);
+    if (!pool->base) return -1;
+    pool->buf_size = stride;
+    pool->count = count;
+
+    /* Push in reverse so buffers come out in address order */
+    for (uint32_t i = count; i-- > 0;) {
+        dma_pool_put(pool, (uint8_t *)pool->base + i * stride);
+    }
+    return 0;
+}
+
+void dma_pool_destroy(dma_pool_t *pool) {
+    dma_free(pool->base, pool->block_size);
+    pool->base = NULL;
+    pool->free_list = NULL;
+    pool->block_size = 0;
+    pool->count = 0;
+    pool->nfree = 0;
+}
+
+void *dma_pool_get(dma_pool_t *pool) {
+    void *buf = pool->free_list;
+    if (!buf) return NULL;
+    pool->free_list = *(void **)buf;
+    pool->nfree--;
+    return buf;
+}
+
+void dma_pool_put(dma_pool_t *pool, void *buf) {
+    uint32_t off = (uint32_t)buf - (uint32_t)pool->base;
+    if (!buf || off >= pool->block_size || off % pool->buf_size) return;
+    *(void **)buf = pool->free_list;
+    pool->free_list = buf;
+    pool->nfree++;
+}
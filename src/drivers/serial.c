@@ -0,0 +1,265 @@
+/*
+ * RO-DOS COM1 Serial Driver
+ * Interrupt-driven 16550 UART used as a headless console.
+ *
+ * Output goes through a TX ring drained by the THRE interrupt, so a c_puts
+ * mirrored to the UART costs a few memory writes instead of a busy-wait per
+ * byte. When interrupts are off (early boot, exception paths, IRQ context)
+ * the ring is drained by polling before serial_putc returns.
+ *
+ * Received bytes are translated into the same 16-bit key codes the PS/2
+ * keyboard IRQ produces and pushed into the shared key buffer, so
+ * getkey_block() works unchanged over a serial line.
+ */
+
+#include "serial.h"
+#include "portio.h"
+
+/* Pushes one key word (scan << 8 | ascii) into the keyboard ring (interrupt.asm) */
+extern void c_kb_push(uint16_t key);
+
+/* 16550 registers (offset from base) */
+#define UART_DATA       0   /* RBR / THR, DLL when DLAB=1 */
+#define UART_IER        1   /* Interrupt enable, DLM when DLAB=1 */
+#define UART_IIR        2   /* Interrupt ident (read) */
+#define UART_FCR        2   /* FIFO control (write) */
+#define UART_LCR        3
+#define UART_MCR        4
+#define UART_LSR        5
+#define UART_MSR        6
+#define UART_SCRATCH    7
+
+#define IER_RX_AVAIL    0x01
+#define IER_THR_EMPTY   0x02
+#define IER_LINE_STATUS 0x04
+
+#define LSR_DATA_READY  0x01
+#define LSR_THR_EMPTY   0x20
+
+#define MCR_DTR         0x01
+#define MCR_RTS         0x02
+#define MCR_OUT2        0x08    /* Gates the UART interrupt onto IRQ4 */
+#define MCR_LOOPBACK    0x10
+
+#define UART_FIFO_DEPTH 16
+
+/* TX ring - power of two */
+#define SERIAL_TX_SIZE  4096
+#define SERIAL_TX_MASK  (SERIAL_TX_SIZE - 1)
+
+static uint8_t tx_ring[SERIAL_TX_SIZE];
+static volatile uint32_t tx_head = 0;   /* Written by serial_putc */
+static volatile uint32_t tx_tail = 0;   /* Written by the drain path */
+
+static bool serial_ok = false;
+static uint8_t serial_ier = 0;
+
+/* Read by putc in io.asm */
+volatile uint8_t serial_mirror = 0;
+
+/* RX escape sequence decoder state */
+enum { RX_NORMAL, RX_ESC, RX_CSI };
+static uint8_t rx_state = RX_NORMAL;
+static bool rx_last_cr = false;
+
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    __asm__ volatile("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    __asm__ volatile("pushl %0; popfl" : : "r"(flags) : "memory", "cc");
+}
+
+static void serial_set_ier(uint8_t ier) {
+    serial_ier = ier;
+    outb(SERIAL_COM1 + UART_IER, ier);
+}
+
+/* Move up to one FIFO's worth of bytes from the ring to the UART.
+ * Caller must have interrupts disabled. */
+static void serial_tx_fill(void) {
+    if (!(inb(SERIAL_COM1 + UART_LSR) & LSR_THR_EMPTY)) return;
+
+    int n = UART_FIFO_DEPTH;
+    while (n-- > 0 && tx_tail != tx_head) {
+        outb(SERIAL_COM1 + UART_DATA, tx_ring[tx_tail]);
+        tx_tail = (tx_tail + 1) & SERIAL_TX_MASK;
+    }
+
+    /* THRE interrupt only while there is something left to send */
+    if (tx_tail != tx_head) {
+        if (!(serial_ier & IER_THR_EMPTY)) serial_set_ier(serial_ier | IER_THR_EMPTY);
+    } else if (serial_ier & IER_THR_EMPTY) {
+        serial_set_ier(serial_ier & ~IER_THR_EMPTY);
+    }
+}
+
+/* Polled drain - used when interrupts cannot be relied on */
+static void serial_tx_drain_polled(void) {
+    while (tx_tail != tx_head) {
+        while (!(inb(SERIAL_COM1 + UART_LSR) & LSR_THR_EMPTY));
+        serial_tx_fill();
+    }
+}
+
+static void serial_tx_enqueue(uint8_t b, bool ints_on) {
+    if (((tx_head + 1) & SERIAL_TX_MASK) == tx_tail) {
+        /* Ring full - make room the slow way rather than drop output */
+        serial_tx_drain_polled();
+    }
+    tx_ring[tx_head] = b;
+    tx_head = (tx_head + 1) & SERIAL_TX_MASK;
+
+    if (ints_on) {
+        serial_tx_fill();
+    } else {
+        serial_tx_drain_polled();
+    }
+}
+
+int serial_init(void) {
+    uint16_t base = SERIAL_COM1;
+
+    outb(base + UART_IER, 0x00);        /* No interrupts while configuring */
+
+    /* Scratch register test catches a missing UART (reads float to 0xFF) */
+    outb(base + UART_SCRATCH, 0xA5);
+    if (inb(base + UART_SCRATCH) != 0xA5) return -1;
+
+    outb(base + UART_LCR, 0x80);        /* DLAB on */
+    outb(base + UART_DATA, 0x01);       /* Divisor 1 = 115200 baud */
+    outb(base + UART_IER, 0x00);
+    outb(base + UART_LCR, 0x03);        /* 8N1, DLAB off */
+    outb(base + UART_FCR, 0xC7);        /* Enable + clear FIFOs, 14-byte RX trigger */
+
+    /* Loopback self-test */
+    outb(base + UART_MCR, MCR_LOOPBACK | MCR_RTS | MCR_DTR);
+    outb(base + UART_DATA, 0xAE);
+    for (int i = 0; i < 10000 && !(inb(base + UART_LSR) & LSR_DATA_READY); i++);
+    if (inb(base + UART_DATA) != 0xAE) return -1;
+
+    outb(base + UART_MCR, MCR_OUT2 | MCR_RTS | MCR_DTR);
+    (void)inb(base + UART_LSR);
+    (void)inb(base + UART_MSR);
+    (void)inb(base + UART_IIR);
+
+    tx_head = tx_tail = 0;
+    rx_state = RX_NORMAL;
+    serial_set_ier(IER_RX_AVAIL | IER_LINE_STATUS);
+
+    serial_ok = true;
+    serial_mirror = 1;
+    return 0;
+}
+
+bool serial_present(void) {
+    return serial_ok;
+}
+
+void serial_putc(char c) {
+    if (!serial_ok) return;
+
+    uint32_t flags = irq_save();
+    bool ints_on = (flags & 0x200) != 0;
+
+    if (c == '\n') serial_tx_enqueue('\r', ints_on);
+    serial_tx_enqueue((uint8_t)c, ints_on);
+
+    irq_restore(flags);
+}
+
+void serial_puts(const char *s) {
+    while (*s) serial_putc(*s++);
+}
+
+void serial_flush(void) {
+    if (!serial_ok) return;
+    uint32_t flags = irq_save();
+    serial_tx_drain_polled();
+    irq_restore(flags);
+}
+
+void serial_set_mirror(bool on) {
+    serial_mirror = (on && serial_ok) ? 1 : 0;
+}
+
+bool serial_get_mirror(void) {
+    return serial_mirror != 0;
+}
+
+/* Translate one received byte into keyboard-buffer key codes */
+static void serial_rx_byte(uint8_t b) {
+    if (rx_state == RX_ESC) {
+        if (b == '[' || b == 'O') {
+            rx_state = RX_CSI;
+            return;
+        }
+        /* Lone ESC followed by something else */
+        rx_state = RX_NORMAL;
+        c_kb_push(27);
+    } else if (rx_state == RX_CSI) {
+        /* Parameter bytes (e.g. "1;5") are skipped until the final byte */
+        if (b >= 0x30 && b <= 0x3F) return;
+        rx_state = RX_NORMAL;
+        switch (b) {
+            case 'A': c_kb_push(0x4800); break;     /* Up */
+            case 'B': c_kb_push(0x5000); break;     /* Down */
+            case 'C': c_kb_push(0x4D00); break;     /* Right */
+            case 'D': c_kb_push(0x4B00); break;     /* Left */
+            default: break;
+        }
+        return;
+    }
+
+    if (b == 27) {
+        rx_state = RX_ESC;
+        return;
+    }
+
+    /* Enter arrives as CR, LF or CR LF depending on the terminal */
+    if (b == '\n' && rx_last_cr) {
+        rx_last_cr = false;
+        return;
+    }
+    rx_last_cr = (b == '\r');
+
+    if (b == '\r' || b == '\n') {
+        c_kb_push(13);
+    } else if (b == 0x7F || b == 0x08) {
+        c_kb_push(8);
+    } else {
+        c_kb_push(b);
+    }
+}
+
+void serial_irq_handler(void) {
+    uint16_t base = SERIAL_COM1;
+
+    if (!serial_ok) return;
+
+    /* Service until the UART reports nothing pending (IIR bit 0 set) */
+    for (int guard = 0; guard < 64; guard++) {
+        uint8_t iir = inb(base + UART_IIR);
+        if (iir & 0x01) break;
+
+        switch (iir & 0x0E) {
+            case 0x04:  /* RX data available */
+            case 0x0C:  /* RX timeout */
+                while (inb(base + UART_LSR) & LSR_DATA_READY) {
+                    serial_rx_byte(inb(base + UART_DATA));
+                }
+                break;
+            case 0x02:  /* THR empty */
+                serial_tx_fill();
+                break;
+            case 0x06:  /* Line status */
+                (void)inb(base + UART_LSR);
+                break;
+            default:    /* Modem status */
+                (void)inb(base + UART_MSR);
+                break;
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* COM1 16550 UART */
+#define SERIAL_COM1 0x3F8
+
+/* Probe and initialize COM1 (115200 8N1). Returns 0 if a UART was found */
+int serial_init(void);
+
+/* True once serial_init() found a working UART */
+bool serial_present(void);
+
+/* Queue a character for transmission ('\n' is sent as "\r\n") */
+void serial_putc(char c);
+
+/* Queue a NUL-terminated string */
+void serial_puts(const char *s);
+
+/* Block until every queued byte has left the transmitter */
+void serial_flush(void);
+
+/* Console mirroring: when enabled, io.asm putc copies output to COM1 */
+void serial_set_mirror(bool on);
+bool serial_get_mirror(void);
+
+/* IRQ4 handler, called from irq_common_stub */
+void serial_irq_handler(void);
+
+#endif
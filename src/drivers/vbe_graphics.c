@@ -7,6 +7,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "portio.h"
+#include "paging.h"
+#include "cpu.h"
 
 /* VESA Info at 0x9000 (set by bootloader) */
 #define VBE_INFO_ADDR 0x9000
@@ -32,6 +34,7 @@ extern void c_putc(char c);
 extern void set_mode_13h(void);
 extern void setup_palette(void);
 extern void *kmalloc(uint32_t size);
+extern void kfree(void *ptr);
 
 /* Simple 8x8 font for VBE mode */
 static const uint8_t vbe_font8x8[128][8] = {
@@ -122,8 +125,11 @@ static const uint8_t vbe_font8x8[128][8] = {
 
 /* Override weak symbols from rust_driver_stubs.c */
 uint32_t *gpu_setup_framebuffer(void) {
-    /* Check if bootloader successfully set VESA mode */
-    if (vbe_info->framebuffer != 0 && vbe_info->width >= 640 && vbe_info->height >= 480) {
+    /* Check if bootloader successfully set VESA mode. The LFB is device
+     * memory above RAM, so it also has to be mapped (write-combined). */
+    uint32_t lfb_size = vbe_info->width * vbe_info->height * ((vbe_info->bpp + 7) / 8);
+    if (vbe_info->framebuffer != 0 && vbe_info->width >= 640 && vbe_info->height >= 480 &&
+        paging_map(vbe_info->framebuffer, lfb_size, PAGE_CACHE_WC) == 0) {
         vbe_active = true;
         
         c_puts("[VBE] Mode: ");
@@ -145,9 +151,16 @@ uint32_t *gpu_setup_framebuffer(void) {
         c_putc('0' + vbe_info->bpp % 10);
         c_puts(" LFB\n");
         
-        /* Allocate backbuffer for double buffering */
-        backbuffer_size = vbe_info->width * vbe_info->height * 4;
-        backbuffer = (uint32_t*)kmalloc(backbuffer_size);
+        /* Allocate backbuffer for double buffering, reusing the one from
+         * an earlier setup if the mode has not changed */
+        uint32_t size = vbe_info->width * vbe_info->height * 4;
+        if (backbuffer == (uint32_t*)vbe_info->framebuffer) backbuffer = NULL;
+        if (backbuffer && backbuffer_size != size) {
+            kfree(backbuffer);
+            backbuffer = NULL;
+        }
+        backbuffer_size = size;
+        if (!backbuffer) backbuffer = (uint32_t*)kmalloc(backbuffer_size);
         
         if (backbuffer) {
             c_puts("[VBE] Double buffering enabled\n");
@@ -187,21 +200,10 @@ int gpu_flush(void) {
         /* Wait for vsync to prevent tearing */
         wait_vsync();
         
-        /* Copy backbuffer to framebuffer - optimized with 32-bit copies */
-        uint32_t *fb = (uint32_t*)vbe_info->framebuffer;
+        /* Copy backbuffer to framebuffer. The LFB is write-combined, so
+         * the blit kernel streams whole lines where the CPU can. */
         uint32_t count = vbe_info->width * vbe_info->height;
-        
-        /* Use rep movsd for fastest copy */
-        __asm__ volatile (
-            "cld\n\t"
-            "rep movsl"
-            : "+S"(backbuffer), "+D"(fb), "+c"(count)
-            :
-            : "memory"
-        );
-        
-        /* Reset pointers after copy (movsl advances them) */
-        /* Not needed since we don't use them after */
+        cpu_ops.blit((void*)vbe_info->framebuffer, backbuffer, count * 4);
     }
     
     return 0;
@@ -241,14 +243,8 @@ void vbe_clear(uint32_t color) {
     uint32_t *target = get_draw_target();
     uint32_t count = vbe_info->width * vbe_info->height;
     
-    /* Fast fill using rep stosd */
-    __asm__ volatile (
-        "cld\n\t"
-        "rep stosl"
-        : "+D"(target), "+c"(count)
-        : "a"(color)
-        : "memory"
-    );
+    /* A full-screen clear is bigger than the cache; stream it */
+    cpu_ops.clear(target, color, count * 4);
 }
 
 void vbe_draw_pixel(int x, int y, uint32_t color) {
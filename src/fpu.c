@@ -0,0 +1,43 @@
+/*
+ * RO-DOS FPU/SSE Setup
+ * Enables x87 and SSE state for include/fpu.h
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../include/fpu.h"
+#include "../include/cpu.h"
+
+#define CR0_MP      0x00000002u     /* WAIT honours TS */
+#define CR0_EM      0x00000004u     /* no FPU: trap FPU instructions */
+#define CR0_TS      0x00000008u
+#define CR0_NE      0x00000020u     /* FPU errors raise #MF, not IRQ13 */
+#define CR4_OSFXSR      0x00000200u
+#define CR4_OSXMMEXCPT  0x00000400u /* SIMD errors raise #XM, not #UD */
+
+/* All SIMD exceptions masked, round to nearest */
+#define MXCSR_DEFAULT   0x1F80u
+
+bool fpu_fxsr = false;
+bool fpu_sse2 = false;
+
+void fpu_init(void) {
+    if (!cpu_has(CPU_FEAT_FPU)) return;
+
+    uint32_t cr0;
+    __asm__ volatile ("mov %%cr0, %0" : "=r"(cr0));
+    cr0 = (cr0 & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE;
+    __asm__ volatile ("mov %0, %%cr0\n\tfninit" : : "r"(cr0));
+
+    if (!cpu_has(CPU_FEAT_FXSR | CPU_FEAT_SSE)) return;
+
+    uint32_t cr4;
+    __asm__ volatile ("mov %%cr4, %0" : "=r"(cr4));
+    __asm__ volatile ("mov %0, %%cr4" : : "r"(cr4 | CR4_OSFXSR | CR4_OSXMMEXCPT));
+
+    uint32_t mxcsr = MXCSR_DEFAULT;
+    __asm__ volatile ("ldmxcsr %0" : : "m"(mxcsr));
+
+    fpu_fxsr = true;
+    fpu_sse2 = cpu_has(CPU_FEAT_SSE2);
+}
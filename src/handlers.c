@@ -1,6 +1,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "../include/clock.h"
+#include "../include/cpu.h"
+#include "../include/backtrace.h"
 
 /* PIC ports and constants */
 #define PIC1_CMD     0x20
@@ -34,6 +37,7 @@ void set_shutting_down(void) {
 /* External kernel/IO functions */
 extern void c_puts(const char* s);
 extern void set_attr(uint8_t a);
+extern int syscall_handler(int num, int arg1, int arg2, int arg3);
 
 /* Register structure */
 typedef struct {
@@ -101,20 +105,115 @@ void pic_remap(void) {
     outb(PIC2_DATA, 0xFF);
 }
 
+/* Sampling profiler hook (profile.c) */
+extern void profile_sample(uint32_t eip, uint32_t ebp);
+
+/* IRQ0 may run faster than 18.2 Hz while profiling; timer_ticks still
+ * advances once per 65536 PIT clocks */
+static volatile uint32_t timer_divide = 1;
+static volatile uint32_t timer_sub = 0;
+
 void timer_handler(registers_t *regs) {
-    (void)regs;
-    timer_ticks++;
+    profile_sample(regs->eip, regs->ebp);
+    if (++timer_sub >= timer_divide) {
+        timer_sub = 0;
+        timer_ticks++;
+    }
+}
+
+/* Run IRQ0 at mult x 18.2 Hz (1 restores the BIOS rate) */
+void timer_set_multiplier(uint32_t mult) {
+    if (mult < 1) mult = 1;
+    if (mult > 256) mult = 256;
+    uint32_t divisor = 65536 / mult;   /* 65536 is written as 0 */
+
+    uint32_t flags;
+    __asm__ volatile ("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    outb(0x43, 0x36);                  /* Channel 0, lobyte/hibyte, mode 3 */
+    outb(0x40, divisor & 0xFF);
+    outb(0x40, (divisor >> 8) & 0xFF);
+    timer_divide = mult;
+    timer_sub = 0;
+    __asm__ volatile ("pushl %0; popfl" : : "r"(flags) : "memory", "cc");
+}
+
+static const char *const exception_names[32] = {
+    "Divide error", "Debug", "NMI", "Breakpoint", "Overflow",
+    "BOUND range exceeded", "Invalid opcode", "Device not available",
+    "Double fault", "Coprocessor segment overrun", "Invalid TSS",
+    "Segment not present", "Stack-segment fault", "General protection fault",
+    "Page fault", "Reserved", "x87 floating-point error", "Alignment check",
+    "Machine check", "SIMD floating-point error", "Virtualization exception",
+    "Control protection exception", "Reserved", "Reserved", "Reserved",
+    "Reserved", "Reserved", "Reserved", "Hypervisor injection",
+    "VMM communication", "Security exception", "Reserved",
+};
+
+static void exc_put_hex(uint32_t v) {
+    static const char hex[] = "0123456789ABCDEF";
+    char buf[11] = "0x";
+    for (int i = 0; i < 8; i++) buf[2 + i] = hex[(v >> (28 - i * 4)) & 0xF];
+    buf[10] = '\0';
+    c_puts(buf);
+}
+
+static void exc_put_reg(const char *name, uint32_t v) {
+    c_puts(name);
+    exc_put_hex(v);
+    c_puts("  ");
 }
 
 void isr_handler(registers_t *regs) {
+    if (regs->int_no == 0x80) {
+        regs->eax = (uint32_t)syscall_handler((int)regs->eax, (int)regs->ebx,
+                                              (int)regs->ecx, (int)regs->edx);
+        return;
+    }
+
     if (shutting_down) {
         /* During shutdown, just halt - don't print error */
         __asm__ volatile("cli");
         for (;;) { __asm__ volatile("hlt"); }
     }
-    
-    (void)regs;
-    c_puts("\nCPU EXCEPTION - SYSTEM HALTED\n");
+
+    set_attr(0x4F);
+    c_puts("\nCPU EXCEPTION ");
+    char num[3] = {(char)('0' + regs->int_no / 10), (char)('0' + regs->int_no % 10), '\0'};
+    c_puts(num);
+    c_puts(": ");
+    c_puts(regs->int_no < 32 ? exception_names[regs->int_no] : "Unknown");
+    c_puts(" - SYSTEM HALTED\n");
+    set_attr(0x07);
+
+    c_puts("EIP: ");
+    exc_put_hex(regs->eip);
+    c_puts(" ");
+    backtrace_put_symbol(regs->eip);
+    c_puts("\n");
+    exc_put_reg("ERR: ", regs->err_code);
+    exc_put_reg("EFLAGS: ", regs->eflags);
+    if (regs->int_no == 14) {
+        uint32_t cr2;
+        __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
+        exc_put_reg("CR2: ", cr2);
+    }
+    c_puts("\n");
+    exc_put_reg("EAX: ", regs->eax);
+    exc_put_reg("EBX: ", regs->ebx);
+    exc_put_reg("ECX: ", regs->ecx);
+    exc_put_reg("EDX: ", regs->edx);
+    c_puts("\n");
+    exc_put_reg("ESI: ", regs->esi);
+    exc_put_reg("EDI: ", regs->edi);
+    exc_put_reg("EBP: ", regs->ebp);
+    /* pushad saved ESP after the CPU pushed EIP, CS and EFLAGS (no
+     * privilege change) and the stub pushed the vector and error code */
+    exc_put_reg("ESP: ", regs->esp + 20);
+    c_puts("\n");
+
+    c_puts("Backtrace:\n");
+    backtrace_print(regs->eip, regs->ebp);
+
     __asm__ volatile("cli");
     for (;;) { __asm__ volatile("hlt"); }
 }
@@ -124,6 +223,106 @@ uint32_t get_ticks(void) {
     return timer_ticks;
 }
 
+/*
+ * High-resolution clock
+ * The TSC is calibrated once against PIT channel 2 (the speaker channel,
+ * so the IRQ0 tick rate is untouched). All conversions go through
+ * clock_div64() because no libgcc is linked for 64-bit division.
+ */
+#define PIT_HZ           1193182
+#define PIT_CAL_MS       10
+#define PIT_CAL_LATCH    ((PIT_HZ * PIT_CAL_MS) / 1000)
+
+static uint32_t tsc_khz = 0;
+static uint64_t tsc_base = 0;
+
+uint64_t clock_div64(uint64_t n, uint32_t d, uint32_t *rem) {
+    uint32_t hi = (uint32_t)(n >> 32);
+    uint32_t lo = (uint32_t)n;
+    uint32_t qhi = hi / d;
+    uint32_t r = hi % d;
+    uint32_t qlo;
+    __asm__ ("divl %4" : "=a"(qlo), "=d"(r) : "a"(lo), "d"(r), "rm"(d));
+    if (rem) *rem = r;
+    return ((uint64_t)qhi << 32) | qlo;
+}
+
+/* One PIT channel 2 one-shot of PIT_CAL_MS; returns elapsed TSC cycles or 0 */
+static uint32_t clock_measure_once(void) {
+    /* Gate on, speaker off */
+    outb(0x61, (inb(0x61) & ~0x02) | 0x01);
+    /* Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count) */
+    outb(0x43, 0xB0);
+    outb(0x42, PIT_CAL_LATCH & 0xFF);
+    outb(0x42, (PIT_CAL_LATCH >> 8) & 0xFF);
+
+    uint64_t t0 = rdtsc();
+    uint32_t spins = 0;
+    while (!(inb(0x61) & 0x20)) {
+        if (++spins > 10000000) return 0;   /* No PIT output - give up */
+    }
+    uint64_t t1 = rdtsc();
+    return (uint32_t)(t1 - t0);
+}
+
+void clock_init(void) {
+    if (!cpu_has(CPU_FEAT_TSC)) return;     /* No TSC - stay on PIT ticks */
+
+    /* Take the shortest of a few runs; anything that stalls us only adds */
+    uint32_t best = 0;
+    for (int i = 0; i < 3; i++) {
+        uint32_t c = clock_measure_once();
+        if (c && (best == 0 || c < best)) best = c;
+    }
+    if (best < PIT_CAL_MS) return;
+
+    tsc_khz = best / PIT_CAL_MS;
+    tsc_base = rdtsc();
+}
+
+uint64_t clock_tsc(void) {
+    return cpu_has(CPU_FEAT_TSC) ? rdtsc() : 0;
+}
+
+uint32_t clock_tsc_khz(void) {
+    return tsc_khz;
+}
+
+uint64_t clock_tsc_base(void) {
+    return tsc_base;
+}
+
+uint64_t clock_cycles_to_us(uint64_t cycles) {
+    if (!tsc_khz) return 0;
+    uint32_t rem;
+    uint64_t ms = clock_div64(cycles, tsc_khz, &rem);
+    return ms * 1000 + clock_div64((uint64_t)rem * 1000, tsc_khz, NULL);
+}
+
+uint64_t clock_ns(void) {
+    if (!tsc_khz) {
+        /* 1 PIT tick = 65536 / 1193182 s = 54925439 ns */
+        return (uint64_t)timer_ticks * 54925439ull;
+    }
+    uint32_t rem;
+    uint64_t ms = clock_div64(rdtsc() - tsc_base, tsc_khz, &rem);
+    return ms * 1000000 + clock_div64((uint64_t)rem * 1000000, tsc_khz, NULL);
+}
+
+uint64_t clock_us(void) {
+    if (!tsc_khz) {
+        return clock_div64((uint64_t)timer_ticks * 54925439ull, 1000, NULL);
+    }
+    return clock_cycles_to_us(rdtsc() - tsc_base);
+}
+
+uint32_t clock_ms(void) {
+    if (!tsc_khz) {
+        return (uint32_t)clock_div64((uint64_t)timer_ticks * 54925439ull, 1000000, NULL);
+    }
+    return (uint32_t)clock_div64(rdtsc() - tsc_base, tsc_khz, NULL);
+}
+
 
 int disk_read_lba(uint32_t lba, uint32_t count, void* buffer) {
     uint8_t status;
@@ -0,0 +1,184 @@
+/*
+ * MEM /TOP and MEM /LEAKS - Heap Profiler
+ * Sums live heap memory per allocation site from the tags kmalloc keeps
+ * in each block (memory.asm), and compares against a marked snapshot.
+ *
+ *   MEM /TOP [N]       top N sites by live bytes (default 10)
+ *   MEM /LEAKS MARK    snapshot the heap
+ *   MEM /LEAKS [N]     sites whose live bytes changed since the mark,
+ *                      with how many of their blocks are newer than it
+ *
+ * The tables are static: the profiler must not use the heap it walks.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/backtrace.h"
+#include "../include/kprintf.h"
+
+extern void c_puts(const char *s);
+
+typedef void (*mem_walk_fn)(void *ctx, void *ptr, uint32_t size, uint32_t site, uint32_t seq);
+extern void mem_walk(mem_walk_fn fn, void *ctx);
+extern uint32_t mem_alloc_seq;
+
+#define puts c_puts
+
+#define HEAPPROF_MAX_SITES   64
+#define HEAPPROF_DEFAULT_TOP 10
+
+typedef struct {
+    uint32_t site;
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t new_count;     /* allocated after the mark */
+    uint32_t new_bytes;
+    uint32_t mark_bytes;    /* live at the mark */
+} heap_site_t;
+
+typedef struct {
+    heap_site_t sites[HEAPPROF_MAX_SITES];
+    uint32_t nsites;
+    uint32_t since;         /* sequence number of the mark */
+    uint32_t total_count;
+    uint32_t total_bytes;
+    uint32_t lost;          /* blocks whose site did not fit in the table */
+} heap_census_t;
+
+static heap_census_t census;
+static heap_census_t mark;
+static bool mark_taken = false;
+
+static heap_site_t *hp_site(heap_census_t *c, uint32_t site) {
+    for (uint32_t i = 0; i < c->nsites; i++) {
+        if (c->sites[i].site == site) return &c->sites[i];
+    }
+    if (c->nsites == HEAPPROF_MAX_SITES) return NULL;
+    heap_site_t *s = &c->sites[c->nsites++];
+    s->site = site;
+    s->count = s->bytes = 0;
+    s->new_count = s->new_bytes = 0;
+    s->mark_bytes = 0;
+    return s;
+}
+
+static void hp_count(void *ctx, void *ptr, uint32_t size, uint32_t site, uint32_t seq) {
+    heap_census_t *c = (heap_census_t *)ctx;
+    (void)ptr;
+    c->total_count++;
+    c->total_bytes += size;
+    heap_site_t *s = hp_site(c, site);
+    if (!s) {
+        c->lost++;
+        return;
+    }
+    s->count++;
+    s->bytes += size;
+    /* Untagged small objects (seq 0) have no age */
+    if (mark_taken && seq > c->since) {
+        s->new_count++;
+        s->new_bytes += size;
+    }
+}
+
+static void hp_take(heap_census_t *c) {
+    c->nsites = 0;
+    c->since = mark.since;
+    c->total_count = c->total_bytes = 0;
+    c->lost = 0;
+    mem_walk(hp_count, c);
+}
+
+static void hp_put_site(uint32_t site) {
+    if (site == 0) {
+        puts("(small objects; build with HEAP_TRACK=1 to split them)");
+    } else {
+        backtrace_put_symbol(site);
+    }
+}
+
+static uint32_t hp_parse_top(const char *args) {
+    uint32_t n = 0;
+    while (*args == ' ') args++;
+    while (*args >= '0' && *args <= '9') n = n * 10 + (uint32_t)(*args++ - '0');
+    return n ? n : HEAPPROF_DEFAULT_TOP;
+}
+
+/* Move the largest key(s) to the front; only the first n are printed */
+static void hp_sort(heap_census_t *c, uint32_t n, bool by_change) {
+    for (uint32_t i = 0; i < n && i < c->nsites; i++) {
+        uint32_t best = i;
+        for (uint32_t j = i + 1; j < c->nsites; j++) {
+            const heap_site_t *a = &c->sites[j], *b = &c->sites[best];
+            uint32_t ka = by_change ? a->new_bytes : a->bytes;
+            uint32_t kb = by_change ? b->new_bytes : b->bytes;
+            if (ka > kb) best = j;
+        }
+        heap_site_t tmp = c->sites[i];
+        c->sites[i] = c->sites[best];
+        c->sites[best] = tmp;
+    }
+}
+
+int heapprof_top(const char *args) {
+    uint32_t top = hp_parse_top(args);
+    hp_take(&census);
+    hp_sort(&census, top, false);
+
+    kprintf("Live heap: %u bytes in %u allocations, %u sites\n",
+            census.total_bytes, census.total_count, census.nsites);
+    puts("     Bytes  Count  Site\n");
+    for (uint32_t i = 0; i < top && i < census.nsites; i++) {
+        const heap_site_t *s = &census.sites[i];
+        kprintf("%10u%7u  ", s->bytes, s->count);
+        hp_put_site(s->site);
+        puts("\n");
+    }
+    if (census.lost)
+        kprintf("%u allocations from further sites not shown\n", census.lost);
+    return 0;
+}
+
+int heapprof_leaks(const char *args) {
+    while (*args == ' ') args++;
+    bool set = (args[0] == 'M' || args[0] == 'm');
+    if (set || !mark_taken) {
+        mark_taken = false;
+        mark.since = mem_alloc_seq;
+        hp_take(&mark);
+        mark_taken = true;
+        kprintf("Heap snapshot taken: %u bytes in %u allocations.\n"
+                "Run MEM /LEAKS later to see what is still live.\n",
+                mark.total_bytes, mark.total_count);
+        return 0;
+    }
+
+    uint32_t top = hp_parse_top(args);
+    hp_take(&census);
+    for (uint32_t i = 0; i < mark.nsites; i++) {
+        heap_site_t *s = hp_site(&census, mark.sites[i].site);
+        if (s) s->mark_bytes = mark.sites[i].bytes;
+    }
+    hp_sort(&census, census.nsites, true);
+
+    kprintf("Since the snapshot: %u bytes in %u allocations -> %u bytes\n",
+            mark.total_bytes, mark.total_count, census.total_bytes);
+    puts("     Bytes    Change    New  Site\n");
+    uint32_t shown = 0;
+    for (uint32_t i = 0; i < census.nsites && shown < top; i++) {
+        const heap_site_t *s = &census.sites[i];
+        if (s->new_count == 0 && s->bytes == s->mark_bytes) continue;
+        /* Signed change, e.g. "+4096", right-aligned like the counts */
+        char change[12];
+        bool grew = s->bytes >= s->mark_bytes;
+        ksnprintf(change, sizeof(change), "%c%u", grew ? '+' : '-',
+                  grew ? s->bytes - s->mark_bytes : s->mark_bytes - s->bytes);
+        kprintf("%10u%10s%7u  ", s->bytes, change, s->new_count);
+        hp_put_site(s->site);
+        puts("\n");
+        shown++;
+    }
+    if (shown == 0) puts("  (no change)\n");
+    return 0;
+}
@@ -4,6 +4,8 @@ extern timer_handler
 extern syscall_handler
 extern isr_handler
 extern pic_remap
+extern serial_irq_handler
+extern fpu_fxsr
 
 %define PIC1_CMD    0x20
 %define PIC1_DATA   0x21
@@ -54,6 +56,27 @@ global c_mouse_read
 global init_interrupts
 global syscall_stub
 
+; Save the SSE/x87 state below the register frame while handlers run, so
+; C code that copies with XMM registers (simd.c) does not clobber the
+; interrupted code's. EBP holds the frame; FPU_RESTORE puts ESP back on it.
+%macro FPU_SAVE 0
+    mov ebp, esp
+    cmp byte [fpu_fxsr], 0
+    je %%skip
+    sub esp, 512
+    and esp, ~15
+    fxsave [esp]
+%%skip:
+%endmacro
+
+%macro FPU_RESTORE 0
+    cmp byte [fpu_fxsr], 0
+    je %%skip
+    fxrstor [esp]
+%%skip:
+    mov esp, ebp
+%endmacro
+
 ; Common ISR Stub
 isr_common_stub:
     pushad
@@ -64,9 +87,12 @@ isr_common_stub:
     mov ax, 0x10
     mov ds, ax
     mov es, ax
-    push esp
+    cld                 ; C code expects DF clear (memmove may be mid-copy with it set)
+    FPU_SAVE
+    push ebp
     call isr_handler
     add esp, 4
+    FPU_RESTORE
     pop gs
     pop fs
     pop es
@@ -85,8 +111,10 @@ irq_common_stub:
     mov ax, 0x10
     mov ds, ax
     mov es, ax
+    cld                 ; as in isr_common_stub
+    FPU_SAVE
 
-    mov eax, [esp + 48] ; Get Int No from stack
+    mov eax, [ebp + 48] ; Get Int No from stack
 
     ; Check if Mouse (IRQ 12 = INT 44)
     cmp eax, 44
@@ -112,7 +140,7 @@ irq_common_stub:
 
 .check_keyboard:
     cmp eax, 33         ; Check if Keyboard (IRQ 1)
-    jne .timer_check
+    jne .check_serial
 
     in al, 0x60         ; Read scancode
     
@@ -317,8 +345,14 @@ irq_common_stub:
     mov byte [kb_ctrl], 0
     jmp .done_irq
 
+.check_serial:
+    cmp eax, 36         ; COM1 (IRQ 4 = INT 36)
+    jne .timer_check
+    call serial_irq_handler
+    jmp .done_irq
+
 .timer_check:
-    push esp
+    push ebp
     call timer_handler
     add esp, 4
 
@@ -326,6 +360,7 @@ irq_common_stub:
     mov al, 0x20
     out 0x20, al
 .irq_done_no_eoi:       ; Used by handlers that already sent EOI
+    FPU_RESTORE
     pop gs
     pop fs
     pop es
@@ -342,6 +377,14 @@ isr%1:
     jmp isr_common_stub
 %endmacro
 
+; CPU-pushed error code already on the stack
+%macro ISR_ERR 1
+global isr%1
+isr%1:
+    push dword %1
+    jmp isr_common_stub
+%endmacro
+
 %macro IRQ_STUB 2
 global irq%1
 irq%1:
@@ -350,10 +393,42 @@ irq%1:
     jmp irq_common_stub
 %endmacro
 
+; CPU exceptions 0-31; 8, 10-14, 17, 21, 29 and 30 push an error code
 ISR_NOERR 0
-ISR_NOERR 13
+ISR_NOERR 1
+ISR_NOERR 2
+ISR_NOERR 3
+ISR_NOERR 4
+ISR_NOERR 5
+ISR_NOERR 6
+ISR_NOERR 7
+ISR_ERR 8
+ISR_NOERR 9
+ISR_ERR 10
+ISR_ERR 11
+ISR_ERR 12
+ISR_ERR 13
+ISR_ERR 14
+ISR_NOERR 15
+ISR_NOERR 16
+ISR_ERR 17
+ISR_NOERR 18
+ISR_NOERR 19
+ISR_NOERR 20
+ISR_ERR 21
+ISR_NOERR 22
+ISR_NOERR 23
+ISR_NOERR 24
+ISR_NOERR 25
+ISR_NOERR 26
+ISR_NOERR 27
+ISR_NOERR 28
+ISR_ERR 29
+ISR_ERR 30
+ISR_NOERR 31
 IRQ_STUB 0, 32
 IRQ_STUB 1, 33
+IRQ_STUB 4, 36   ; COM1 serial (IRQ4 = INT 36)
 IRQ_STUB 12, 44  ; PS/2 Mouse (IRQ12 = INT 44)
 
 getkey_block:
@@ -369,15 +444,35 @@ getkey_block:
     mov eax, [key_buffer_tail]
     shl eax, 1 ; Multiply for word access
     movzx eax, word [key_buffer + eax] ; Read 16-bit key
-    mov ebx, [key_buffer_tail]
-    inc ebx
-    and ebx, 255
-    mov [key_buffer_tail], ebx
+    mov ecx, [key_buffer_tail]  ; ecx, not ebx - callee-saved in C
+    inc ecx
+    and ecx, 255
+    mov [key_buffer_tail], ecx
     sti
     ret
 
 c_getkey: jmp getkey_block
 
+; void c_kb_push(uint16_t key) - queue a key word from a non-keyboard
+; source (serial console). Drops the key if the buffer is full.
+global c_kb_push
+c_kb_push:
+    push ebx
+    pushfd
+    cli
+    mov ebx, [key_buffer_head]
+    lea eax, [ebx + 1]
+    and eax, 255
+    cmp eax, [key_buffer_tail]
+    je .full
+    mov cx, [esp + 12]
+    mov [key_buffer + ebx*2], cx
+    mov [key_buffer_head], eax
+.full:
+    popfd
+    pop ebx
+    ret
+
 global c_kb_hit
 c_kb_hit:
     mov eax, [key_buffer_tail]
@@ -394,12 +489,12 @@ c_mouse_read:
     cmp eax, [mouse_head]
     je .empty
     
-    mov ebx, eax
-    movzx eax, byte [mouse_buffer + ebx]
+    mov ecx, eax
+    movzx eax, byte [mouse_buffer + ecx]
     
-    inc ebx
-    and ebx, mouse_buffer_size - 1
-    mov [mouse_tail], ebx
+    inc ecx
+    and ecx, mouse_buffer_size - 1
+    mov [mouse_tail], ecx
     ret
 
 .empty:
@@ -428,16 +523,17 @@ install_isr:
 
 init_interrupts:
     call pic_remap
-    
-    mov eax, 0
-    mov ebx, isr0
-    mov cl, 0x8E
-    call install_isr
 
-    mov eax, 13
-    mov ebx, isr13
+    ; exception vectors 0-31
+    xor esi, esi
+.exception_loop:
+    mov eax, esi
+    mov ebx, [isr_stub_table + esi*4]
     mov cl, 0x8E
     call install_isr
+    inc esi
+    cmp esi, 32
+    jb .exception_loop
 
     mov eax, 32
     mov ebx, irq0
@@ -449,6 +545,11 @@ init_interrupts:
     mov cl, 0x8E
     call install_isr
 
+    mov eax, 36          ; IRQ4 = INT 36 (COM1)
+    mov ebx, irq4
+    mov cl, 0x8E
+    call install_isr
+
     mov eax, 44          ; IRQ12 = INT 44 (32 + 12)
     mov ebx, irq12
     mov cl, 0x8E
@@ -462,6 +563,13 @@ init_interrupts:
     lidt [idt_desc]
     ret
 
+align 4
+isr_stub_table:
+    dd isr0, isr1, isr2, isr3, isr4, isr5, isr6, isr7
+    dd isr8, isr9, isr10, isr11, isr12, isr13, isr14, isr15
+    dd isr16, isr17, isr18, isr19, isr20, isr21, isr22, isr23
+    dd isr24, isr25, isr26, isr27, isr28, isr29, isr30, isr31
+
 align 16
 idt_table: times 256 dq 0
 idt_desc:
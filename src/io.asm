@@ -16,9 +16,13 @@ VGA_DATA        equ 0x3D5
 CURSOR_HIGH     equ 0x0E
 CURSOR_LOW      equ 0x0F
 
+extern serial_mirror
+extern serial_putc
+
 section .text
   global c_putc
   global c_puts
+  global c_write
   global c_cls
   global set_attr
   global io_wait
@@ -111,6 +115,18 @@ scroll_up:
 
 ; Put Char
 putc:
+    push ebp
+    mov ebp, esp
+    push dword [ebp + 8]
+    call putc_raw
+    add esp, 4
+    call set_cursor_hardware
+    leave
+    ret
+
+; Put Char without moving the hardware cursor; strings update it once at
+; the end instead of paying four port writes per character
+putc_raw:
     push ebp
     mov ebp, esp
     push eax
@@ -118,6 +134,16 @@ putc:
     push ecx
     push edi
 
+    ; Mirror to the serial console when enabled
+    cmp byte [serial_mirror], 0
+    je .no_mirror
+    push edx
+    push dword [ebp + 8]
+    call serial_putc
+    add esp, 4
+    pop edx
+.no_mirror:
+
     mov al, byte [ebp + 8]
 
     cmp al, 0x0A
@@ -177,7 +203,6 @@ putc:
     mov dword [cursor_row], 24
 
 .done:
-    call set_cursor_hardware
     pop edi
     pop ecx
     pop ebx
@@ -199,13 +224,42 @@ puts:
     jz .end
     
     push eax
-    call putc
+    call putc_raw
     add esp, 4
     
     inc esi
     jmp .loop
 .end:
+    call set_cursor_hardware
+    pop eax
+    pop esi
+    leave
+    ret
+
+; Write len bytes from buf (c_write(buf, len)), NULs included
+console_write:
+    push ebp
+    mov ebp, esp
+    push esi
+    push ecx
+    push eax
+
+    mov esi, [ebp + 8]
+    mov ecx, [ebp + 12]
+.loop:
+    test ecx, ecx
+    jz .end
+    movzx eax, byte [esi]
+    push eax
+    call putc_raw
+    add esp, 4
+    inc esi
+    dec ecx
+    jmp .loop
+.end:
+    call set_cursor_hardware
     pop eax
+    pop ecx
     pop esi
     leave
     ret
@@ -231,6 +285,9 @@ c_putc:
 c_puts:
     jmp puts
 
+c_write:
+    jmp console_write
+
 c_cls:
     jmp cls
 
@@ -0,0 +1,160 @@
+/*
+ * RO-DOS IRQ Pool
+ * Lock-free fixed-block allocator for interrupt context (include/irqpool.h)
+ *
+ * Each class is one page run cut into equal blocks. Free blocks form a
+ * stack whose head is a {top, tag} pair swapped with lock cmpxchg8b; the
+ * tag changes on every pop and push, so an interrupt that pops and pushes
+ * the same block between another path's read and its swap makes the swap
+ * fail instead of linking a stale next pointer (the ABA problem).
+ *
+ * cmpxchg8b arrived with the Pentium. On a 486 the pool stays empty and
+ * every allocation returns NULL.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/irqpool.h"
+#include "../include/pmm.h"
+#include "../include/cpu.h"
+
+typedef union {
+    struct {
+        void *top;
+        uint32_t tag;
+    } s;
+    uint64_t raw;
+} irqpool_head_t;
+
+typedef struct {
+    irqpool_head_t head __attribute__((aligned(8)));
+    uint8_t *base;
+    uint8_t *end;
+    uint32_t block_size;
+    uint32_t count;
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t failures;
+} irqpool_class_t;
+
+/* Block sizes and their share of the budget in eighths */
+static const struct {
+    uint32_t size;
+    uint32_t share;
+} irqpool_layout[IRQPOOL_CLASSES] = {
+    { 64,                1 },   /* input events, small records */
+    { 256,               1 },
+    { IRQPOOL_MAX_BLOCK, 6 },   /* received frames */
+};
+
+static irqpool_class_t irqpool_class[IRQPOOL_CLASSES];
+static bool irqpool_ready = false;
+
+/* Swap *p from old to new if it still holds old; true on success */
+static inline bool irqpool_cas(volatile uint64_t *p, uint64_t old, uint64_t new) {
+    uint64_t prev = old;
+    __asm__ volatile ("lock cmpxchg8b %0"
+                      : "+m"(*p), "+A"(prev)
+                      : "b"((uint32_t)new), "c"((uint32_t)(new >> 32))
+                      : "memory", "cc");
+    return prev == old;
+}
+
+static void irqpool_push(irqpool_class_t *c, void *block) {
+    irqpool_head_t old, new;
+    do {
+        old.raw = c->head.raw;
+        *(void **)block = old.s.top;
+        new.s.top = block;
+        new.s.tag = old.s.tag + 1;
+    } while (!irqpool_cas(&c->head.raw, old.raw, new.raw));
+}
+
+static void *irqpool_pop(irqpool_class_t *c) {
+    irqpool_head_t old, new;
+    do {
+        old.raw = c->head.raw;
+        if (!old.s.top) return NULL;
+        /* May read a block another path just took; the tag check rejects it */
+        new.s.top = *(void * volatile *)old.s.top;
+        new.s.tag = old.s.tag + 1;
+    } while (!irqpool_cas(&c->head.raw, old.raw, new.raw));
+    return old.s.top;
+}
+
+void irqpool_init(void) {
+    if (irqpool_ready) return;
+    /* Needs cpu_init, which kernel_entry runs first */
+    if (!cpu_has(CPU_FEAT_CX8)) return;
+
+    uint32_t budget = pmm_total_pages() * (PMM_PAGE_SIZE / 256);
+    if (budget < IRQPOOL_MIN_BYTES) budget = IRQPOOL_MIN_BYTES;
+    if (budget > IRQPOOL_MAX_BYTES) budget = IRQPOOL_MAX_BYTES;
+
+    for (uint32_t i = 0; i < IRQPOOL_CLASSES; i++) {
+        irqpool_class_t *c = &irqpool_class[i];
+        uint32_t size = irqpool_layout[i].size;
+        uint32_t bytes = budget / 8 * irqpool_layout[i].share;
+        uint32_t pages = (bytes + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+
+        c->block_size = size;
+        c->head.raw = 0;
+        uint32_t run = pmm_alloc_pages(pages);
+        if (!run) continue;
+
+        /* Use the whole run; push in reverse so blocks come out in order */
+        c->base = (uint8_t *)run;
+        c->count = pages * PMM_PAGE_SIZE / size;
+        c->end = c->base + c->count * size;
+        for (uint32_t b = c->count; b-- > 0;) {
+            irqpool_push(c, c->base + b * size);
+        }
+    }
+    irqpool_ready = true;
+}
+
+void *irqpool_alloc(uint32_t size) {
+    if (!irqpool_ready) return NULL;
+    for (uint32_t i = 0; i < IRQPOOL_CLASSES; i++) {
+        irqpool_class_t *c = &irqpool_class[i];
+        if (size > c->block_size) continue;
+
+        void *block = irqpool_pop(c);
+        if (!block) {
+            __atomic_add_fetch(&c->failures, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+        uint32_t used = __atomic_add_fetch(&c->in_use, 1, __ATOMIC_RELAXED);
+        uint32_t hw = __atomic_load_n(&c->high_water, __ATOMIC_RELAXED);
+        while (used > hw &&
+               !__atomic_compare_exchange_n(&c->high_water, &hw, used, false,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+        return block;
+    }
+    return NULL;
+}
+
+void irqpool_free(void *ptr) {
+    uint8_t *p = (uint8_t *)ptr;
+    for (uint32_t i = 0; i < IRQPOOL_CLASSES; i++) {
+        irqpool_class_t *c = &irqpool_class[i];
+        if (p < c->base || p >= c->end) continue;
+        if ((uint32_t)(p - c->base) % c->block_size) return;
+        irqpool_push(c, p);
+        __atomic_sub_fetch(&c->in_use, 1, __ATOMIC_RELAXED);
+        return;
+    }
+}
+
+int irqpool_stats(uint32_t cls, irqpool_stats_t *st) {
+    if (!irqpool_ready || cls >= IRQPOOL_CLASSES) return -1;
+    const irqpool_class_t *c = &irqpool_class[cls];
+    st->block_size = c->block_size;
+    st->count = c->count;
+    st->in_use = c->in_use;
+    st->high_water = c->high_water;
+    st->failures = c->failures;
+    return 0;
+}
@@ -1,7 +1,16 @@
 [BITS 32]
 [EXTERN init_interrupts]
 [EXTERN io_init]
+[EXTERN serial_init]
+[EXTERN clock_init]
+[EXTERN cpu_init]
 [EXTERN mem_init]
+[EXTERN pmm_init]
+[EXTERN pmm_alloc_pages]
+[EXTERN paging_init]
+[EXTERN irqpool_init]
+[EXTERN boot_time_init]
+[EXTERN boot_mark]
 [EXTERN shell_main]
 [EXTERN get_ticks]
 [EXTERN puts]
@@ -12,6 +21,30 @@
 [EXTERN c_puts]
 [EXTERN set_attr]
 
+[EXTERN __bss_start]
+[EXTERN __bss_end]
+
+; boot phase IDs - keep in sync with include/boottime.h
+%define BOOT_INTERRUPTS  1
+%define BOOT_IO          2
+%define BOOT_SERIAL      3
+%define BOOT_CLOCK       4
+%define BOOT_BANNER      5
+%define BOOT_MEM         6
+%define BOOT_PAGING      7
+%define BOOT_IRQ_ENABLE  8
+%define BOOT_DELAY       9
+
+; initial heap, grown from the page allocator as kmalloc needs more
+%define HEAP_INITIAL_PAGES 4096     ; 16 MB
+
+; record the end of a boot phase (clobbers eax, ecx, edx)
+%macro BOOT_MARK 1
+    push dword %1
+    call boot_mark
+    add esp, 4
+%endmacro
+
 [GLOBAL kernel_entry]
 [GLOBAL sys_reboot]
 
@@ -33,6 +66,20 @@ kernel_entry:
 
     cld
 
+    ; clear .bss (linked above 1 MB, not part of the loaded image)
+    mov edi, __bss_start
+    mov ecx, __bss_end
+    sub ecx, edi
+    shr ecx, 2
+    xor eax, eax
+    rep stosd
+
+    ; CPUID, x87/SSE state and kernel dispatch. Nothing may read the TSC
+    ; before this: a CPU without one faults on rdtsc. The first boot mark
+    ; is taken here.
+    call cpu_init
+    call boot_time_init
+
     ; mask PICs fully initially
     mov al, 0xFF
     out 0x21, al
@@ -40,9 +87,19 @@ kernel_entry:
 
     ; initialize idt / pic
     call init_interrupts
+    BOOT_MARK BOOT_INTERRUPTS
 
     ; init io
     call io_init
+    BOOT_MARK BOOT_IO
+
+    ; COM1 console - mirrors output from here on if a UART is present
+    call serial_init
+    BOOT_MARK BOOT_SERIAL
+
+    ; calibrate the TSC against PIT channel 2 (needs interrupts off)
+    call clock_init
+    BOOT_MARK BOOT_CLOCK
 
     push dword kernel_ok_msg
     call puts
@@ -51,11 +108,22 @@ kernel_entry:
     push dword system_ready_msg
     call puts
     add esp, 4
+    BOOT_MARK BOOT_BANNER
 
-    ; init mem - Increased heap size to 16MB for better memory availability
-    mov eax, 0x00200000
-    mov ebx, 0x01000000     ; 16MB heap instead of 2MB
+    ; init mem - page allocator over the BIOS E820 map, then the heap
+    ; and the interrupt-safe block pool
+    call pmm_init
+    push dword HEAP_INITIAL_PAGES
+    call pmm_alloc_pages
+    add esp, 4
+    mov ebx, HEAP_INITIAL_PAGES * 4096
     call mem_init
+    call irqpool_init
+    BOOT_MARK BOOT_MEM
+
+    ; identity-mapped paging, 4 MB pages over all RAM
+    call paging_init
+    BOOT_MARK BOOT_PAGING
 
     push dword mem_init_msg
     call puts
@@ -65,20 +133,22 @@ kernel_entry:
     call puts
     add esp, 4
 
-    ; Unmask timer, keyboard, and cascade to slave (enable IRQ0, IRQ1, IRQ2)
-    mov al, 0xF8        ; 11111000 - IRQ0, IRQ1, IRQ2 enabled
+    ; Unmask timer, keyboard, cascade to slave and COM1 (IRQ0, IRQ1, IRQ2, IRQ4)
+    mov al, 0xE8        ; 11101000 - IRQ0, IRQ1, IRQ2, IRQ4 enabled
     out 0x21, al
     ; Unmask IRQ12 on slave PIC for PS/2 mouse
     mov al, 0xEF        ; 11101111 - IRQ12 enabled (bit 4 = IRQ12)
     out 0xA1, al
 
     sti
+    BOOT_MARK BOOT_IRQ_ENABLE
 
     ; small delay
     mov ecx, 5000000
 .delay:
     dec ecx
     jnz .delay
+    BOOT_MARK BOOT_DELAY
 
     push dword calling_shell_msg
     call puts
@@ -0,0 +1,193 @@
+/*
+ * RO-DOS Formatted Output
+ * ksnprintf / kprintf for include/kprintf.h
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include "../include/kprintf.h"
+
+/* Console (io.asm): len bytes, one cursor update */
+extern void c_write(const char *s, uint32_t len);
+
+/* Output cursor over a bounded buffer; len keeps counting past the end so
+ * the caller learns the full length */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} kp_out_t;
+
+static void kp_putc(kp_out_t *o, char c) {
+    if (o->len + 1 < o->size) o->buf[o->len] = c;
+    o->len++;
+}
+
+static void kp_pad(kp_out_t *o, char c, int n) {
+    while (n-- > 0) kp_putc(o, c);
+}
+
+/* Field of width characters holding s[0..n) */
+static void kp_field(kp_out_t *o, const char *s, int n, int width, bool left, char pad) {
+    if (!left) kp_pad(o, pad, width - n);
+    for (int i = 0; i < n; i++) kp_putc(o, s[i]);
+    if (left) kp_pad(o, ' ', width - n);
+}
+
+static int kp_utoa(uint32_t v, char *tmp, uint32_t base, bool upper) {
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    int n = 0;
+    do {
+        tmp[n++] = digits[v % base];
+        v /= base;
+    } while (v);
+    /* Digits came out lowest first */
+    for (int i = 0; i < n / 2; i++) {
+        char t = tmp[i];
+        tmp[i] = tmp[n - 1 - i];
+        tmp[n - 1 - i] = t;
+    }
+    return n;
+}
+
+static void kp_number(kp_out_t *o, uint32_t v, bool neg, uint32_t base, bool upper,
+                      int width, bool left, bool zero) {
+    char tmp[12];
+    int n = kp_utoa(v, tmp, base, upper);
+    if (neg) {
+        if (zero && !left) {
+            /* Sign goes before the zeros: -0042 */
+            kp_putc(o, '-');
+            kp_field(o, tmp, n, width - 1, false, '0');
+            return;
+        }
+        char s[13];
+        s[0] = '-';
+        for (int i = 0; i < n; i++) s[i + 1] = tmp[i];
+        kp_field(o, s, n + 1, width, left, ' ');
+        return;
+    }
+    kp_field(o, tmp, n, width, left, zero && !left ? '0' : ' ');
+}
+
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list ap) {
+    kp_out_t o = { buf, buf ? size : 0, 0 };
+    if (!fmt) fmt = "";
+
+    while (*fmt) {
+        if (*fmt != '%') {
+            kp_putc(&o, *fmt++);
+            continue;
+        }
+        fmt++;
+
+        bool left = false, zero = false;
+        for (;; fmt++) {
+            if (*fmt == '-') left = true;
+            else if (*fmt == '0') zero = true;
+            else break;
+        }
+        int width = 0;
+        while (*fmt >= '0' && *fmt <= '9') width = width * 10 + (*fmt++ - '0');
+
+        char tmp[24];
+        switch (*fmt) {
+        case 'd': {
+            int32_t v = va_arg(ap, int32_t);
+            uint32_t mag = v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+            kp_number(&o, mag, v < 0, 10, false, width, left, zero);
+            break;
+        }
+        case 'u':
+            kp_number(&o, va_arg(ap, uint32_t), false, 10, false, width, left, zero);
+            break;
+        case 'x':
+        case 'X':
+            kp_number(&o, va_arg(ap, uint32_t), false, 16, *fmt == 'X', width, left, zero);
+            break;
+        case 'c':
+            tmp[0] = (char)va_arg(ap, int);
+            kp_field(&o, tmp, 1, width, left, ' ');
+            break;
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            if (!s) s = "(null)";
+            int n = 0;
+            while (s[n]) n++;
+            kp_field(&o, s, n, width, left, ' ');
+            break;
+        }
+        case 'i':
+            if (fmt[1] == 'p') {
+                uint32_t ip = va_arg(ap, uint32_t);
+                int n = 0;
+                for (int shift = 24; shift >= 0; shift -= 8) {
+                    n += kp_utoa((ip >> shift) & 0xFF, tmp + n, 10, false);
+                    if (shift) tmp[n++] = '.';
+                }
+                kp_field(&o, tmp, n, width, left, ' ');
+                fmt++;
+            } else {
+                /* Plain %i is %d */
+                int32_t v = va_arg(ap, int32_t);
+                uint32_t mag = v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+                kp_number(&o, mag, v < 0, 10, false, width, left, zero);
+            }
+            break;
+        case 'm':
+            if (fmt[1] == 'a' && fmt[2] == 'c') {
+                const uint8_t *mac = va_arg(ap, const uint8_t *);
+                int n = 0;
+                for (int i = 0; i < 6; i++) {
+                    uint8_t b = mac ? mac[i] : 0;
+                    tmp[n++] = "0123456789abcdef"[b >> 4];
+                    tmp[n++] = "0123456789abcdef"[b & 0xF];
+                    if (i < 5) tmp[n++] = ':';
+                }
+                kp_field(&o, tmp, n, width, left, ' ');
+                fmt += 2;
+                break;
+            }
+            kp_putc(&o, '%');
+            kp_putc(&o, 'm');
+            break;
+        case '%':
+            kp_putc(&o, '%');
+            break;
+        case '\0':
+            /* Lone % at the end */
+            kp_putc(&o, '%');
+            continue;
+        default:
+            /* Unknown conversion: print it as written */
+            kp_putc(&o, '%');
+            kp_putc(&o, *fmt);
+            break;
+        }
+        fmt++;
+    }
+
+    if (o.size) o.buf[o.len < o.size ? o.len : o.size - 1] = '\0';
+    return (int)o.len;
+}
+
+int ksnprintf(char *buf, size_t size, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = kvsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+int kprintf(const char *fmt, ...) {
+    char buf[KPRINTF_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = kvsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n > KPRINTF_MAX - 1) n = KPRINTF_MAX - 1;
+    c_write(buf, (uint32_t)n);
+    return n;
+}
@@ -0,0 +1,85 @@
+/*
+ * RO-DOS Kernel Symbol Lookup
+ * Binary search over the compressed table generated by tools/gen_ksyms.py
+ *
+ * Addresses are stored as a 32-bit base per block of KSYM_BLOCK symbols
+ * plus 16-bit offsets; names are byte-pair encoded token strings. See the
+ * generator for the exact layout.
+ */
+
+#include "../include/ksyms.h"
+#include <stddef.h>
+
+#define KSYM_BLOCK 16
+
+/* Generated table (build/obj/<profile>/ksyms_table.c) */
+extern const uint32_t ksym_count;
+extern const uint32_t ksym_block_addrs[];
+extern const uint16_t ksym_addr_offs[];
+extern const uint16_t ksym_block_names[];
+extern const uint8_t ksym_names[];
+extern const uint16_t ksym_token_index[];
+extern const char ksym_token_table[];
+
+/* End of .text/.rodata (link.ld) */
+extern char __text_end[];
+
+uint32_t ksym_total(void) {
+    return ksym_count;
+}
+
+uint32_t ksym_addr(int idx) {
+    if (idx < 0 || (uint32_t)idx >= ksym_count) return 0;
+    return ksym_block_addrs[idx / KSYM_BLOCK] + ksym_addr_offs[idx];
+}
+
+int ksym_find(uint32_t addr) {
+    if (ksym_count == 0 || addr < ksym_block_addrs[0] || addr >= (uint32_t)__text_end) {
+        return -1;
+    }
+
+    /* Last entry whose address is <= addr */
+    uint32_t lo = 0, hi = ksym_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (ksym_addr((int)mid) <= addr) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return (int)lo;
+}
+
+int ksym_name_copy(int idx, char *buf, uint32_t size) {
+    if (size == 0) return 0;
+    buf[0] = '\0';
+    if (idx < 0 || (uint32_t)idx >= ksym_count) return 0;
+
+    /* Skip to the entry within its block */
+    const uint8_t *p = &ksym_names[ksym_block_names[idx / KSYM_BLOCK]];
+    for (int i = idx % KSYM_BLOCK; i > 0; i--) p += 1 + p[0];
+
+    uint32_t n = 0;
+    uint8_t len = *p++;
+    for (uint8_t i = 0; i < len; i++) {
+        const char *t = &ksym_token_table[ksym_token_index[p[i]]];
+        while (*t && n + 1 < size) buf[n++] = *t++;
+    }
+    buf[n] = '\0';
+    return (int)n;
+}
+
+const char *ksym_name(int idx) {
+    static char name[KSYM_NAME_MAX];
+    if (idx < 0 || (uint32_t)idx >= ksym_count) return NULL;
+    ksym_name_copy(idx, name, sizeof(name));
+    return name;
+}
+
+const char *ksym_lookup(uint32_t addr, uint32_t *offset) {
+    int idx = ksym_find(addr);
+    if (idx < 0) return NULL;
+    if (offset) *offset = addr - ksym_addr(idx);
+    return ksym_name(idx);
+}
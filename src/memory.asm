@@ -1,35 +1,77 @@
 BITS 32
 
+; Build with -D HEAP_TRACK=1 to tag small objects with their allocation
+; site as well (Makefile: on in debug builds)
+%ifndef HEAP_TRACK
+%define HEAP_TRACK 0
+%endif
+
 section .data
 align 4
 
 ; Constants
+; A block is a 20-byte header, the payload and a footer holding the
+; header's address. The footer lets kfree find the previous block.
+; While a block is in use its two free-list link words hold the caller's
+; return address and the allocation sequence number (MEM /TOP, /LEAKS).
 MCB_MAGIC       equ 0x4D43424B      ; "MCKB" magic
 MCB_HEADER_SIZE equ 20              ; Size of MCB header
+MCB_FOOTER_SIZE equ 4               ; Size of MCB footer
+MCB_OVERHEAD    equ MCB_HEADER_SIZE + MCB_FOOTER_SIZE
 MIN_SPLIT_SIZE  equ 32              ; Minimum size to split block
 MCB_FLAG_FREE   equ 1               ; Block is free
 MCB_FLAG_USED   equ 0               ; Block is used
+MCB_FLAG_FENCE  equ 2               ; End of heap, never merged
+MEM_REGION_HDR  equ 8               ; Next region + region size
+MEM_MAX_ALLOC   equ 0x40000000      ; Larger requests are rejected outright
+
+; Size classes: requests up to SMALL_MAX bytes are rounded up to a power
+; of two (16..2048) and served from per-class free lists. Each object
+; carries an 8-byte header; the magic sits at ptr-8 just like MCB_MAGIC
+; does for a large block, so kfree can tell the two apart. HEAP_TRACK
+; puts the site and sequence number in front, as for large blocks.
+SMALL_CLASSES   equ 8
+SMALL_MIN_SHIFT equ 4               ; Class 0 = 16 bytes
+SMALL_MAX       equ 2048            ; Largest request served by a class
+SLAB_MAGIC      equ 0x534C4142      ; "SLAB" magic
+%if HEAP_TRACK
+SLAB_HDR_SIZE   equ 16              ; Site, sequence, magic, class word
+%else
+SLAB_HDR_SIZE   equ 8               ; Magic + class word
+%endif
+SLAB_FREE_BIT   equ 0x80000000      ; Set in the class word while on a free list
+SLAB_CHUNK_SIZE equ 16384           ; Bytes taken from the large heap per refill
+SLAB_SITE       equ 1               ; Site tag of a block carved into objects
 
 ; Heap management
-heap_base       dd 0
-heap_size       dd 0
-heap_end        dd 0
+heap_regions    dd 0                ; Singly linked through the region headers
+heap_size       dd 0                ; Bytes across all regions
 heap_free_head  dd 0
 
+; Per-class free lists (payload pointers linked through their first dword)
+small_free_head times SMALL_CLASSES dd 0
+
 ; Statistics
 mem_total_free  dd 0
 mem_total_used  dd 0
 mem_num_blocks  dd 0
+mem_small_cached dd 0               ; Bytes of objects on the class lists
+mem_alloc_seq   dd 0                ; Bumped by every kmalloc
 
 ; Debug flag (set to 1 to enable validation)
 debug_enabled   dd 0
 
 section .text
+extern heap_grow
 global mem_init
+global mem_add_region
 global kmalloc
 global kfree
+global krealloc
 global mem_get_stats
 global mem_validate_heap
+global mem_walk
+global mem_alloc_seq
 
 ; mem_init - Initialize heap allocator
 ; Input: 
@@ -39,51 +81,102 @@ global mem_validate_heap
 ;   EAX = 0 on success, non-zero on error
 
 mem_init:
+    push ebp
+    mov ebp, esp
+    push ecx
+    push edi
+
+    ; Forget any previous heap
+    push eax
+    xor eax, eax
+    mov [heap_regions], eax
+    mov [heap_size], eax
+    mov [heap_free_head], eax
+    mov [mem_total_free], eax
+    mov [mem_total_used], eax
+    mov [mem_num_blocks], eax
+    mov [mem_small_cached], eax
+
+    ; Size classes start empty and refill from the new heap
+    mov edi, small_free_head
+    mov ecx, SMALL_CLASSES
+    rep stosd
+    pop eax
+
+    push ebx
+    push eax
+    call mem_add_region
+    add esp, 8
+
+    pop edi
+    pop ecx
+    leave
+    ret
+
+; mem_add_region - Add a range of memory to the heap (cdecl)
+; Input:
+;   [esp+4] = region base address
+;   [esp+8] = region size in bytes
+; Returns:
+;   EAX = 0 on success, non-zero on error
+;
+; Layout: region header, a zero footer, one free block covering the
+; rest and a fence block at the end. The zero footer and the fence stop
+; merges at either edge without bounds checks in kfree, so regions never
+; need to be adjacent.
+
+mem_add_region:
     push ebp
     mov ebp, esp
     push ebx
     push ecx
-    push edx
     push esi
     push edi
 
     ; Validate parameters
-    test eax, eax
+    mov edi, [ebp + 8]
+    mov ecx, [ebp + 12]
+    test edi, edi
     jz .error_invalid
-    cmp ebx, 1024           ; Minimum 1KB heap
+    cmp ecx, 1024           ; Minimum 1KB region
     jb .error_invalid
 
-    ; Store heap parameters
-    mov [heap_base], eax
-    mov [heap_size], ebx
-    add ebx, eax
-    mov [heap_end], ebx
-
-    ; Initialize first MCB at heap_start
-    mov edi, eax
-    
-    ; Clear MCB header
-    xor ecx, ecx
-    mov [edi + 0], ecx      ; prev = NULL
-    mov [edi + 4], ecx      ; next = NULL
-
-    ; Calculate payload size
-    mov ecx, [heap_size]
-    sub ecx, MCB_HEADER_SIZE
-    jle .error_too_small
-    mov [edi + 8], ecx      ; size
-
-    ; Set magic and flags
-    mov dword [edi + 12], MCB_MAGIC
-    mov dword [edi + 16], MCB_FLAG_FREE
-
-    ; Set free list head
-    mov [heap_free_head], edi
+    ; Region header: link into the region list
+    mov eax, [heap_regions]
+    mov [edi + 0], eax      ; next region
+    mov [edi + 4], ecx      ; region size
+    mov [heap_regions], edi
+    add [heap_size], ecx
+
+    ; No block in front of the first one
+    mov dword [edi + MEM_REGION_HDR], 0
+    lea ebx, [edi + MEM_REGION_HDR + MCB_FOOTER_SIZE]
+
+    ; Payload = what remains after the region overheads, rounded down
+    ; so the fence stays aligned
+    sub ecx, MEM_REGION_HDR + MCB_FOOTER_SIZE + MCB_OVERHEAD + MCB_HEADER_SIZE
+    and ecx, 0xFFFFFFF8
+
+    ; First block: free, covering the region
+    mov [ebx + 8], ecx      ; size
+    mov dword [ebx + 12], MCB_MAGIC
+    mov dword [ebx + 16], MCB_FLAG_FREE
+    lea esi, [ebx + MCB_HEADER_SIZE + ecx]
+    mov [esi], ebx          ; footer
+
+    ; Fence: zero-size block that is never free
+    add esi, MCB_FOOTER_SIZE
+    xor eax, eax
+    mov [esi + 0], eax
+    mov [esi + 4], eax
+    mov [esi + 8], eax
+    mov dword [esi + 12], MCB_MAGIC
+    mov dword [esi + 16], MCB_FLAG_FENCE
 
-    ; Initialize statistics
-    mov [mem_total_free], ecx
-    mov dword [mem_total_used], 0
-    mov dword [mem_num_blocks], 1
+    mov esi, ebx
+    call free_list_push
+    add [mem_total_free], ecx
+    inc dword [mem_num_blocks]
 
     ; Success
     xor eax, eax
@@ -91,29 +184,174 @@ mem_init:
 
 .error_invalid:
     mov eax, 1
-    jmp .done
-
-.error_too_small:
-    mov eax, 2
 
 .done:
     pop edi
     pop esi
-    pop edx
     pop ecx
     pop ebx
     leave
     ret
 
-; kmalloc - Allocate memory block
+; kmalloc - Allocate memory block (cdecl)
 ; Input:
-;   EAX = requested size in bytes
+;   [esp+4] = requested size in bytes
 ; Returns:
 ;   EAX = pointer to allocated memory (NULL on failure)
+;
+; Small requests pop the head of their class list; only sizes above
+; SMALL_MAX (and class refills) walk the first-fit list.
 
 kmalloc:
     push ebp
     mov ebp, esp
+    push dword [ebp + 4]    ; The caller is the allocation site
+    push dword [ebp + 8]
+    call kmalloc_site
+    leave
+    ret
+
+; kmalloc_site - kmalloc with an explicit allocation site (cdecl)
+; Input:
+;   [esp+4] = requested size in bytes
+;   [esp+8] = site recorded for MEM /TOP
+; Returns:
+;   EAX = pointer to allocated memory (NULL on failure)
+
+kmalloc_site:
+    push ebp
+    mov ebp, esp
+    push ecx
+    push edx
+
+    mov eax, [ebp + 8]
+    test eax, eax
+    jz .failed
+    inc dword [mem_alloc_seq]
+    cmp eax, SMALL_MAX
+    ja .large
+
+    ; class = 0 for <= 16 bytes, else bsr(size - 1) - 3
+    xor ecx, ecx
+    cmp eax, 1 << SMALL_MIN_SHIFT
+    jbe .have_class
+    lea ecx, [eax - 1]
+    bsr ecx, ecx
+    sub ecx, SMALL_MIN_SHIFT - 1
+
+.have_class:
+    mov eax, [small_free_head + ecx*4]
+    test eax, eax
+    jnz .pop
+    call slab_refill        ; ECX = class -> EAX = new list head
+    test eax, eax
+    jz .done
+
+.pop:
+    mov edx, [eax]          ; Next free object
+    mov [small_free_head + ecx*4], edx
+    and dword [eax - 4], ~SLAB_FREE_BIT
+    mov edx, 1 << SMALL_MIN_SHIFT
+    shl edx, cl
+    sub [mem_small_cached], edx
+%if HEAP_TRACK
+    mov edx, [ebp + 12]
+    mov [eax - 16], edx     ; Site
+    mov edx, [mem_alloc_seq]
+    mov [eax - 12], edx
+%endif
+    jmp .done
+
+.large:
+    push dword [ebp + 12]   ; Site
+    push eax
+    call heap_alloc_block
+    add esp, 8
+    jmp .done
+
+.failed:
+    xor eax, eax
+
+.done:
+    pop edx
+    pop ecx
+    leave
+    ret
+
+; slab_refill - Carve a fresh chunk into objects of one class
+; Input:
+;   ECX = class index
+; Returns:
+;   EAX = first free object (also stored as the class list head), 0 if
+;         the large heap is exhausted
+; Chunks stay with their class once carved.
+
+slab_refill:
+    push ebx
+    push edx
+    push esi
+    push edi
+
+    push SLAB_SITE
+    push SLAB_CHUNK_SIZE
+    call heap_alloc_block
+    add esp, 8
+    test eax, eax
+    jz .done
+
+    ; Object stride = class size + header
+    mov ebx, 1 << SMALL_MIN_SHIFT
+    shl ebx, cl
+    add ebx, SLAB_HDR_SIZE
+
+    push eax                ; Chunk base
+    mov esi, ecx
+    or esi, SLAB_FREE_BIT   ; Class word for a free object
+    mov edi, eax            ; Current object header
+    lea edx, [eax + SLAB_CHUNK_SIZE]
+    sub edx, ebx            ; Last address an object may start at
+
+.carve:
+%if HEAP_TRACK
+    mov dword [edi], 0      ; Site and sequence, set by kmalloc
+    mov dword [edi + 4], 0
+%endif
+    mov dword [edi + SLAB_HDR_SIZE - 8], SLAB_MAGIC
+    mov [edi + SLAB_HDR_SIZE - 4], esi
+    lea eax, [ebx - SLAB_HDR_SIZE]
+    add [mem_small_cached], eax
+    lea eax, [edi + ebx]    ; Next object header
+    cmp eax, edx
+    ja .last
+    add eax, SLAB_HDR_SIZE
+    mov [edi + SLAB_HDR_SIZE], eax  ; Link to the next payload
+    lea edi, [eax - SLAB_HDR_SIZE]
+    jmp .carve
+
+.last:
+    mov dword [edi + SLAB_HDR_SIZE], 0
+    pop eax
+    add eax, SLAB_HDR_SIZE  ; Head is the first payload in the chunk
+    mov [small_free_head + ecx*4], eax
+
+.done:
+    pop edi
+    pop esi
+    pop edx
+    pop ebx
+    ret
+
+; heap_alloc_block - First-fit allocation from the large heap (cdecl)
+; Input:
+;   [esp+4] = requested size in bytes
+;   [esp+8] = allocation site recorded in the header
+; Returns:
+;   EAX = pointer to allocated memory (NULL on failure)
+
+heap_alloc_block:
+    push ebp
+    mov ebp, esp
+    sub esp, 4              ; [ebp - 4] = heap already grown once
     push ebx
     push ecx
     push edx
@@ -121,258 +359,410 @@ kmalloc:
     push edi
 
     ; Validate size
+    mov eax, [ebp + 8]
     test eax, eax
     jz .alloc_failed
+    cmp eax, MEM_MAX_ALLOC
+    ja .alloc_failed
+    mov dword [ebp - 4], 0
 
-    ; Align size to 4-byte boundary
-    add eax, 3
-    and eax, 0xFFFFFFFC
-    mov [ebp - 20], eax     ; Save aligned size
+    ; Align size to 8 bytes so every payload stays 8-byte aligned
+    add eax, 7
+    and eax, 0xFFFFFFF8
 
+.search_start:
     ; Search free list for suitable block (first-fit)
     mov esi, [heap_free_head]
 
 .search_loop:
     test esi, esi
-    jz .alloc_failed
+    jz .grow_heap
 
     ; Validate block magic
     cmp dword [esi + 12], MCB_MAGIC
-    jne .corrupted_heap
-
-    ; Check if block is free
-    cmp dword [esi + 16], MCB_FLAG_FREE
-    jne .next_block
+    jne .alloc_failed       ; Corrupted free list
 
     ; Check if block is large enough
-    mov ebx, [esi + 8]      ; block size
-    cmp ebx, eax
-    jb .next_block
-
-    ; Found suitable block
-    jmp .allocate_block
-
-.next_block:
-    mov esi, [esi + 4]      ; next block
+    cmp [esi + 8], eax
+    jae .allocate_block
+    mov esi, [esi + 4]      ; next free block
     jmp .search_loop
 
 .allocate_block:
-    ; ESI points to suitable block
-    ; EAX contains requested size
+    call free_list_unlink
     mov ebx, [esi + 8]      ; block size
 
-    ; Check if we should split the block
+    ; Split only if the tail can hold a useful block
     mov ecx, ebx
     sub ecx, eax            ; remaining space
-    sub ecx, MCB_HEADER_SIZE
-    cmp ecx, MIN_SPLIT_SIZE
+    cmp ecx, MCB_OVERHEAD + MIN_SPLIT_SIZE
     jb .use_whole_block
 
-    ; Split block
-    ; Create new free block after allocated portion
-    mov edi, esi
-    add edi, MCB_HEADER_SIZE
-    add edi, eax            ; EDI = new block address
-
-    ; Setup new block
-    mov [edi + 0], esi      ; prev = current block
-    mov edx, [esi + 4]
-    mov [edi + 4], edx      ; next = old next
+    ; Shrink current block and close it with a footer
+    mov [esi + 8], eax
+    lea edi, [esi + MCB_HEADER_SIZE + eax]
+    mov [edi], esi
+    add edi, MCB_FOOTER_SIZE ; EDI = new block address
 
-    ; Calculate new block size
-    mov ecx, [esi + 8]
-    sub ecx, eax
-    sub ecx, MCB_HEADER_SIZE
+    ; Setup new free block in the tail
+    sub ecx, MCB_OVERHEAD
     mov [edi + 8], ecx      ; size
-
     mov dword [edi + 12], MCB_MAGIC
     mov dword [edi + 16], MCB_FLAG_FREE
+    mov [edi + MCB_HEADER_SIZE + ecx], edi
 
-    ; Update current block
-    mov [esi + 4], edi      ; current.next = new block
-    mov [esi + 8], eax      ; current.size = requested
+    xchg esi, edi
+    call free_list_push
+    xchg esi, edi
+    inc dword [mem_num_blocks]
 
-    ; Update next block's prev pointer
-    test edx, edx
-    jz .split_done
-    mov [edx + 0], edi      ; next.prev = new block
+    ; The tail's overhead comes out of free space as well
+    lea edx, [eax + MCB_OVERHEAD]
+    sub [mem_total_free], edx
+    add [mem_total_used], eax
+    jmp .alloc_success
 
-.split_done:
-    ; Mark current block as used
+.use_whole_block:
+    sub [mem_total_free], ebx
+    add [mem_total_used], ebx
+
+.alloc_success:
+    ; Mark block as used, tag it and return payload pointer
     mov dword [esi + 16], MCB_FLAG_USED
+    mov edx, [ebp + 12]
+    mov [esi + 0], edx      ; Site
+    mov edx, [mem_alloc_seq]
+    mov [esi + 4], edx      ; Sequence number
+    lea eax, [esi + MCB_HEADER_SIZE]
+    jmp .done
 
-    ; Return payload pointer
-    mov eax, esi
-    add eax, MCB_HEADER_SIZE
-    jmp .alloc_success
+.grow_heap:
+    ; Nothing fits: take a new region from the page allocator and retry
+    cmp dword [ebp - 4], 0
+    jne .alloc_failed
+    mov dword [ebp - 4], 1
+    push eax
+    push eax
+    call heap_grow          ; cdecl, clobbers EAX/ECX/EDX
+    add esp, 4
+    mov ecx, eax
+    pop eax
+    test ecx, ecx
+    jnz .search_start
 
-.use_whole_block:
-    ; Remove block from free list
-    mov edx, [esi + 0]      ; prev
-    mov ecx, [esi + 4]      ; next
+.alloc_failed:
+    xor eax, eax
 
-    ; Update prev's next pointer
-    test edx, edx
+.done:
+    pop edi
+    pop esi
+    pop edx
+    pop ecx
+    pop ebx
+    leave
+    ret
+
+; free_list_unlink - Remove a block from the free list
+; Input:
+;   ESI = block header
+
+free_list_unlink:
+    push eax
+    push edx
+
+    mov eax, [esi + 0]      ; prev
+    mov edx, [esi + 4]      ; next
+
+    test eax, eax
     jz .no_prev
-    mov [edx + 4], ecx
+    mov [eax + 4], edx
     jmp .update_next
 
 .no_prev:
     ; Block is head of free list
-    mov [heap_free_head], ecx
+    mov [heap_free_head], edx
 
 .update_next:
-    ; Update next's prev pointer
-    test ecx, ecx
-    jz .remove_done
-    mov [ecx + 0], edx
+    test edx, edx
+    jz .done
+    mov [edx + 0], eax
 
-.remove_done:
-    ; Mark block as used
-    mov dword [esi + 16], MCB_FLAG_USED
+.done:
+    pop edx
+    pop eax
+    ret
 
-    ; Return payload pointer
-    mov eax, esi
-    add eax, MCB_HEADER_SIZE
-    jmp .alloc_success
+; free_list_push - Add a block to the head of the free list
+; Input:
+;   ESI = block header
 
-.alloc_failed:
-    xor eax, eax
-    jmp .done
+free_list_push:
+    push eax
 
-.corrupted_heap:
-    ; Heap corruption detected
-    xor eax, eax
+    mov eax, [heap_free_head]
+    mov dword [esi + 0], 0
+    mov [esi + 4], eax
+    test eax, eax
+    jz .set_head
+    mov [eax + 0], esi
 
-.alloc_success:
-    ; Update statistics (approximate)
-    mov ebx, [ebp - 20]     ; requested size
-    add ebx, MCB_HEADER_SIZE
-    mov ecx, [mem_total_free]
-    sub ecx, ebx
-    mov [mem_total_free], ecx
-    mov ecx, [mem_total_used]
-    add ecx, ebx
-    mov [mem_total_used], ecx
+.set_head:
+    mov [heap_free_head], esi
+
+    pop eax
+    ret
+
+; kfree - Free allocated memory block (cdecl)
+; Input:
+;   [esp+4] = pointer to memory block (from kmalloc)
+; Returns: nothing
+
+kfree:
+    push ebp
+    mov ebp, esp
+    push eax
+    push ecx
+    push edx
+
+    mov eax, [ebp + 8]
+    test eax, eax
+    jz .done
+    cmp dword [eax - 8], SLAB_MAGIC
+    je .small
+
+    push eax
+    call heap_free_block
+    add esp, 4
+    jmp .done
+
+.small:
+    mov ecx, [eax - 4]
+    test ecx, SLAB_FREE_BIT
+    jnz .done               ; Double free protection
+    cmp ecx, SMALL_CLASSES
+    jae .done               ; Not a class we handed out
+
+    or dword [eax - 4], SLAB_FREE_BIT
+    mov edx, 1 << SMALL_MIN_SHIFT
+    shl edx, cl
+    add [mem_small_cached], edx
+    mov edx, [small_free_head + ecx*4]
+    mov [eax], edx
+    mov [small_free_head + ecx*4], eax
 
 .done:
-    pop edi
-    pop esi
     pop edx
     pop ecx
-    pop ebx
+    pop eax
     leave
     ret
 
-; kfree - Free allocated memory block
+; heap_free_block - Return a block to the large heap (cdecl)
 ; Input:
-;   EAX = pointer to memory block (from kmalloc)
+;   [esp+4] = pointer from heap_alloc_block
 ; Returns: nothing
+;
+; Physical neighbours are found in O(1): the next header follows this
+; block's footer, and the footer just in front of this header names the
+; previous block. Free neighbours are merged immediately, so no two free
+; blocks are ever adjacent.
 
-kfree:
+heap_free_block:
     push ebp
     mov ebp, esp
     push eax
-    push ebx
     push ecx
-    push edx
     push esi
     push edi
 
     ; Validate pointer
-    test eax, eax
+    mov esi, [ebp + 8]
+    test esi, esi
     jz .done
-
-    ; Get MCB header
-    mov esi, eax
     sub esi, MCB_HEADER_SIZE
 
     ; Validate block
     cmp dword [esi + 12], MCB_MAGIC
-    jne .invalid_free
+    jne .done
 
-    ; Check if already free
-    cmp dword [esi + 16], MCB_FLAG_FREE
-    je .done                ; Double free protection
+    ; Only used blocks can be freed (double free, fence)
+    cmp dword [esi + 16], MCB_FLAG_USED
+    jne .done
 
-    ; Mark block as free
+    mov ecx, [esi + 8]
+    sub [mem_total_used], ecx
+    add [mem_total_free], ecx
     mov dword [esi + 16], MCB_FLAG_FREE
 
-    ; Try to coalesce with next block
-    mov edi, [esi + 4]      ; next block
-    test edi, edi
-    jz .check_prev
-
-    ; Validate next block
+    ; Merge with next block (the fence is never free)
+    lea edi, [esi + MCB_OVERHEAD + ecx]
     cmp dword [edi + 12], MCB_MAGIC
     jne .check_prev
-
-    ; Check if next is free
     cmp dword [edi + 16], MCB_FLAG_FREE
     jne .check_prev
 
-    ; Coalesce with next
-    ; current.size += MCB_HEADER_SIZE + next.size
-    mov eax, [esi + 8]
-    add eax, MCB_HEADER_SIZE
-    add eax, [edi + 8]
-    mov [esi + 8], eax
-
-    ; current.next = next.next
-    mov ebx, [edi + 4]
-    mov [esi + 4], ebx
-
-    ; Update next.next.prev if exists
-    test ebx, ebx
-    jz .check_prev
-    mov [ebx + 0], esi
+    xchg esi, edi
+    call free_list_unlink
+    xchg esi, edi
+    mov dword [edi + 12], 0 ; Retire the absorbed header
+    add ecx, [edi + 8]
+    add ecx, MCB_OVERHEAD
+    mov [esi + 8], ecx
+    add dword [mem_total_free], MCB_OVERHEAD
+    dec dword [mem_num_blocks]
 
 .check_prev:
-    ; Try to coalesce with previous block
-    mov edi, [esi + 0]      ; prev block
+    ; Merge into previous block, which keeps its place on the free list
+    mov edi, [esi - MCB_FOOTER_SIZE]
     test edi, edi
     jz .add_to_free_list
-
-    ; Validate prev block
     cmp dword [edi + 12], MCB_MAGIC
     jne .add_to_free_list
-
-    ; Check if prev is free
     cmp dword [edi + 16], MCB_FLAG_FREE
     jne .add_to_free_list
 
-    ; Coalesce with prev
-    ; prev.size += MCB_HEADER_SIZE + current.size
-    mov eax, [edi + 8]
-    add eax, MCB_HEADER_SIZE
-    add eax, [esi + 8]
-    mov [edi + 8], eax
+    mov dword [esi + 12], 0
+    add ecx, [edi + 8]
+    add ecx, MCB_OVERHEAD
+    mov [edi + 8], ecx
+    add dword [mem_total_free], MCB_OVERHEAD
+    dec dword [mem_num_blocks]
+    mov esi, edi
+    jmp .write_footer
+
+.add_to_free_list:
+    call free_list_push
+
+.write_footer:
+    mov [esi + MCB_HEADER_SIZE + ecx], esi
+
+.done:
+    pop edi
+    pop esi
+    pop ecx
+    pop eax
+    leave
+    ret
 
-    ; prev.next = current.next
-    mov ebx, [esi + 4]
-    mov [edi + 4], ebx
+; krealloc - Resize an allocation (cdecl)
+; Input:
+;   [esp+4] = pointer from kmalloc (NULL behaves like kmalloc)
+;   [esp+8] = new size in bytes (0 frees the block and returns NULL)
+; Returns:
+;   EAX = the resized block, possibly moved; NULL on failure, in which
+;         case the old block is left as it was
+;
+; A large block grows in place when the block after it is free and big
+; enough, and shrinks in place by handing its tail back. A small object
+; stays put while the new size fits its class. Otherwise the contents
+; move to a new allocation and the old one is freed.
+
+krealloc:
+    push ebp
+    mov ebp, esp
+    push ebx
+    push ecx
+    push edx
+    push esi
+    push edi
 
-    ; Update current.next.prev if exists
+    mov esi, [ebp + 8]
+    mov ebx, [ebp + 12]
+    test esi, esi
+    jz .fresh
     test ebx, ebx
-    jz .done
-    mov [ebx + 0], edi
+    jz .release
+    cmp ebx, MEM_MAX_ALLOC
+    ja .failed
+    cmp dword [esi - 8], SLAB_MAGIC
+    je .small
+
+    ; Large block
+    sub esi, MCB_HEADER_SIZE
+    cmp dword [esi + 12], MCB_MAGIC
+    jne .failed
+    cmp dword [esi + 16], MCB_FLAG_USED
+    jne .failed
+    lea eax, [ebx + 7]
+    and eax, 0xFFFFFFF8
+    mov ecx, [esi + 8]      ; Current size, the copy length if it moves
+    cmp eax, ecx
+    jbe .trim
+
+    ; Absorb the next block if it is free and the two are big enough
+    lea edi, [esi + MCB_OVERHEAD + ecx]
+    cmp dword [edi + 12], MCB_MAGIC
+    jne .move
+    cmp dword [edi + 16], MCB_FLAG_FREE
+    jne .move
+    mov edx, [edi + 8]
+    lea edx, [ecx + MCB_OVERHEAD + edx]
+    cmp edx, eax
+    jb .move
+
+    xchg esi, edi
+    call free_list_unlink
+    xchg esi, edi
+    mov dword [edi + 12], 0 ; Retire the absorbed header
+    push eax
+    mov eax, [edi + 8]
+    sub [mem_total_free], eax
+    add eax, MCB_OVERHEAD
+    add [mem_total_used], eax
+    pop eax
+    dec dword [mem_num_blocks]
+    mov [esi + 8], edx
+    mov [esi + MCB_HEADER_SIZE + edx], esi
+
+.trim:
+    call heap_trim_block
+    lea eax, [esi + MCB_HEADER_SIZE]
     jmp .done
 
-.add_to_free_list:
-    ; Add block to head of free list
-    mov eax, [heap_free_head]
-    mov [esi + 0], dword 0
-    mov [esi + 4], eax
-    mov [heap_free_head], esi
+.small:
+    mov ecx, [esi - 4]
+    test ecx, SLAB_FREE_BIT
+    jnz .failed
+    cmp ecx, SMALL_CLASSES
+    jae .failed
+    mov eax, 1 << SMALL_MIN_SHIFT
+    shl eax, cl
+    mov ecx, eax            ; Class size, the copy length if it moves
+    mov eax, esi
+    cmp ebx, ecx
+    jbe .done
 
-    ; Update old head's prev pointer
+.move:
+    push dword [ebp + 4]    ; The caller is the new allocation site
+    push ebx
+    call kmalloc_site
+    add esp, 8
     test eax, eax
     jz .done
-    mov [eax + 0], esi
+    mov esi, [ebp + 8]
+    mov edi, eax
+    shr ecx, 2              ; Sizes are multiples of 8 (large) or 16
+    cld
+    rep movsd
+    push dword [ebp + 8]
+    call kfree              ; Preserves EAX
+    add esp, 4
     jmp .done
 
-.invalid_free:
-    ; Invalid pointer - ignore for safety
+.fresh:
+    push dword [ebp + 4]
+    push ebx
+    call kmalloc_site
+    add esp, 8
+    jmp .done
+
+.release:
+    push esi
+    call kfree
+    add esp, 4
+
+.failed:
+    xor eax, eax
 
 .done:
     pop edi
@@ -380,17 +770,58 @@ kfree:
     pop edx
     pop ecx
     pop ebx
-    pop eax
     leave
     ret
 
-; mem_get_stats - Get memory statistics
+; heap_trim_block - Give the tail of a used block back to the heap
+; Input:
+;   ESI = block header (used)
+;   EAX = bytes to keep, 8-byte aligned, no more than the block size
+; A tail too small to make a block of its own stays with the block.
+
+heap_trim_block:
+    push ecx
+    push edi
+
+    mov ecx, [esi + 8]
+    sub ecx, eax
+    cmp ecx, MCB_OVERHEAD + MIN_SPLIT_SIZE
+    jb .done
+
+    ; Close the kept part with a footer and make the tail a used block
+    mov [esi + 8], eax
+    lea edi, [esi + MCB_HEADER_SIZE + eax]
+    mov [edi], esi
+    add edi, MCB_FOOTER_SIZE
+    sub ecx, MCB_OVERHEAD
+    mov [edi + 8], ecx
+    mov dword [edi + 12], MCB_MAGIC
+    mov dword [edi + 16], MCB_FLAG_USED
+    mov [edi + MCB_HEADER_SIZE + ecx], edi
+    sub dword [mem_total_used], MCB_OVERHEAD
+    inc dword [mem_num_blocks]
+
+    ; Freeing it does the accounting and merges it with a free successor
+    add edi, MCB_HEADER_SIZE
+    push edi
+    call heap_free_block
+    add esp, 4
+
+.done:
+    pop edi
+    pop ecx
+    ret
+
+; mem_get_stats - Get memory statistics (cdecl)
 ; Input:
-;   EAX = pointer to stats structure (or NULL)
+;   [esp+4] = pointer to stats structure (or NULL)
 ; Stats structure:
-;   offset 0: dword total_free
-;   offset 4: dword total_used
-;   offset 8: dword num_blocks
+;   offset 0: dword total_free     (free blocks + cached small objects)
+;   offset 4: dword total_used     (everything else, slab overhead included)
+;   offset 8: dword num_blocks     (heap blocks, free and used)
+;   offset 12: dword largest_free  (biggest single kmalloc that can succeed)
+; The counters are kept exact by kmalloc/kfree: total_free + total_used +
+; num_blocks * MCB_OVERHEAD is always the usable heap size.
 ; Returns:
 ;   EAX = 0 on success
 
@@ -398,80 +829,53 @@ mem_get_stats:
     push ebp
     mov ebp, esp
     push ebx
-    push ecx
-    push edx
     push esi
     push edi
 
-    mov edi, eax            ; Save output pointer
-
-    ; Scan entire heap to compute accurate stats
-    xor eax, eax            ; total_free
-    xor ebx, ebx            ; total_used
-    xor ecx, ecx            ; num_blocks
+    mov edi, [ebp + 8]      ; Save output pointer
+    test edi, edi
+    jz .no_output
 
-    mov esi, [heap_base]
+    ; Largest free block - only the free list needs walking
+    xor ebx, ebx
+    mov esi, [heap_free_head]
 
 .scan_loop:
-    ; Check if we're past the heap end
-    mov edx, [heap_end]
-    cmp esi, edx
-    jae .scan_done
-
-    ; Validate block magic
-    cmp dword [esi + 12], MCB_MAGIC
-    jne .scan_done          ; Stop on corrupted block
-
-    ; Get block size
-    mov edx, [esi + 8]
-
-    ; Check if free or used
-    cmp dword [esi + 16], MCB_FLAG_FREE
-    jne .used_block
-
-    ; Free block
-    add eax, edx
-    jmp .next_scan_block
-
-.used_block:
-    ; Used block
-    add ebx, edx
-
-.next_scan_block:
-    inc ecx                 ; Count block
-
-    ; Move to next block
-    add esi, MCB_HEADER_SIZE
-    add esi, edx
+    test esi, esi
+    jz .scan_done
+    mov eax, [esi + 8]
+    cmp eax, ebx
+    jbe .next_free
+    mov ebx, eax
 
+.next_free:
+    mov esi, [esi + 4]
     jmp .scan_loop
 
 .scan_done:
-    ; Update global statistics
-    mov [mem_total_free], eax
-    mov [mem_total_used], ebx
-    mov [mem_num_blocks], ecx
-
-    ; Store in output structure if provided
-    test edi, edi
-    jz .no_output
-
+    ; Objects parked on the class lists count as free
+    mov eax, [mem_total_free]
+    add eax, [mem_small_cached]
     mov [edi + 0], eax      ; total_free
-    mov [edi + 4], ebx      ; total_used
-    mov [edi + 8], ecx      ; num_blocks
+    mov eax, [mem_total_used]
+    sub eax, [mem_small_cached]
+    mov [edi + 4], eax      ; total_used
+    mov eax, [mem_num_blocks]
+    mov [edi + 8], eax      ; num_blocks
+    mov [edi + 12], ebx     ; largest_free
 
 .no_output:
     xor eax, eax            ; Return success
 
     pop edi
     pop esi
-    pop edx
-    pop ecx
     pop ebx
     leave
     ret
 
 ; mem_validate_heap - Validate heap integrity
+; Walks every block of every region up to its fence, checking magic,
+; flags, footers and that no two free blocks were left unmerged.
 ; Returns:
 ;   EAX = 0 if valid, error code otherwise
 
@@ -480,15 +884,24 @@ mem_validate_heap:
     mov ebp, esp
     push ebx
     push ecx
+    push edx
     push esi
+    push edi
 
-    mov esi, [heap_base]
+    mov edi, [heap_regions]
+
+.next_region:
+    test edi, edi
+    jz .valid
+    lea esi, [edi + MEM_REGION_HDR + MCB_FOOTER_SIZE]
+    mov ebx, [edi + 4]
+    add ebx, edi            ; Region end
+    xor edx, edx            ; Previous block was free
 
 .validate_loop:
-    ; Check bounds
-    mov ebx, [heap_end]
+    ; Check bounds (the fence ends the walk before the region end)
     cmp esi, ebx
-    jae .valid
+    jae .corrupted
 
     ; Check magic
     cmp dword [esi + 12], MCB_MAGIC
@@ -496,18 +909,33 @@ mem_validate_heap:
 
     ; Check flags
     mov eax, [esi + 16]
+    cmp eax, MCB_FLAG_FENCE
+    je .region_done
     cmp eax, MCB_FLAG_FREE
-    je .next_validate
+    je .free_block
     cmp eax, MCB_FLAG_USED
     jne .corrupted
+    xor edx, edx
+    jmp .check_footer
 
-.next_validate:
-    ; Move to next block
+.free_block:
+    test edx, edx
+    jnz .corrupted          ; Missed merge
+    mov edx, 1
+
+.check_footer:
     mov ecx, [esi + 8]
-    add esi, MCB_HEADER_SIZE
-    add esi, ecx
+    cmp [esi + MCB_HEADER_SIZE + ecx], esi
+    jne .corrupted
+
+    ; Move to next block
+    lea esi, [esi + MCB_OVERHEAD + ecx]
     jmp .validate_loop
 
+.region_done:
+    mov edi, [edi + 0]
+    jmp .next_region
+
 .valid:
     xor eax, eax
     jmp .done
@@ -516,12 +944,115 @@ mem_validate_heap:
     mov eax, 1
 
 .done:
+    pop edi
     pop esi
+    pop edx
     pop ecx
     pop ebx
     leave
     ret
 
+; mem_walk - Report every live allocation to a callback (cdecl)
+; Input:
+;   [esp+4] = void cb(void *ctx, void *ptr, uint32_t size,
+;                     uint32_t site, uint32_t seq)
+;   [esp+8] = ctx, passed through
+; Objects in size-class chunks are reported one by one; without
+; HEAP_TRACK their site and sequence number are 0. The callback must not
+; allocate or free. A corrupt region is skipped from the bad block on
+; (mem_validate_heap reports it).
+
+mem_walk:
+    push ebp
+    mov ebp, esp
+    sub esp, 8              ; [ebp-4] object size, [ebp-8] chunk end
+    push ebx
+    push esi
+    push edi
+
+    mov edi, [heap_regions]
+
+.next_region:
+    test edi, edi
+    jz .done
+    lea esi, [edi + MEM_REGION_HDR + MCB_FOOTER_SIZE]
+
+.block:
+    cmp dword [esi + 12], MCB_MAGIC
+    jne .region_done
+    mov eax, [esi + 16]
+    cmp eax, MCB_FLAG_FENCE
+    je .region_done
+    cmp eax, MCB_FLAG_USED
+    jne .next_block
+    cmp dword [esi + 0], SLAB_SITE
+    je .chunk
+
+    push dword [esi + 4]    ; seq
+    push dword [esi + 0]    ; site
+    push dword [esi + 8]    ; size
+    lea eax, [esi + MCB_HEADER_SIZE]
+    push eax
+    push dword [ebp + 12]
+    call dword [ebp + 8]
+    add esp, 20
+    jmp .next_block
+
+.chunk:
+    ; Objects of one class packed from the start of the payload, as
+    ; slab_refill carved them
+    lea ebx, [esi + MCB_HEADER_SIZE]
+    lea eax, [ebx + SLAB_CHUNK_SIZE]
+    mov [ebp - 8], eax
+    mov ecx, [ebx + SLAB_HDR_SIZE - 4]
+    and ecx, ~SLAB_FREE_BIT
+    mov eax, 1 << SMALL_MIN_SHIFT
+    shl eax, cl
+    mov [ebp - 4], eax
+
+.object:
+    mov eax, [ebp - 4]
+    lea eax, [ebx + SLAB_HDR_SIZE + eax]
+    cmp eax, [ebp - 8]
+    ja .next_block          ; No room for this object in the chunk
+    test dword [ebx + SLAB_HDR_SIZE - 4], SLAB_FREE_BIT
+    jnz .next_object
+
+%if HEAP_TRACK
+    push dword [ebx + 4]
+    push dword [ebx + 0]
+%else
+    push dword 0
+    push dword 0
+%endif
+    push dword [ebp - 4]
+    lea eax, [ebx + SLAB_HDR_SIZE]
+    push eax
+    push dword [ebp + 12]
+    call dword [ebp + 8]
+    add esp, 20
+
+.next_object:
+    mov eax, [ebp - 4]
+    lea ebx, [ebx + SLAB_HDR_SIZE + eax]
+    jmp .object
+
+.next_block:
+    mov eax, [esi + 8]
+    lea esi, [esi + MCB_OVERHEAD + eax]
+    jmp .block
+
+.region_done:
+    mov edi, [edi + 0]
+    jmp .next_region
+
+.done:
+    pop edi
+    pop esi
+    pop ebx
+    leave
+    ret
+
 ; Helper: dump_block_info (for debugging)
 ; Input: ESI = block pointer
 
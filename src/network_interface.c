@@ -4,6 +4,7 @@
  */
 
 #include "../include/network.h"
+#include "../include/trace.h"
 #include "../include/stddef.h"
 
 #define MAX_INTERFACES 4
@@ -61,10 +62,8 @@ network_interface_t *netif_get_default(void) { return default_interface; }
 
 // Send packet through interface
 int netif_send(network_interface_t *iface, const uint8_t *data, uint32_t len) {
-  extern void puts(const char*);
-  
   if (!iface || !data || len == 0) {
-    puts("[netif_send] ERROR: Invalid params\n");
+    TRACE_ERR(TR_NETIF_TX_BADARG, len, 0, 0, 0);
     return -1;
   }
 
@@ -72,12 +71,12 @@ int netif_send(network_interface_t *iface, const uint8_t *data, uint32_t len) {
   // There's a struct alignment issue causing link_up to read incorrectly
   
   if (!iface->send_packet) {
-    puts("[netif_send] ERROR: No send_packet function!\n");
+    TRACE_ERR(TR_NETIF_TX_NODRV, 0, 0, 0, 0);
     return -1;
   }
 
-  puts("[netif_send] Sending packet...\n");
   int result = iface->send_packet(iface, data, len);
+  TRACE_DEBUG(TR_NETIF_TX, len, result, 0, 0);
 
   if (result >= 0) {
     iface->tx_packets++;
@@ -0,0 +1,159 @@
+/*
+ * RO-DOS Paging
+ * One page directory for the whole system, identity-mapped
+ *
+ * RAM is mapped with 4 MB PSE pages so the kernel, heap and buffers cost
+ * one TLB entry per 4 MB. Page tables are only created where 4 KB
+ * granularity is asked for (MMIO windows, attribute changes, unmapped
+ * holes) and come from the page frame allocator.
+ *
+ * PAT entry 1 is reprogrammed from write-through to write-combining, so
+ * the PWT bit alone selects WC and PCD|PWT selects UC. Entries 4-7 mirror
+ * 0-3 and the PAT bit is never set.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/paging.h"
+#include "../include/pmm.h"
+#include "../include/cpu.h"
+
+#define PTE_PRESENT 0x001
+#define PTE_WRITE   0x002
+#define PTE_PWT     0x008
+#define PTE_PCD     0x010
+#define PDE_LARGE   0x080           /* PS: the PDE maps a 4 MB page */
+#define PTE_ATTRS   (PTE_WRITE | PTE_PWT | PTE_PCD)
+
+#define CR0_PG      0x80000000u
+#define CR4_PSE     0x00000010u
+
+/* WB, WC, UC-, UC in each half */
+#define MSR_PAT     0x277
+#define PAT_VALUE   0x00070106u
+
+static uint32_t page_directory[1024] __attribute__((aligned(PAGE_SIZE_4K)));
+static bool paging_on = false;
+static bool paging_pse = false;
+
+static void paging_flush(void) {
+    if (!paging_on) return;
+    uint32_t cr3;
+    __asm__ volatile("mov %%cr3, %0\n\tmov %0, %%cr3" : "=r"(cr3) : : "memory");
+}
+
+static uint32_t cache_bits(uint32_t cache) {
+    switch (cache) {
+    case PAGE_CACHE_WC: return PTE_PWT;
+    case PAGE_CACHE_UC: return PTE_PCD | PTE_PWT;
+    default: return 0;
+    }
+}
+
+/* Page table for the 4 MB slot holding addr. A missing table is created
+ * empty; a 4 MB page is split into 1024 entries with its attributes. */
+static uint32_t *paging_table(uint32_t addr) {
+    uint32_t *pde = &page_directory[addr >> 22];
+    if ((*pde & PTE_PRESENT) && !(*pde & PDE_LARGE)) {
+        return (uint32_t *)(*pde & ~(PAGE_SIZE_4K - 1));
+    }
+
+    uint32_t *pt = (uint32_t *)pmm_alloc_pages(1);
+    if (!pt) return NULL;
+    if (*pde & PTE_PRESENT) {
+        uint32_t base = *pde & ~(PAGE_SIZE_4M - 1);
+        uint32_t attrs = (*pde & PTE_ATTRS) | PTE_PRESENT;
+        for (uint32_t i = 0; i < 1024; i++) pt[i] = (base + i * PAGE_SIZE_4K) | attrs;
+    } else {
+        for (uint32_t i = 0; i < 1024; i++) pt[i] = 0;
+    }
+    *pde = (uint32_t)pt | PTE_PRESENT | PTE_WRITE;
+    return pt;
+}
+
+int paging_map(uint32_t addr, uint32_t size, uint32_t cache) {
+    if (size == 0) return 0;
+    uint32_t page = addr & ~(PAGE_SIZE_4K - 1);
+    uint32_t last = (addr + size - 1) | (PAGE_SIZE_4K - 1);   /* inclusive */
+    uint32_t attrs = PTE_PRESENT | PTE_WRITE | cache_bits(cache);
+    int rc = 0;
+
+    for (;;) {
+        uint32_t step = PAGE_SIZE_4K;
+        uint32_t *pde = &page_directory[page >> 22];
+        bool has_table = (*pde & PTE_PRESENT) && !(*pde & PDE_LARGE);
+
+        if (paging_pse && !has_table && (page & (PAGE_SIZE_4M - 1)) == 0 &&
+            last - page >= PAGE_SIZE_4M - 1) {
+            *pde = page | attrs | PDE_LARGE;
+            step = PAGE_SIZE_4M;
+        } else {
+            uint32_t *pt = paging_table(page);
+            if (!pt) {
+                rc = -1;
+                break;
+            }
+            pt[(page >> 12) & 1023] = page | attrs;
+        }
+        if (last - page < step) break;
+        page += step;
+    }
+
+    paging_flush();
+    return rc;
+}
+
+void paging_unmap(uint32_t addr, uint32_t size) {
+    if (size == 0) return;
+    uint32_t page = addr & ~(PAGE_SIZE_4K - 1);
+    uint32_t last = (addr + size - 1) | (PAGE_SIZE_4K - 1);
+
+    for (;;) {
+        uint32_t step = PAGE_SIZE_4K;
+        uint32_t *pde = &page_directory[page >> 22];
+
+        if (!(*pde & PTE_PRESENT)) {
+            /* Nothing mapped in this slot */
+            step = PAGE_SIZE_4M - (page & (PAGE_SIZE_4M - 1));
+        } else if ((*pde & PDE_LARGE) && (page & (PAGE_SIZE_4M - 1)) == 0 &&
+                   last - page >= PAGE_SIZE_4M - 1) {
+            *pde = 0;
+            step = PAGE_SIZE_4M;
+        } else {
+            uint32_t *pt = paging_table(page);
+            if (pt) pt[(page >> 12) & 1023] = 0;
+        }
+        if (last - page < step) break;
+        page += step;
+    }
+
+    paging_flush();
+}
+
+bool paging_enabled(void) {
+    return paging_on;
+}
+
+void paging_init(void) {
+    paging_pse = cpu_has(CPU_FEAT_PSE);
+
+    if (cpu_has(CPU_FEAT_PAT)) {
+        __asm__ volatile("wrmsr" : : "c"(MSR_PAT), "a"(PAT_VALUE), "d"(PAT_VALUE));
+    }
+    if (paging_pse) {
+        uint32_t cr4;
+        __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+        __asm__ volatile("mov %0, %%cr4" : : "r"(cr4 | CR4_PSE));
+    }
+
+    /* All RAM, from the IVT up to the last frame the allocator owns */
+    uint32_t top = (pmm_top() + PAGE_SIZE_4M - 1) & ~(PAGE_SIZE_4M - 1);
+    if (top == 0 || paging_map(0, top, PAGE_CACHE_WB) != 0) return;
+
+    uint32_t cr0;
+    __asm__ volatile("mov %0, %%cr3" : : "r"(page_directory) : "memory");
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    __asm__ volatile("mov %0, %%cr0" : : "r"(cr0 | CR0_PG) : "memory");
+    paging_on = true;
+}
@@ -0,0 +1,192 @@
+/*
+ * RO-DOS Physical Memory Manager
+ * Bitmap page frame allocator over the BIOS E820 memory map
+ *
+ * One bit per 4 KB frame, set while the frame is in use or not RAM. The
+ * bitmap covers frames up to the highest usable address and lives at the
+ * start of the first usable range big enough to hold it. Allocation is a
+ * first-fit scan for a run of clear bits, skipping full words; kmalloc
+ * only comes here to grow the heap, so the scan is off the hot path.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/pmm.h"
+
+/* memory.asm */
+extern int mem_add_region(uint32_t base, uint32_t size);
+
+/* Highest frame boundary below 4 GB */
+#define PMM_LIMIT 0xFFFFF000ULL
+
+/* Region header, edge fences and first block overhead (memory.asm) */
+#define HEAP_REGION_OVERHEAD 64
+
+/* Smallest region added to the heap at a time */
+#define HEAP_GROW_MIN (1024 * 1024)
+
+/* What kernel.asm assumed before the E820 map was read */
+static const e820_entry_t pmm_fallback = {
+    PMM_BASE, 16 * 1024 * 1024, E820_USABLE, 1
+};
+
+static const e820_entry_t *pmm_map;
+static uint32_t pmm_map_count;
+
+static uint32_t *pmm_bitmap;
+static uint32_t pmm_npages;     /* frames covered by the bitmap */
+static uint32_t pmm_nfree;
+static uint32_t pmm_nusable;    /* frames owned by the allocator */
+static uint32_t pmm_hint;       /* no free frame below this one */
+
+static bool pmm_test(uint32_t page) {
+    return (pmm_bitmap[page >> 5] >> (page & 31)) & 1;
+}
+
+/* Mark frames [first, last) used or free, keeping pmm_nfree exact */
+static void pmm_mark(uint32_t first, uint32_t last, bool used) {
+    for (uint32_t page = first; page < last; page++) {
+        uint32_t bit = 1u << (page & 31);
+        uint32_t *word = &pmm_bitmap[page >> 5];
+        if (used && !(*word & bit)) {
+            *word |= bit;
+            pmm_nfree--;
+        } else if (!used && (*word & bit)) {
+            *word &= ~bit;
+            pmm_nfree++;
+        }
+    }
+}
+
+/* Whole frames of a usable entry, clipped to PMM_BASE..4 GB */
+static bool pmm_usable_range(const e820_entry_t *e, uint32_t *start, uint32_t *end) {
+    if (e->type != E820_USABLE) return false;
+    uint64_t lo = e->base;
+    uint64_t hi = e->base + e->length;
+    if (lo < PMM_BASE) lo = PMM_BASE;
+    if (hi > PMM_LIMIT) hi = PMM_LIMIT;
+    lo = (lo + PMM_PAGE_SIZE - 1) & ~(uint64_t)(PMM_PAGE_SIZE - 1);
+    hi &= ~(uint64_t)(PMM_PAGE_SIZE - 1);
+    if (lo >= hi) return false;
+    *start = (uint32_t)lo;
+    *end = (uint32_t)hi;
+    return true;
+}
+
+void pmm_init(void) {
+    uint32_t start, end, top = 0;
+
+    pmm_map_count = *(volatile uint32_t *)E820_MAP_ADDR;
+    pmm_map = (const e820_entry_t *)(E820_MAP_ADDR + 4);
+    for (uint32_t i = 0; i < pmm_map_count && i < E820_MAX_ENTRIES; i++) {
+        if (pmm_usable_range(&pmm_map[i], &start, &end) && end > top) top = end;
+    }
+    if (pmm_map_count == 0 || pmm_map_count > E820_MAX_ENTRIES || top == 0) {
+        pmm_map = &pmm_fallback;
+        pmm_map_count = 1;
+        pmm_usable_range(&pmm_fallback, &start, &top);
+    }
+
+    pmm_npages = top / PMM_PAGE_SIZE;
+    uint32_t words = (pmm_npages + 31) / 32;
+    uint32_t bitmap_size = (words * 4 + PMM_PAGE_SIZE - 1) & ~(PMM_PAGE_SIZE - 1);
+
+    pmm_bitmap = NULL;
+    for (uint32_t i = 0; i < pmm_map_count; i++) {
+        if (pmm_usable_range(&pmm_map[i], &start, &end) && end - start >= bitmap_size) {
+            pmm_bitmap = (uint32_t *)start;
+            break;
+        }
+    }
+    if (!pmm_bitmap) {
+        pmm_npages = 0;
+        pmm_nfree = 0;
+        return;
+    }
+
+    for (uint32_t w = 0; w < words; w++) pmm_bitmap[w] = 0xFFFFFFFF;
+    pmm_nfree = 0;
+
+    /* Usable ranges first, then anything else wins where they overlap */
+    for (uint32_t i = 0; i < pmm_map_count; i++) {
+        if (pmm_usable_range(&pmm_map[i], &start, &end)) {
+            pmm_mark(start / PMM_PAGE_SIZE, end / PMM_PAGE_SIZE, false);
+        }
+    }
+    for (uint32_t i = 0; i < pmm_map_count; i++) {
+        const e820_entry_t *e = &pmm_map[i];
+        if (e->type == E820_USABLE || e->base >= top) continue;
+        uint64_t hi = (e->base + e->length + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+        if (hi > pmm_npages) hi = pmm_npages;
+        pmm_mark((uint32_t)(e->base / PMM_PAGE_SIZE), (uint32_t)hi, true);
+    }
+
+    pmm_nusable = pmm_nfree;
+    uint32_t first = (uint32_t)pmm_bitmap / PMM_PAGE_SIZE;
+    pmm_mark(first, first + bitmap_size / PMM_PAGE_SIZE, true);
+    pmm_hint = PMM_BASE / PMM_PAGE_SIZE;
+}
+
+uint32_t pmm_alloc_pages(uint32_t count) {
+    if (count == 0 || count > pmm_nfree) return 0;
+
+    uint32_t run = 0;
+    for (uint32_t page = pmm_hint; page < pmm_npages; page++) {
+        if (run == 0 && (page & 31) == 0 && pmm_bitmap[page >> 5] == 0xFFFFFFFF) {
+            page += 31;
+            continue;
+        }
+        if (pmm_test(page)) {
+            run = 0;
+            continue;
+        }
+        if (++run == count) {
+            uint32_t first = page + 1 - count;
+            pmm_mark(first, page + 1, true);
+            if (first == pmm_hint) pmm_hint = page + 1;
+            return first * PMM_PAGE_SIZE;
+        }
+    }
+    return 0;
+}
+
+void pmm_free_pages(uint32_t addr, uint32_t count) {
+    uint32_t first = addr / PMM_PAGE_SIZE;
+    if (addr % PMM_PAGE_SIZE || addr < PMM_BASE || first >= pmm_npages) return;
+    if (count > pmm_npages - first) count = pmm_npages - first;
+    pmm_mark(first, first + count, false);
+    if (first < pmm_hint) pmm_hint = first;
+}
+
+uint32_t pmm_total_pages(void) {
+    return pmm_nusable;
+}
+
+uint32_t pmm_free_page_count(void) {
+    return pmm_nfree;
+}
+
+uint32_t pmm_top(void) {
+    return pmm_npages * PMM_PAGE_SIZE;
+}
+
+const e820_entry_t *pmm_e820(uint32_t *count) {
+    *count = pmm_map_count;
+    return pmm_map;
+}
+
+int heap_grow(uint32_t bytes) {
+    uint32_t need = bytes + HEAP_REGION_OVERHEAD;
+    if (need < bytes) return 0;
+    if (need < HEAP_GROW_MIN) need = HEAP_GROW_MIN;
+
+    uint32_t pages = (need + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+    uint32_t addr = pmm_alloc_pages(pages);
+    if (!addr) return 0;
+    if (mem_add_region(addr, pages * PMM_PAGE_SIZE) != 0) {
+        pmm_free_pages(addr, pages);
+        return 0;
+    }
+    return 1;
+}
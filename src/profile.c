@@ -0,0 +1,265 @@
+/*
+ * PROFILE Command - Timer-IRQ Sampling Profiler
+ * Records the interrupted EIP and the first few return addresses of its
+ * frame chain on every IRQ0 into a fixed ring, and reports them against
+ * the embedded kernel symbol table.
+ *
+ *   PROFILE START      clear samples, raise IRQ0 to ~1165 Hz, start sampling
+ *   PROFILE STOP       stop sampling, restore 18.2 Hz
+ *   PROFILE REPORT [N] top N functions (default 20)
+ *   PROFILE STACKS [N] top N call stacks, leaf first (default 20)
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/clock.h"
+#include "../include/ksyms.h"
+#include "../include/backtrace.h"
+#include "../include/kprintf.h"
+
+extern void c_puts(const char *s);
+extern void *kmalloc(uint32_t size);
+extern void kfree(void *ptr);
+extern void timer_set_multiplier(uint32_t mult);
+
+#define puts c_puts
+
+#define PROF_MAX_SAMPLES 16384
+#define PROF_RATE_MULT   64      /* 64 x 18.2 Hz = 1165 Hz */
+#define PROF_DEFAULT_TOP 20
+#define PROF_STACK_DEPTH 4       /* Callers kept per sample */
+
+static uint32_t prof_samples[PROF_MAX_SAMPLES];
+static uint32_t prof_stacks[PROF_MAX_SAMPLES][PROF_STACK_DEPTH];
+static volatile uint32_t prof_count = 0;
+static volatile uint32_t prof_dropped = 0;
+static volatile bool prof_active = false;
+static uint32_t prof_start_ms = 0;
+static uint32_t prof_elapsed_ms = 0;
+
+/* Called from timer_handler with interrupts off; ebp is the interrupted
+ * code's frame pointer */
+void profile_sample(uint32_t eip, uint32_t ebp) {
+    if (!prof_active) return;
+    if (prof_count < PROF_MAX_SAMPLES) {
+        uint32_t *stack = prof_stacks[prof_count];
+        int n = backtrace_walk(ebp, stack, PROF_STACK_DEPTH);
+        while (n < PROF_STACK_DEPTH) stack[n++] = 0;
+        prof_samples[prof_count++] = eip;
+    } else {
+        prof_dropped++;
+    }
+}
+
+/* Share of total in tenths of a percent, e.g. 417 for 41.7% */
+static uint32_t prof_tenths(uint32_t n, uint32_t total) {
+    return (n * 1000 + total / 2) / total;
+}
+
+static bool prof_word_is(const char **p, const char *word) {
+    const char *s = *p;
+    while (*s == ' ') s++;
+    int i = 0;
+    while (word[i]) {
+        char c = s[i];
+        if (c >= 'a' && c <= 'z') c -= 32;
+        if (c != word[i]) return false;
+        i++;
+    }
+    if (s[i] != '\0' && s[i] != ' ') return false;
+    *p = s + i;
+    return true;
+}
+
+static void profile_start(void) {
+    prof_active = false;
+    prof_count = 0;
+    prof_dropped = 0;
+    prof_elapsed_ms = 0;
+    prof_start_ms = clock_ms();
+    timer_set_multiplier(PROF_RATE_MULT);
+    prof_active = true;
+    puts("PROFILE: sampling at ~1165 Hz, PROFILE STOP to end\n");
+}
+
+static void profile_stop(void) {
+    if (prof_active) {
+        prof_active = false;
+        prof_elapsed_ms = clock_ms() - prof_start_ms;
+        timer_set_multiplier(1);
+    }
+    kprintf("PROFILE: stopped, %u samples\n", prof_count);
+}
+
+static void profile_report(uint32_t top) {
+    uint32_t total = prof_count;
+    uint32_t nsyms = ksym_total();
+
+    kprintf("PROFILE: %u samples", total);
+    if (prof_elapsed_ms) kprintf(" over %u ms", prof_elapsed_ms);
+    if (prof_dropped) kprintf(", %u dropped (ring full)", prof_dropped);
+    puts("\n");
+
+    if (total == 0) return;
+    if (nsyms == 0) {
+        puts("PROFILE: kernel has no symbol table\n");
+        return;
+    }
+
+    /* One counter per symbol plus a final slot for unknown addresses */
+    uint32_t *counts = (uint32_t *)kmalloc((nsyms + 1) * sizeof(uint32_t));
+    if (!counts) {
+        puts("PROFILE: out of memory\n");
+        return;
+    }
+    for (uint32_t i = 0; i <= nsyms; i++) counts[i] = 0;
+
+    for (uint32_t i = 0; i < total; i++) {
+        int idx = ksym_find(prof_samples[i]);
+        counts[idx < 0 ? nsyms : (uint32_t)idx]++;
+    }
+
+    puts("  Samples      %  Function\n");
+    for (uint32_t n = 0; n < top; n++) {
+        uint32_t best = 0, best_idx = 0;
+        for (uint32_t i = 0; i <= nsyms; i++) {
+            if (counts[i] > best) {
+                best = counts[i];
+                best_idx = i;
+            }
+        }
+        if (best == 0) break;
+
+        uint32_t pct = prof_tenths(best, total);
+        kprintf("%9u%5u.%u  %s\n", best, pct / 10, pct % 10,
+                best_idx == nsyms ? "[unknown]" : ksym_name((int)best_idx));
+        counts[best_idx] = 0;
+    }
+
+    kfree(counts);
+}
+
+/* Symbol index of a sample's frame; return addresses are looked up one
+ * byte back so they resolve to the calling function. Unknown and missing
+ * frames map to nsyms and PROF_NO_FRAME. */
+#define PROF_NO_FRAME 0xFFFF
+
+static uint16_t prof_frame_sym(uint32_t pc, bool is_return, uint32_t nsyms) {
+    if (pc == 0) return PROF_NO_FRAME;
+    int idx = ksym_find(is_return ? pc - 1 : pc);
+    return (uint16_t)(idx < 0 ? nsyms : (uint32_t)idx);
+}
+
+static int prof_key_cmp(const uint16_t *a, const uint16_t *b) {
+    for (int i = 0; i <= PROF_STACK_DEPTH; i++) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+static void profile_stacks(uint32_t top) {
+    const uint32_t width = PROF_STACK_DEPTH + 1;
+    uint32_t total = prof_count;
+    uint32_t nsyms = ksym_total();
+
+    kprintf("PROFILE: %u samples\n", total);
+    if (total == 0) return;
+    if (nsyms == 0) {
+        puts("PROFILE: kernel has no symbol table\n");
+        return;
+    }
+
+    /* One key (leaf + callers as symbol indices) per sample, then sort an
+     * index array by key so equal stacks become runs */
+    uint16_t *keys = (uint16_t *)kmalloc(total * width * sizeof(uint16_t));
+    uint16_t *order = (uint16_t *)kmalloc(total * sizeof(uint16_t));
+    if (!keys || !order) {
+        if (keys) kfree(keys);
+        if (order) kfree(order);
+        puts("PROFILE: out of memory\n");
+        return;
+    }
+    for (uint32_t i = 0; i < total; i++) {
+        uint16_t *k = &keys[i * width];
+        k[0] = prof_frame_sym(prof_samples[i], false, nsyms);
+        for (uint32_t d = 0; d < PROF_STACK_DEPTH; d++) {
+            k[d + 1] = prof_frame_sym(prof_stacks[i][d], true, nsyms);
+        }
+        order[i] = (uint16_t)i;
+    }
+
+    /* Shell sort (Ciura gaps) - no recursion on the kernel stack */
+    static const uint32_t gaps[] = {1750, 701, 301, 132, 57, 23, 10, 4, 1};
+    for (uint32_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++) {
+        uint32_t gap = gaps[g];
+        for (uint32_t i = gap; i < total; i++) {
+            uint16_t v = order[i];
+            uint32_t j = i;
+            while (j >= gap && prof_key_cmp(&keys[order[j - gap] * width], &keys[v * width]) > 0) {
+                order[j] = order[j - gap];
+                j -= gap;
+            }
+            order[j] = v;
+        }
+    }
+
+    puts("  Samples      %  Stack (leaf <- callers)\n");
+    for (uint32_t n = 0; n < top; n++) {
+        /* Longest remaining run; printed runs are marked by zeroing the
+         * first key's leaf to PROF_NO_FRAME */
+        uint32_t best = 0, best_start = 0;
+        uint32_t i = 0;
+        while (i < total) {
+            uint32_t j = i + 1;
+            const uint16_t *ki = &keys[order[i] * width];
+            while (j < total && prof_key_cmp(ki, &keys[order[j] * width]) == 0) j++;
+            if (ki[0] != PROF_NO_FRAME && j - i > best) {
+                best = j - i;
+                best_start = i;
+            }
+            i = j;
+        }
+        if (best == 0) break;
+
+        uint16_t *k = &keys[order[best_start] * width];
+        uint32_t pct = prof_tenths(best, total);
+        kprintf("%9u%5u.%u  ", best, pct / 10, pct % 10);
+        for (uint32_t d = 0; d <= PROF_STACK_DEPTH && k[d] != PROF_NO_FRAME; d++) {
+            if (d) puts(" <- ");
+            puts(k[d] == nsyms ? "[unknown]" : ksym_name(k[d]));
+        }
+        puts("\n");
+        for (uint32_t r = 0; r < best; r++) keys[order[best_start + r] * width] = PROF_NO_FRAME;
+    }
+
+    kfree(order);
+    kfree(keys);
+}
+
+int cmd_profile(const char *args) {
+    const char *p = args;
+
+    if (prof_word_is(&p, "START")) {
+        profile_start();
+    } else if (prof_word_is(&p, "STOP")) {
+        profile_stop();
+    } else if (prof_word_is(&p, "REPORT")) {
+        uint32_t top = 0;
+        while (*p == ' ') p++;
+        while (*p >= '0' && *p <= '9') top = top * 10 + (uint32_t)(*p++ - '0');
+        if (prof_active) profile_stop();
+        profile_report(top ? top : PROF_DEFAULT_TOP);
+    } else if (prof_word_is(&p, "STACKS")) {
+        uint32_t top = 0;
+        while (*p == ' ') p++;
+        while (*p >= '0' && *p <= '9') top = top * 10 + (uint32_t)(*p++ - '0');
+        if (prof_active) profile_stop();
+        profile_stacks(top ? top : PROF_DEFAULT_TOP);
+    } else {
+        puts("Usage: PROFILE START | STOP | REPORT [N] | STACKS [N]\n");
+        puts(prof_active ? "PROFILE: running\n" : "PROFILE: idle\n");
+        return 1;
+    }
+    return 0;
+}
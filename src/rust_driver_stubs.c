@@ -6,6 +6,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../include/network.h"
+#include "../include/dma.h"
+#include "../include/kprintf.h"
 
 // GOT stub for Rust PIC code
 void *_GLOBAL_OFFSET_TABLE_[3] = {0, 0, 0};
@@ -16,6 +18,7 @@ extern void c_cls(void);
 extern uint16_t c_getkey(void);
 extern void *kmalloc(uint32_t size);
 extern void kfree(void *ptr);
+extern void *memcpy(void *dest, const void *src, uint32_t n);
 
 #define puts c_puts
 #define putc c_putc
@@ -96,7 +99,7 @@ typedef struct {
 typedef struct {
     uint16_t flags;
     uint16_t idx;
-    uint16_t ring[256];
+    uint16_t ring[];
 } virtq_avail_t;
 
 /* VirtQ used element */
@@ -109,7 +112,7 @@ typedef struct {
 typedef struct {
     uint16_t flags;
     uint16_t idx;
-    virtq_used_elem_t ring[256];
+    virtq_used_elem_t ring[];
 } virtq_used_t;
 
 #define VIRTQ_DESC_F_NEXT   1
@@ -117,7 +120,7 @@ typedef struct {
 
 #define RX_QUEUE 0
 #define TX_QUEUE 1
-#define QUEUE_SIZE 4 /* Reduced from 16 to save memory */
+#define QUEUE_SIZE 16 /* Packet buffers per queue, at most the device size */
 #define PKT_BUF_SIZE 2048
 
 static bool wifi_initialized = false;
@@ -126,56 +129,45 @@ static uint8_t wifi_mac[6] = {0x52, 0x54, 0x00, 0x12, 0x34, 0x56};
 static network_interface_t net_iface;
 
 /* 
- * VirtIO queue memory layout (must be contiguous and page aligned):
- * For queue_size=256 (typical QEMU default):
- * - Descriptor Table: 16 bytes * 256 = 4096 bytes
- * - Available Ring: 6 + 2*256 = 518 bytes  
+ * Legacy VirtIO queue memory layout, sized from the queue size the
+ * device reports (must be contiguous and page aligned):
+ * - Descriptor Table: 16 bytes * size
+ * - Available Ring: 6 + 2 * size
  * - Padding to 4096 boundary
- * - Used Ring: 6 + 8*256 = 2054 bytes
- * 
- * We allocate for max queue size 256 to be safe.
+ * - Used Ring: 6 + 8 * size
  */
+#define VRING_ALIGN 4096
 
-#define MAX_QUEUE_SIZE 256
+static uint32_t vring_used_offset(uint16_t qsz) {
+    return (16u * qsz + 6 + 2u * qsz + VRING_ALIGN - 1) & ~(VRING_ALIGN - 1);
+}
 
-/* RX/TX packet buffers - we only use QUEUE_SIZE (16) of them */
-static uint8_t rx_buffers[QUEUE_SIZE][PKT_BUF_SIZE] __attribute__((aligned(4096)));
-static uint8_t tx_buffers[QUEUE_SIZE][PKT_BUF_SIZE] __attribute__((aligned(4096)));
+static uint32_t vring_size(uint16_t qsz) {
+    return vring_used_offset(qsz) + 6 + 8u * qsz;
+}
 
-/* RX Queue - allocate for 256 entries to match device expectations */
-/* Layout: desc[256] at 0, avail at 4096, used at 8192 */
-static uint8_t rx_queue_mem[16384] __attribute__((aligned(4096)));
+/* Queue memory and packet buffers come from dma_alloc at init */
+static uint8_t *rx_queue_mem;
+static uint8_t *tx_queue_mem;
+static dma_pool_t rx_pool;
+static dma_pool_t tx_pool;
 
-/* TX Queue - same layout */
-static uint8_t tx_queue_mem[16384] __attribute__((aligned(4096)));
+/* Device-reported queue sizes, and how many buffers we keep posted */
+static uint16_t rx_queue_size = 0;
+static uint16_t tx_queue_size = 0;
+static uint16_t rx_depth = 0;
+static uint16_t tx_depth = 0;
 
-/* Device-reported queue sizes - stored after init */
-static uint16_t rx_queue_size = 256;
-static uint16_t tx_queue_size = 256;
+static virtq_desc_t *rx_desc;
+static virtq_avail_t *rx_avail;
+static virtq_used_t *rx_used;
 
-/* 
- * For queue_size=256:
- * - Descriptors: 0 to 4095 (256 * 16 = 4096 bytes)
- * - Available ring: 4096 to ~4614 (6 + 2*256 = 518 bytes)
- * - Padding to 8192 boundary
- * - Used ring: 8192+ (6 + 8*256 = 2054 bytes)
- */
-#define VRING_DESC_OFFSET   0
-#define VRING_AVAIL_OFFSET  4096    /* 256 * 16 */
-#define VRING_USED_OFFSET   8192    /* Aligned to 4096 after avail */
-
-/* Accessor macros - fixed offsets for queue size 256 */
-#define rx_desc  ((virtq_desc_t*)(&rx_queue_mem[VRING_DESC_OFFSET]))
-#define rx_avail ((virtq_avail_t*)(&rx_queue_mem[VRING_AVAIL_OFFSET]))
-#define rx_used  ((virtq_used_t*)(&rx_queue_mem[VRING_USED_OFFSET]))
-
-#define tx_desc  ((virtq_desc_t*)(&tx_queue_mem[VRING_DESC_OFFSET]))
-#define tx_avail ((virtq_avail_t*)(&tx_queue_mem[VRING_AVAIL_OFFSET]))
-#define tx_used  ((virtq_used_t*)(&tx_queue_mem[VRING_USED_OFFSET]))
+static virtq_desc_t *tx_desc;
+static virtq_avail_t *tx_avail;
+static virtq_used_t *tx_used;
 
 static uint16_t rx_last_used = 0;
 static uint16_t tx_last_used = 0;
-static uint16_t tx_free_idx = 0;
 
 static uint16_t find_virtio_net(void) {
     for (int bus = 0; bus < 256; bus++) {
@@ -199,47 +191,61 @@ static uint16_t find_virtio_net(void) {
     return 0;
 }
 
-static void setup_virtqueue(uint16_t queue_idx, uint8_t *queue_mem, uint16_t *out_qsz) {
+/* Read the size of a queue and allocate zeroed ring memory for it */
+static uint8_t *alloc_virtqueue(uint16_t queue_idx, uint16_t *out_qsz) {
     /* Select queue */
     outw(wifi_io_base + VIRTIO_PCI_QUEUE_SEL, queue_idx);
     
     /* Get queue size from device */
     uint16_t qsz = inw(wifi_io_base + VIRTIO_PCI_QUEUE_SIZE);
     *out_qsz = qsz;
+    if (qsz == 0) return NULL;
     
-    puts("[NET] Queue ");
-    putc('0' + queue_idx);
-    puts(" size=");
-    putc('0' + (qsz / 100) % 10);
-    putc('0' + (qsz / 10) % 10);
-    putc('0' + qsz % 10);
+    return (uint8_t *)dma_alloc(vring_size(qsz), VRING_ALIGN);
+}
+
+static void setup_virtqueue(uint16_t queue_idx, uint8_t *queue_mem, uint16_t qsz) {
+    /* Select queue */
+    outw(wifi_io_base + VIRTIO_PCI_QUEUE_SEL, queue_idx);
     
-    /* Calculate physical address of queue (must be page aligned) */
-    uint32_t queue_addr = (uint32_t)queue_mem;
-    uint32_t pfn = queue_addr / 4096;
+    /* Physical address of queue (page aligned by dma_alloc) */
+    uint32_t pfn = dma_phys(queue_mem) / VRING_ALIGN;
     
-    puts(" PFN=0x");
-    for (int i = 7; i >= 0; i--) {
-        int n = (pfn >> (i*4)) & 0xF;
-        putc(n < 10 ? '0'+n : 'A'+n-10);
-    }
-    puts("\n");
+    kprintf("[NET] Queue %u size=%03u PFN=0x%08X\n", queue_idx, qsz, pfn);
     
     /* Tell device where queue is - queue memory should already be initialized! */
     outl(wifi_io_base + VIRTIO_PCI_QUEUE_PFN, pfn);
 }
 
+/* Return buffers of packets the device has finished sending to the pool */
+static void wifi_reclaim_tx(void) {
+    volatile virtq_used_t *used_ring = (volatile virtq_used_t *)tx_used;
+    while (tx_last_used != used_ring->idx) {
+        uint32_t id = used_ring->ring[tx_last_used % tx_queue_size].id;
+        if (id < tx_depth) {
+            dma_pool_put(&tx_pool, (void *)(uint32_t)tx_desc[id].addr);
+        }
+        tx_last_used++;
+    }
+}
+
 static int wifi_send(network_interface_t *iface, const uint8_t *data, uint32_t len) {
     (void)iface;
     if (!wifi_initialized || len == 0 || len > PKT_BUF_SIZE - sizeof(virtio_net_hdr_t)) {
         return -1;
     }
     
-    uint16_t idx = tx_free_idx;
-    tx_free_idx = (tx_free_idx + 1) % QUEUE_SIZE;
+    wifi_reclaim_tx();
+    uint8_t *buf = (uint8_t *)dma_pool_get(&tx_pool);
+    if (!buf) {
+        return -1; /* Every buffer is still queued */
+    }
+    
+    /* Descriptor i always carries pool buffer i */
+    uint16_t idx = (uint16_t)((buf - (uint8_t *)tx_pool.base) / tx_pool.buf_size);
     
     /* Prepare buffer with VirtIO net header */
-    virtio_net_hdr_t *hdr = (virtio_net_hdr_t *)tx_buffers[idx];
+    virtio_net_hdr_t *hdr = (virtio_net_hdr_t *)buf;
     hdr->flags = 0;
     hdr->gso_type = 0;
     hdr->hdr_len = 0;
@@ -248,13 +254,10 @@ static int wifi_send(network_interface_t *iface, const uint8_t *data, uint32_t l
     hdr->csum_offset = 0;
     
     /* Copy packet data after header */
-    uint8_t *pkt_data = tx_buffers[idx] + sizeof(virtio_net_hdr_t);
-    for (uint32_t i = 0; i < len; i++) {
-        pkt_data[i] = data[i];
-    }
+    memcpy(buf + sizeof(virtio_net_hdr_t), data, len);
     
     /* Setup descriptor */
-    tx_desc[idx].addr = (uint64_t)(uint32_t)(&tx_buffers[idx][0]);
+    tx_desc[idx].addr = dma_phys(buf);
     tx_desc[idx].len = sizeof(virtio_net_hdr_t) + len;
     tx_desc[idx].flags = 0;
     tx_desc[idx].next = 0;
@@ -301,7 +304,7 @@ static int wifi_recv(network_interface_t *iface, uint8_t *data, uint32_t max_len
     uint32_t total_len = used_ring->ring[ring_idx].len;
     
     /* Validate desc_idx is within our buffer range */
-    if (desc_idx >= QUEUE_SIZE) {
+    if (desc_idx >= rx_depth) {
         puts("[RX] ERROR: desc_idx out of range!\n");
         rx_last_used++;
         return 0;
@@ -312,8 +315,9 @@ static int wifi_recv(network_interface_t *iface, uint8_t *data, uint32_t max_len
     
     rx_last_used++;
     
-    /* Reinitialize the descriptor for reuse - CRITICAL! */
-    rx_desc[desc_idx].addr = (uint64_t)(uint32_t)(&rx_buffers[desc_idx][0]);
+    /* Reinitialize the descriptor for reuse - CRITICAL! The buffer
+     * address is left as posted at init. */
+    uint8_t *rx_buf = (uint8_t *)(uint32_t)rx_desc[desc_idx].addr;
     rx_desc[desc_idx].len = PKT_BUF_SIZE;
     rx_desc[desc_idx].flags = VIRTQ_DESC_F_WRITE;
     rx_desc[desc_idx].next = 0;
@@ -335,10 +339,7 @@ static int wifi_recv(network_interface_t *iface, uint8_t *data, uint32_t max_len
     if (pkt_len > max_len) pkt_len = max_len;
     
     /* Copy data (skip VirtIO header) */
-    uint8_t *src = rx_buffers[desc_idx] + sizeof(virtio_net_hdr_t);
-    for (uint32_t i = 0; i < pkt_len; i++) {
-        data[i] = src[i];
-    }
+    memcpy(data, rx_buf + sizeof(virtio_net_hdr_t), pkt_len);
     
     /* Re-add buffer to available ring for reuse */
     volatile virtq_avail_t *avail_ring = (volatile virtq_avail_t *)rx_avail;
@@ -364,21 +365,8 @@ int debug_rx_state(void) {
     volatile virtq_used_t *used_ring = (volatile virtq_used_t *)rx_used;
     volatile virtq_avail_t *avail_ring = (volatile virtq_avail_t *)rx_avail;
     
-    puts("[DBG] RX used_idx=");
-    uint16_t u = used_ring->idx;
-    putc('0' + (u / 100) % 10);
-    putc('0' + (u / 10) % 10);
-    putc('0' + u % 10);
-    puts(" last_used=");
-    putc('0' + (rx_last_used / 100) % 10);
-    putc('0' + (rx_last_used / 10) % 10);
-    putc('0' + rx_last_used % 10);
-    puts(" avail_idx=");
-    uint16_t a = avail_ring->idx;
-    putc('0' + (a / 100) % 10);
-    putc('0' + (a / 10) % 10);
-    putc('0' + a % 10);
-    puts("\n");
+    kprintf("[DBG] RX used_idx=%03u last_used=%03u avail_idx=%03u\n",
+            used_ring->idx, rx_last_used, avail_ring->idx);
     
     return 0;
 }
@@ -428,19 +416,34 @@ __attribute__((weak)) int wifi_driver_init(void) {
     
     puts("[NET] Setting up RX queue memory...\n");
     
-    /* Zero queue memory FIRST - use faster word-sized writes */
-    {
-        uint32_t *p = (uint32_t *)rx_queue_mem;
-        for (int i = 0; i < 16384 / 4; i++) p[i] = 0;
-        p = (uint32_t *)tx_queue_mem;
-        for (int i = 0; i < 16384 / 4; i++) p[i] = 0;
+    /* Ring memory is sized from the device and comes back zeroed */
+    rx_queue_mem = alloc_virtqueue(RX_QUEUE, &rx_queue_size);
+    tx_queue_mem = alloc_virtqueue(TX_QUEUE, &tx_queue_size);
+    rx_depth = rx_queue_size < QUEUE_SIZE ? rx_queue_size : QUEUE_SIZE;
+    tx_depth = tx_queue_size < QUEUE_SIZE ? tx_queue_size : QUEUE_SIZE;
+    if (!rx_queue_mem || !tx_queue_mem ||
+        dma_pool_init(&rx_pool, PKT_BUF_SIZE, rx_depth) != 0 ||
+        dma_pool_init(&tx_pool, PKT_BUF_SIZE, tx_depth) != 0) {
+        puts("[NET] ERROR: Out of DMA memory for queues!\n");
+        if (rx_queue_mem) dma_free(rx_queue_mem, vring_size(rx_queue_size));
+        if (tx_queue_mem) dma_free(tx_queue_mem, vring_size(tx_queue_size));
+        dma_pool_destroy(&rx_pool);
+        dma_pool_destroy(&tx_pool);
+        rx_queue_mem = tx_queue_mem = NULL;
+        outb(wifi_io_base + VIRTIO_PCI_STATUS, 0x80); /* FAILED */
+        return -1;
     }
     
-    /* Note: Buffer memory doesn't need zeroing - it will be overwritten on use */
+    rx_desc = (virtq_desc_t *)rx_queue_mem;
+    rx_avail = (virtq_avail_t *)(rx_queue_mem + 16u * rx_queue_size);
+    rx_used = (virtq_used_t *)(rx_queue_mem + vring_used_offset(rx_queue_size));
+    tx_desc = (virtq_desc_t *)tx_queue_mem;
+    tx_avail = (virtq_avail_t *)(tx_queue_mem + 16u * tx_queue_size);
+    tx_used = (virtq_used_t *)(tx_queue_mem + vring_used_offset(tx_queue_size));
     
     /* Initialize RX descriptors and buffers BEFORE telling device about queue */
-    for (int i = 0; i < QUEUE_SIZE; i++) {
-        rx_desc[i].addr = (uint64_t)(uint32_t)(&rx_buffers[i][0]);
+    for (int i = 0; i < rx_depth; i++) {
+        rx_desc[i].addr = dma_phys(dma_pool_get(&rx_pool));
         rx_desc[i].len = PKT_BUF_SIZE;
         rx_desc[i].flags = VIRTQ_DESC_F_WRITE;  /* Device writes to this buffer */
         rx_desc[i].next = 0;
@@ -449,35 +452,26 @@ __attribute__((weak)) int wifi_driver_init(void) {
         rx_avail->ring[i] = i;
     }
     rx_avail->flags = 0;  /* No interrupt suppression - allow device to update used ring */
-    rx_avail->idx = QUEUE_SIZE;  /* We've added QUEUE_SIZE buffers */
-    rx_avail_idx = QUEUE_SIZE;   /* Track our next available slot */
+    rx_avail->idx = rx_depth;  /* We've added rx_depth buffers */
+    rx_avail_idx = rx_depth;   /* Track our next available slot */
     
     /* Initialize used ring tracking - CRITICAL: start at 0, device will increment */
     rx_last_used = 0;
     /* NOTE: Do NOT write to rx_used - that's the device's ring!
      * The device will write to used ring when it has processed buffers.
-     * We already zeroed the memory above, so used->idx starts at 0. */
+     * dma_alloc zeroed the memory, so used->idx starts at 0. */
     
     puts("[NET] Setting up TX queue memory...\n");
     
-    /* Initialize TX descriptors */
-    for (int i = 0; i < QUEUE_SIZE; i++) {
-        tx_desc[i].addr = 0;
-        tx_desc[i].len = 0;
-        tx_desc[i].flags = 0;  /* Device reads from this buffer */
-        tx_desc[i].next = 0;
-    }
-    tx_avail->flags = 0;
-    tx_avail->idx = 0;
+    /* TX descriptors are filled in by wifi_send; the rings start zeroed */
     tx_last_used = 0;
-    tx_free_idx = 0;
     
     /* Memory barrier to ensure all writes are visible */
     __asm__ volatile("mfence" ::: "memory");
     
     /* Now tell device where queues are - queue must be ready before this! */
-    setup_virtqueue(RX_QUEUE, rx_queue_mem, &rx_queue_size);
-    setup_virtqueue(TX_QUEUE, tx_queue_mem, &tx_queue_size);
+    setup_virtqueue(RX_QUEUE, rx_queue_mem, rx_queue_size);
+    setup_virtqueue(TX_QUEUE, tx_queue_mem, tx_queue_size);
     
     /* Driver ready */
     outb(wifi_io_base + VIRTIO_PCI_STATUS, 1 | 2 | 4 | 8); /* + DRIVER_OK */
@@ -820,11 +814,7 @@ __attribute__((weak)) uint32_t *gpu_setup_framebuffer(void) {
 __attribute__((weak)) int gpu_flush(void) {
     /* Copy backbuffer to hardware if buffering is active */
     if (vga_target != VGA_HW_MEM) {
-        uint8_t *hw = VGA_HW_MEM;
-        /* Simple copy loop (memcpy not available in stubs) */
-        for (int i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
-            hw[i] = vga_target[i];
-        }
+        memcpy(VGA_HW_MEM, vga_target, VGA_WIDTH * VGA_HEIGHT);
     }
     return 0; 
 }
@@ -1038,9 +1028,7 @@ extern void set_cursor_hardware(void);
 /* Save current text screen before entering GUI */
 static void save_text_screen(void) {
     /* Save 80x25 = 2000 characters (4000 bytes) */
-    for (int i = 0; i < 80 * 25; i++) {
-        SCREEN_BACKUP_ADDR[i] = VGA_TEXT_MEM[i];
-    }
+    memcpy((void *)SCREEN_BACKUP_ADDR, (const void *)VGA_TEXT_MEM, 80 * 25 * 2);
     /* Save cursor position */
     *GUI_CURSOR_ROW_ADDR = cursor_row;
     *GUI_CURSOR_COL_ADDR = cursor_col;
@@ -1055,9 +1043,7 @@ int gui_check_and_restore_screen(void) {
         *GUI_REBOOT_FLAG_ADDR = 0;
         
         /* Restore the screen exactly as it was */
-        for (int i = 0; i < 80 * 25; i++) {
-            VGA_TEXT_MEM[i] = SCREEN_BACKUP_ADDR[i];
-        }
+        memcpy((void *)VGA_TEXT_MEM, (const void *)SCREEN_BACKUP_ADDR, 80 * 25 * 2);
         
         /* Restore cursor position */
         cursor_row = *GUI_CURSOR_ROW_ADDR;
@@ -5,50 +5,82 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define SCROLLBACK_LINES 500
+#define SCROLLBACK_BLOCK_LINES 50   /* lines per heap block */
+#define SCROLLBACK_BLOCKS (SCROLLBACK_LINES / SCROLLBACK_BLOCK_LINES)
 #define SCREEN_WIDTH 80
 #define SCREEN_HEIGHT 25
+#ifndef VGA_MEMORY
 #define VGA_MEMORY ((volatile uint16_t*)0xB8000)
+#endif
 
-// Scrollback buffer (circular buffer)
-static uint16_t scrollback_buffer[SCROLLBACK_LINES][SCREEN_WIDTH];
+extern void *kmalloc(uint32_t size);
+extern void *memcpy(void *dest, const void *src, size_t n);
+
+#define VGA_ROW(y) ((uint16_t *)&VGA_MEMORY[(y) * SCREEN_WIDTH])
+
+// Scrollback buffer (circular buffer). Blocks of lines are allocated by
+// scrollback_grow(), so lines [0, scrollback_count) are always backed.
+typedef uint16_t scrollback_line_t[SCREEN_WIDTH];
+static scrollback_line_t *scrollback_blocks[SCROLLBACK_BLOCKS];
 static uint32_t scrollback_write_pos = 0;
 static uint32_t scrollback_count = 0;
 static int32_t scroll_offset = 0;
 
-// Saved screen when scrolling
-static uint16_t saved_screen[SCREEN_HEIGHT][SCREEN_WIDTH];
+// Saved screen when scrolling, allocated along with the blocks
+// (paging only starts from an interrupt once there is something to show)
+static uint16_t (*saved_screen)[SCREEN_WIDTH] = NULL;
 static bool screen_saved = false;
 
+static uint16_t *scrollback_line(uint32_t idx) {
+    return scrollback_blocks[idx / SCROLLBACK_BLOCK_LINES][idx % SCROLLBACK_BLOCK_LINES];
+}
+
+// Back the whole ring (about 84 KB). Capture runs from scroll_up, which
+// can be reached from an exception handler while the heap is mid-update,
+// so it never allocates; shell_main calls this once the heap is up.
+// Calling it again only retries blocks a full heap refused.
+void scrollback_grow(void) {
+    if (!saved_screen) {
+        saved_screen = kmalloc(SCREEN_HEIGHT * sizeof(scrollback_line_t));
+        if (!saved_screen) return;
+    }
+    for (uint32_t block = 0; block < SCROLLBACK_BLOCKS; block++) {
+        if (!scrollback_blocks[block])
+            scrollback_blocks[block] = kmalloc(SCROLLBACK_BLOCK_LINES * sizeof(scrollback_line_t));
+    }
+}
+
+// Line at the write position, or NULL if the heap could not back it (the
+// line is dropped from scrollback)
+static uint16_t *scrollback_next_line(void) {
+    if (!scrollback_blocks[scrollback_write_pos / SCROLLBACK_BLOCK_LINES])
+        return NULL;
+    return scrollback_line(scrollback_write_pos);
+}
+
 // Save current screen before scrolling
 static void save_current_screen(void) {
     if (screen_saved) return;
-    for (int y = 0; y < SCREEN_HEIGHT; y++) {
-        for (int x = 0; x < SCREEN_WIDTH; x++) {
-            saved_screen[y][x] = VGA_MEMORY[y * SCREEN_WIDTH + x];
-        }
-    }
+    memcpy(saved_screen, VGA_ROW(0), SCREEN_HEIGHT * sizeof(scrollback_line_t));
     screen_saved = true;
 }
 
 // Restore saved screen
 static void restore_saved_screen(void) {
     if (!screen_saved) return;
-    for (int y = 0; y < SCREEN_HEIGHT; y++) {
-        for (int x = 0; x < SCREEN_WIDTH; x++) {
-            VGA_MEMORY[y * SCREEN_WIDTH + x] = saved_screen[y][x];
-        }
-    }
+    memcpy(VGA_ROW(0), saved_screen, SCREEN_HEIGHT * sizeof(scrollback_line_t));
     screen_saved = false;
 }
 
 // Capture a line from VGA to scrollback (called when screen scrolls)
 void scrollback_capture_line(void) {
     // Capture top line of screen before it scrolls away
-    for (int x = 0; x < SCREEN_WIDTH; x++) {
-        scrollback_buffer[scrollback_write_pos][x] = VGA_MEMORY[x];
-    }
+    uint16_t *dst = scrollback_next_line();
+    if (!dst) return;
+    memcpy(dst, VGA_ROW(0), sizeof(scrollback_line_t));
     
     scrollback_write_pos = (scrollback_write_pos + 1) % SCROLLBACK_LINES;
     if (scrollback_count < SCROLLBACK_LINES) {
@@ -59,10 +91,12 @@ void scrollback_capture_line(void) {
 // Save current line to scrollback (legacy API)
 void scrollback_save_line(const char *line, const uint8_t *attrs, uint16_t line_num) {
     (void)line_num;
+    uint16_t *dst = scrollback_next_line();
+    if (!dst) return;
     for (int x = 0; x < SCREEN_WIDTH; x++) {
         uint8_t ch = line ? line[x] : ' ';
         uint8_t at = attrs ? attrs[x] : 0x07;
-        scrollback_buffer[scrollback_write_pos][x] = (at << 8) | ch;
+        dst[x] = (at << 8) | ch;
     }
     scrollback_write_pos = (scrollback_write_pos + 1) % SCROLLBACK_LINES;
     if (scrollback_count < SCROLLBACK_LINES) {
@@ -89,16 +123,12 @@ static void scrollback_redraw(void) {
         } else if (line_idx < (int32_t)scrollback_count) {
             // From scrollback buffer
             uint32_t buf_idx = (scrollback_write_pos + SCROLLBACK_LINES - scrollback_count + line_idx) % SCROLLBACK_LINES;
-            for (int x = 0; x < SCREEN_WIDTH; x++) {
-                VGA_MEMORY[y * SCREEN_WIDTH + x] = scrollback_buffer[buf_idx][x];
-            }
+            memcpy(VGA_ROW(y), scrollback_line(buf_idx), sizeof(scrollback_line_t));
         } else {
             // From saved current screen
             int screen_y = line_idx - scrollback_count;
             if (screen_y < SCREEN_HEIGHT && screen_saved) {
-                for (int x = 0; x < SCREEN_WIDTH; x++) {
-                    VGA_MEMORY[y * SCREEN_WIDTH + x] = saved_screen[screen_y][x];
-                }
+                memcpy(VGA_ROW(y), saved_screen[screen_y], sizeof(scrollback_line_t));
             }
         }
     }
@@ -1,6 +1,8 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "../include/boottime.h"
+#include "../include/kstring.h"
 
 extern void c_puts(const char *s);
 extern void c_putc(char c);
@@ -16,6 +18,7 @@ extern void wifi_autostart(void);  /* WiFi auto-initialization */
 /* Cursor and scrollback */
 extern void cursor_init(void);
 extern void cursor_set_style(uint8_t style);
+extern void scrollback_grow(void);
 
 // Scrollback functions - disabled temporarily to prevent crashes
 // extern void scrollback_scroll_up(void);
@@ -33,14 +36,8 @@ static char history[HISTORY_SIZE][MAX_INPUT];
 static int history_count = 0;
 static int history_pos = 0;
 
-static size_t str_len(const char *s) {
-    size_t l = 0;
-    while(s[l]) l++;
-    return l;
-}
-
 static void str_trim(char *s) {
-    size_t len = str_len(s);
+    size_t len = strlen(s);
     while (len > 0 && (s[len-1] == ' ' || s[len-1] == '\t' || s[len-1] == '\n' || s[len-1] == '\r')) {
         s[--len] = '\0';
     }
@@ -59,9 +56,14 @@ void shell_main(void) {
     int pos = 0;
 
     set_attr(0x07);
-    
+    /* Heap is up: back the scrollback ring before anything scrolls */
+    scrollback_grow();
+    boot_mark(BOOT_SHELL);
+
     /* Check if we're returning from GUI via reboot - restore screen if so */
-    if (gui_check_and_restore_screen()) {
+    int restored = gui_check_and_restore_screen();
+    boot_mark(BOOT_GUI_RESTORE);
+    if (restored) {
         /* Screen was restored from GUI exit, skip boot messages */
         /* Just initialize the systems silently - no output! */
         cmd_init_silent();
@@ -80,14 +82,18 @@ void shell_main(void) {
     
     /* Initialize command system and filesystem */
     cmd_init();
+    boot_mark(BOOT_CMD_INIT);
     
     /* Initialize network interface subsystem */
     netif_init();
+    boot_mark(BOOT_NETIF);
     
     /* Auto-detect and initialize WiFi hardware */
     wifi_autostart();
+    boot_mark(BOOT_WIFI);
 
 prompt_loop:
+    boot_mark(BOOT_PROMPT);
     while (1) {
         set_attr(0x0E); // Yellow prompt
         c_puts(current_dir);
@@ -185,7 +191,7 @@ prompt_loop:
 
         str_trim(line);
 
-        if (str_len(line) > 0) {
+        if (strlen(line) > 0) {
             // Add to history
             if (history_count < HISTORY_SIZE) {
                 // Add new entry
@@ -0,0 +1,214 @@
+/*
+ * RO-DOS SIMD Kernels
+ * SSE2 copy, fill and checksum loops for include/simd.h
+ *
+ * Written as inline asm so the rest of the kernel can stay -mno-sse: the
+ * compiler never allocates XMM registers there, so the kernel build needs
+ * no XMM clobbers. The host build compiles this file with SSE on and does.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/simd.h"
+
+#ifdef __SSE2__
+#define SIMD_CLOBBERS "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5"
+#else
+#define SIMD_CLOBBERS "memory", "cc"
+#endif
+
+/* Checksum blocks per pass; each 32-bit lane gains at most 8 * 0xFFFF per
+ * block, so 4096 blocks (256 KB) cannot overflow one */
+#define CSUM_PASS_BLOCKS 4096
+
+static inline size_t simd_head(const void *dest) {
+    return (0u - (size_t)dest) & 15;
+}
+
+static inline void simd_copy_bytes(uint8_t *d, const uint8_t *s, size_t n) {
+    __asm__ volatile ("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+}
+
+/* Byte i gets byte (i & 3) of pattern */
+static inline void simd_fill_bytes(uint8_t *d, uint32_t pattern, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        d[i] = (uint8_t)(pattern >> ((i & 3) * 8));
+    }
+}
+
+void simd_copy(void *dest, const void *src, size_t n, bool nt) {
+    uint8_t *d = (uint8_t *)dest;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t head = simd_head(d);
+    if (n < head + 64) {
+        simd_copy_bytes(d, s, n);
+        return;
+    }
+
+    simd_copy_bytes(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    size_t blocks = n >> 6;
+    size_t tail = n & 63;
+
+    if (nt) {
+        __asm__ volatile (
+            "1:\n\t"
+            "movdqu   (%1), %%xmm0\n\t"
+            "movdqu 16(%1), %%xmm1\n\t"
+            "movdqu 32(%1), %%xmm2\n\t"
+            "movdqu 48(%1), %%xmm3\n\t"
+            "movntdq %%xmm0,   (%0)\n\t"
+            "movntdq %%xmm1, 16(%0)\n\t"
+            "movntdq %%xmm2, 32(%0)\n\t"
+            "movntdq %%xmm3, 48(%0)\n\t"
+            "add $64, %1\n\t"
+            "add $64, %0\n\t"
+            "dec %2\n\t"
+            "jnz 1b\n\t"
+            "sfence"
+            : "+r"(d), "+r"(s), "+r"(blocks)
+            :
+            : SIMD_CLOBBERS);
+    } else {
+        __asm__ volatile (
+            "1:\n\t"
+            "movdqu   (%1), %%xmm0\n\t"
+            "movdqu 16(%1), %%xmm1\n\t"
+            "movdqu 32(%1), %%xmm2\n\t"
+            "movdqu 48(%1), %%xmm3\n\t"
+            "movdqa %%xmm0,   (%0)\n\t"
+            "movdqa %%xmm1, 16(%0)\n\t"
+            "movdqa %%xmm2, 32(%0)\n\t"
+            "movdqa %%xmm3, 48(%0)\n\t"
+            "add $64, %1\n\t"
+            "add $64, %0\n\t"
+            "dec %2\n\t"
+            "jnz 1b"
+            : "+r"(d), "+r"(s), "+r"(blocks)
+            :
+            : SIMD_CLOBBERS);
+    }
+
+    simd_copy_bytes(d, s, tail);
+}
+
+void simd_fill(void *dest, uint32_t pattern, size_t n, bool nt) {
+    uint8_t *d = (uint8_t *)dest;
+    size_t head = simd_head(d);
+    if (n < head + 64) {
+        simd_fill_bytes(d, pattern, n);
+        return;
+    }
+
+    simd_fill_bytes(d, pattern, head);
+    /* The aligned part starts head bytes into the pattern */
+    uint32_t shift = (uint32_t)(head & 3) * 8;
+    if (shift) pattern = (pattern >> shift) | (pattern << (32 - shift));
+    d += head;
+    n -= head;
+    size_t blocks = n >> 6;
+    size_t tail = n & 63;
+
+    if (nt) {
+        __asm__ volatile (
+            "movd %2, %%xmm0\n\t"
+            "pshufd $0, %%xmm0, %%xmm0\n\t"
+            "1:\n\t"
+            "movntdq %%xmm0,   (%0)\n\t"
+            "movntdq %%xmm0, 16(%0)\n\t"
+            "movntdq %%xmm0, 32(%0)\n\t"
+            "movntdq %%xmm0, 48(%0)\n\t"
+            "add $64, %0\n\t"
+            "dec %1\n\t"
+            "jnz 1b\n\t"
+            "sfence"
+            : "+r"(d), "+r"(blocks)
+            : "r"(pattern)
+            : SIMD_CLOBBERS);
+    } else {
+        __asm__ volatile (
+            "movd %2, %%xmm0\n\t"
+            "pshufd $0, %%xmm0, %%xmm0\n\t"
+            "1:\n\t"
+            "movdqa %%xmm0,   (%0)\n\t"
+            "movdqa %%xmm0, 16(%0)\n\t"
+            "movdqa %%xmm0, 32(%0)\n\t"
+            "movdqa %%xmm0, 48(%0)\n\t"
+            "add $64, %0\n\t"
+            "dec %1\n\t"
+            "jnz 1b"
+            : "+r"(d), "+r"(blocks)
+            : "r"(pattern)
+            : SIMD_CLOBBERS);
+    }
+
+    simd_fill_bytes(d, pattern, tail);
+}
+
+uint16_t simd_csum16(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t sum = 0;
+
+    /* Widen each 16-bit word to a 32-bit lane and add; fold the four lanes
+     * after every pass */
+    while (len >= 64) {
+        size_t blocks = len >> 6;
+        if (blocks > CSUM_PASS_BLOCKS) blocks = CSUM_PASS_BLOCKS;
+        len -= blocks << 6;
+        uint32_t lanes[4];
+        __asm__ volatile (
+            "pxor %%xmm0, %%xmm0\n\t"
+            "pxor %%xmm5, %%xmm5\n\t"
+            "1:\n\t"
+            "movdqu   (%0), %%xmm1\n\t"
+            "movdqu 16(%0), %%xmm3\n\t"
+            "movdqa %%xmm1, %%xmm2\n\t"
+            "movdqa %%xmm3, %%xmm4\n\t"
+            "punpcklwd %%xmm0, %%xmm1\n\t"
+            "punpckhwd %%xmm0, %%xmm2\n\t"
+            "punpcklwd %%xmm0, %%xmm3\n\t"
+            "punpckhwd %%xmm0, %%xmm4\n\t"
+            "paddd %%xmm1, %%xmm5\n\t"
+            "paddd %%xmm2, %%xmm5\n\t"
+            "paddd %%xmm3, %%xmm5\n\t"
+            "paddd %%xmm4, %%xmm5\n\t"
+            "movdqu 32(%0), %%xmm1\n\t"
+            "movdqu 48(%0), %%xmm3\n\t"
+            "movdqa %%xmm1, %%xmm2\n\t"
+            "movdqa %%xmm3, %%xmm4\n\t"
+            "punpcklwd %%xmm0, %%xmm1\n\t"
+            "punpckhwd %%xmm0, %%xmm2\n\t"
+            "punpcklwd %%xmm0, %%xmm3\n\t"
+            "punpckhwd %%xmm0, %%xmm4\n\t"
+            "paddd %%xmm1, %%xmm5\n\t"
+            "paddd %%xmm2, %%xmm5\n\t"
+            "paddd %%xmm3, %%xmm5\n\t"
+            "paddd %%xmm4, %%xmm5\n\t"
+            "add $64, %0\n\t"
+            "dec %1\n\t"
+            "jnz 1b\n\t"
+            "movdqu %%xmm5, %2"
+            : "+r"(p), "+r"(blocks), "=m"(lanes)
+            :
+            : SIMD_CLOBBERS);
+        for (int i = 0; i < 4; i++) {
+            sum += (lanes[i] & 0xFFFF) + (lanes[i] >> 16);
+        }
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    while (len > 1) {
+        sum += (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+        p += 2;
+        len -= 2;
+    }
+    if (len) sum += p[0];
+
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)sum;
+}
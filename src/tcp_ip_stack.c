@@ -4,6 +4,11 @@
  */
 
 #include "../include/network.h"
+#include "../include/clock.h"
+#include "../include/trace.h"
+#include "../include/cpu.h"
+#include "../include/kstring.h"
+#include "../include/kprintf.h"
 #include <stddef.h>
 
 // ARP cache
@@ -21,24 +26,15 @@ static uint16_t htons(uint16_t x) { return __builtin_bswap16(x); }
 
 static uint32_t htonl(uint32_t x) { return __builtin_bswap32(x); }
 
-// Calculate IP checksum
-static uint16_t ip_checksum(const void *data, int len) {
-  const uint16_t *buf = (const uint16_t *)data;
-  uint32_t sum = 0;
-
-  while (len > 1) {
-    sum += *buf++;
-    len -= 2;
-  }
-
-  if (len == 1) {
-    sum += *(uint8_t *)buf;
-  }
-
-  sum = (sum >> 16) + (sum & 0xFFFF);
-  sum += (sum >> 16);
+// Ones' complement sum of data as little-endian words, folded to 16 bits.
+// The sum is byte-order independent up to a final swap (RFC 1071).
+static uint16_t csum_partial(const void *data, uint32_t len) {
+  return cpu_ops.csum16(data, len);
+}
 
-  return ~sum;
+// Calculate IP checksum
+uint16_t ip_checksum(const void *data, int len) {
+  return ~csum_partial(data, len);
 }
 
 // Initialize IP stack
@@ -106,48 +102,17 @@ int ip_send(uint32_t dest_ip, uint8_t protocol, const uint8_t *data,
   if (!iface || !data)
     return -1;
   
-  // Debug: Show src IP and gateway once
+  // Log the source address and gateway once
   static int shown = 0;
   if (!shown && protocol == 6) { // TCP
     shown = 1;
-    extern void puts(const char*);
-    extern void putc(char);
-    puts("[IP] src=");
-    putc('0' + ((iface->ip_addr >> 24) & 0xFF) / 100 % 10);
-    putc('0' + ((iface->ip_addr >> 24) & 0xFF) / 10 % 10);
-    putc('0' + ((iface->ip_addr >> 24) & 0xFF) % 10);
-    putc('.');
-    putc('0' + ((iface->ip_addr >> 16) & 0xFF) / 100 % 10);
-    putc('0' + ((iface->ip_addr >> 16) & 0xFF) / 10 % 10);
-    putc('0' + ((iface->ip_addr >> 16) & 0xFF) % 10);
-    putc('.');
-    putc('0' + ((iface->ip_addr >> 8) & 0xFF) / 100 % 10);
-    putc('0' + ((iface->ip_addr >> 8) & 0xFF) / 10 % 10);
-    putc('0' + ((iface->ip_addr >> 8) & 0xFF) % 10);
-    putc('.');
-    putc('0' + (iface->ip_addr & 0xFF) / 100 % 10);
-    putc('0' + (iface->ip_addr & 0xFF) / 10 % 10);
-    putc('0' + (iface->ip_addr & 0xFF) % 10);
-    puts(" gw=");
-    putc('0' + ((iface->gateway >> 24) & 0xFF) / 100 % 10);
-    putc('0' + ((iface->gateway >> 24) & 0xFF) / 10 % 10);
-    putc('0' + ((iface->gateway >> 24) & 0xFF) % 10);
-    putc('.');
-    putc('0' + ((iface->gateway >> 16) & 0xFF) / 100 % 10);
-    putc('0' + ((iface->gateway >> 16) & 0xFF) / 10 % 10);
-    putc('0' + ((iface->gateway >> 16) & 0xFF) % 10);
-    putc('.');
-    putc('0' + ((iface->gateway >> 8) & 0xFF) / 100 % 10);
-    putc('0' + ((iface->gateway >> 8) & 0xFF) / 10 % 10);
-    putc('0' + ((iface->gateway >> 8) & 0xFF) % 10);
-    putc('.');
-    putc('0' + (iface->gateway & 0xFF) / 100 % 10);
-    putc('0' + (iface->gateway & 0xFF) / 10 % 10);
-    putc('0' + (iface->gateway & 0xFF) % 10);
-    puts("\n");
-  }
-
-  uint8_t packet[1500];
+    TRACE_INFO(TR_IP_ROUTE, iface->ip_addr, iface->gateway, 0, 0);
+  }
+
+  // Static like netif_poll's rx_buffer: the stack is only driven from the
+  // shell's polling loop, and netif_send copies the frame out before we
+  // return, so one frame buffer is enough and keeps 1.5 KB off the stack
+  static uint8_t packet[1500];
   eth_header_t *eth = (eth_header_t *)packet;
   ip_header_t *ip = (ip_header_t *)(packet + sizeof(eth_header_t));
 
@@ -357,23 +322,22 @@ int ip_receive(uint8_t *buffer, uint32_t len) {
 
   ip_header_t *ip = (ip_header_t *)(buffer + sizeof(eth_header_t));
 
+  // Honour the header length and total length; anything past total_length
+  // is Ethernet padding
+  uint32_t ip_len = len - sizeof(eth_header_t);
+  uint32_t hdr_len = (ip->version_ihl & 0x0F) * 4;
+  uint32_t total_len = htons(ip->total_length);
+  if (hdr_len < sizeof(ip_header_t) || total_len < hdr_len || total_len > ip_len)
+    return -1;
+
   uint32_t src_ip = __builtin_bswap32(ip->src_ip);
-  uint8_t *payload = buffer + sizeof(eth_header_t) + sizeof(ip_header_t);
-  uint32_t payload_len = len - sizeof(eth_header_t) - sizeof(ip_header_t);
+  uint8_t *payload = (uint8_t *)ip + hdr_len;
+  uint32_t payload_len = total_len - hdr_len;
 
   if (ip->protocol == IP_PROTO_ICMP) {
     return icmp_process(payload, payload_len);
   } else if (ip->protocol == IP_PROTO_TCP) {
-    // Debug: Show we received TCP packet
-    static int tcp_packet_count = 0;
-    tcp_packet_count++;
-    if (tcp_packet_count <= 5) {  // Only show first 5 to avoid spam
-      extern void puts(const char*);
-      puts("[IP] Received TCP packet #");
-      extern void putc(char);
-      putc('0' + tcp_packet_count);
-      puts("\n");
-    }
+    TRACE_DEBUG(TR_IP_RX_TCP, src_ip, payload_len, 0, 0);
     return tcp_process(src_ip, payload, payload_len);
   } else if (ip->protocol == IP_PROTO_UDP) {
     return udp_process(src_ip, payload, payload_len);
@@ -399,27 +363,11 @@ static int udp_send_packet(uint32_t dest_ip, uint16_t dest_port,
   udp->length = htons(sizeof(udp_header_t) + len);
   udp->checksum = 0; // Optional in IPv4
 
-  for (int i = 0; i < len; i++) {
-    buf[sizeof(udp_header_t) + i] = data[i];
-  }
+  memcpy(buf + sizeof(udp_header_t), data, len);
 
   return ip_send(dest_ip, IP_PROTO_UDP, buf, sizeof(udp_header_t) + len);
 }
 
-// Helper string functions
-static int str_cmp(const char *a, const char *b) {
-  while (*a && *a == *b) {
-    a++;
-    b++;
-  }
-  return *(const unsigned char *)a - *(const unsigned char *)b;
-}
-
-static void str_copy(char *dest, const char *src) {
-  while ((*dest++ = *src++))
-    ;
-}
-
 // Simple DNS Cache (Last resolved)
 static char last_dns_host[64];
 static uint32_t last_dns_ip;
@@ -441,16 +389,20 @@ static const struct {
 };
 
 int dns_resolve(const char *hostname) {
+  // The cache below holds the name, which bounds what we can look up
+  if (strlen(hostname) >= sizeof(last_dns_host))
+    return 0;
+
   // Check rudimentary cache
-  if (str_cmp(last_dns_host, hostname) == 0 && last_dns_ip != 0) {
+  if (strcmp(last_dns_host, hostname) == 0 && last_dns_ip != 0) {
     return last_dns_ip;
   }
   
   // Check static DNS entries first (workaround for VirtIO RX not working)
   for (int i = 0; static_dns[i].hostname != NULL; i++) {
-    if (str_cmp(hostname, static_dns[i].hostname) == 0) {
+    if (strcmp(hostname, static_dns[i].hostname) == 0) {
       last_dns_ip = static_dns[i].ip;
-      str_copy(last_dns_host, hostname);
+      strlcpy(last_dns_host, hostname, sizeof(last_dns_host));
       return static_dns[i].ip;
     }
   }
@@ -504,15 +456,15 @@ int dns_resolve(const char *hostname) {
 
   // Clear previous DNS answer
   last_dns_ip = 0;
-  str_copy(last_dns_host, hostname);
+  strlcpy(last_dns_host, hostname, sizeof(last_dns_host));
 
   // Send DNS query multiple times for reliability
   for (int retry = 0; retry < 5; retry++) {
     udp_send_packet(dns_server, 53, 52000 + (get_ticks() % 1000), buf, query_len);
 
     // Wait for response with aggressive polling
-    uint32_t start = get_ticks();
-    while (get_ticks() - start < 54) { // ~3 seconds per retry
+    uint32_t start = clock_ms();
+    while (clock_ms() - start < 3000) { // 3 seconds per retry
       // Poll multiple times per tick
       for (int i = 0; i < 10; i++) {
         netif_poll(); // Poll for incoming packets
@@ -525,57 +477,44 @@ int dns_resolve(const char *hostname) {
   return 0; // Failed after retries
 }
 
+// Skip a possibly compressed DNS name; NULL if it runs past end
+static const uint8_t *dns_skip_name(const uint8_t *p, const uint8_t *end) {
+  while (p < end) {
+    if ((*p & 0xC0) == 0xC0) // Compression pointer ends the name
+      return (end - p >= 2) ? p + 2 : NULL;
+    if (*p == 0) // Root
+      return p + 1;
+    p += (*p) + 1; // Skip label
+  }
+  return NULL;
+}
+
 // UDP Process (extracted from ip_receive dispatch)
 int udp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len) {
-  extern void puts(const char*);
-  (void)src_ip;
   if (len < sizeof(udp_header_t))
     return -1;
 
   const udp_header_t *udp = (const udp_header_t *)packet;
-  uint32_t payload_len = htons(udp->length) - sizeof(udp_header_t);
+  uint32_t udp_len = htons(udp->length);
+  if (udp_len < sizeof(udp_header_t) || udp_len > len)
+    return -1;
+  uint32_t payload_len = udp_len - sizeof(udp_header_t);
   const uint8_t *data = packet + sizeof(udp_header_t);
   
   uint16_t src_port = htons(udp->src_port);
   uint16_t dst_port = htons(udp->dest_port);
   
-  // Debug: Show UDP packet info
-  static int udp_count = 0;
-  udp_count++;
-  if (udp_count <= 10) {
-    puts("[UDP] Received packet #");
-    extern void putc(char);
-    putc('0' + (udp_count / 10));
-    putc('0' + (udp_count % 10));
-    puts(" src=");
-    putc('0' + (src_port / 10));
-    putc('0' + (src_port % 10));
-    puts(" dst=");
-    putc('0' + (dst_port / 10));
-    putc('0' + (dst_port % 10));
-    puts("\n");
-  }
+  TRACE_DEBUG(TR_UDP_RX, src_ip, src_port, dst_port, payload_len);
 
   // Check if DHCP response (Source port 67, dest port 68)
   if (src_port == 67 && dst_port == 68) {
-    puts("[DHCP] Received DHCP packet! payload_len=");
-    extern void putc(char);
-    char buf[8];
-    buf[0] = '0' + (payload_len / 1000) % 10;
-    buf[1] = '0' + (payload_len / 100) % 10;
-    buf[2] = '0' + (payload_len / 10) % 10;
-    buf[3] = '0' + payload_len % 10;
-    buf[4] = '\0';
-    puts(buf);
-    puts("\n");
-    
+    TRACE_INFO(TR_DHCP_RX, payload_len, 0, 0, 0);
+
     extern int dhcp_process(network_interface_t *iface, const uint8_t *packet, uint32_t len);
     network_interface_t *iface = netif_get_default();
     if (iface) {
       int result = dhcp_process(iface, data, payload_len);
-      puts("[DHCP] dhcp_process returned: ");
-      putc('0' + (result & 0xF));
-      puts("\n");
+      TRACE_INFO(TR_DHCP_RESULT, result, 0, 0, 0);
       return result;
     }
     return 0;
@@ -587,6 +526,7 @@ int udp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len) {
     if (payload_len < sizeof(dns_header_t))
       return -1;
     const dns_header_t *d = (const dns_header_t *)data;
+    const uint8_t *end = data + payload_len;
 
     // Skip Header
     const uint8_t *p = data + sizeof(dns_header_t);
@@ -594,23 +534,18 @@ int udp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len) {
     // Skip Questions
     int q_count = htons(d->q_count);
     for (int i = 0; i < q_count; i++) {
-      while (*p != 0)
-        p += (*p) + 1; // Skip labels
-      p++;             // Skip root
-      p += 4;          // Skip QTYPE, QCLASS
+      p = dns_skip_name(p, end);
+      if (!p || end - p < 4)
+        return -1;
+      p += 4; // Skip QTYPE, QCLASS
     }
 
     // Parse Answers
     int ans_count = htons(d->ans_count);
     for (int i = 0; i < ans_count; i++) {
-      // Name pointer (could be compressed 0xC0xx)
-      if ((*p & 0xC0) == 0xC0)
-        p += 2;
-      else {
-        while (*p != 0)
-          p += (*p) + 1;
-        p++;
-      }
+      p = dns_skip_name(p, end);
+      if (!p || end - p < 10)
+        return -1;
 
       uint16_t type = (p[0] << 8) | p[1];
       // uint16_t class = (p[2] << 8) | p[3];
@@ -618,9 +553,11 @@ int udp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len) {
       uint16_t dlen = (p[8] << 8) | p[9];
 
       p += 10; // Header of RR
+      if (end - p < dlen)
+        return -1;
 
       if (type == 1 && dlen == 4) { // A Record
-        uint32_t ip = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+        uint32_t ip = ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
         last_dns_ip = ip; // Store global result
         return 0;
       }
@@ -650,13 +587,26 @@ static struct {
   uint16_t remote_port;
   uint32_t snd_nxt;
   uint32_t rcv_nxt;
-  // Larger receive buffer for better performance
-  uint8_t rx_buffer[16384]; // 16KB buffer
+  // Receive buffer, allocated by tcp_connect and freed by tcp_close
+  uint8_t *rx_buffer;
   uint32_t rx_len;
   uint32_t rx_processed;
   volatile bool has_data;
 } tcb;
 
+#define TCP_RX_BUFFER_SIZE 16384
+
+extern void *kmalloc(uint32_t size);
+extern void kfree(void *ptr);
+
+static void tcp_release_rx_buffer(void) {
+  kfree(tcb.rx_buffer);
+  tcb.rx_buffer = NULL;
+  tcb.rx_len = 0;
+  tcb.rx_processed = 0;
+  tcb.has_data = false;
+}
+
 // TCP Pseudo-Header for Checksum
 typedef struct {
   uint32_t src_ip;
@@ -666,8 +616,8 @@ typedef struct {
   uint16_t tcp_length;
 } __attribute__((packed)) tcp_pseudo_header_t;
 
-static uint16_t tcp_checksum(uint32_t src_ip, uint32_t dest_ip,
-                             const void *data, uint16_t len) {
+uint16_t tcp_checksum(uint32_t src_ip, uint32_t dest_ip, const void *data,
+                      uint16_t len) {
   tcp_pseudo_header_t ph;
   ph.src_ip = htonl(src_ip);
   ph.dest_ip = htonl(dest_ip);
@@ -684,17 +634,9 @@ static uint16_t tcp_checksum(uint32_t src_ip, uint32_t dest_ip,
     sum += word;
   }
 
-  // Sum TCP segment in network byte order (big-endian)
-  const uint8_t *data_ptr = (const uint8_t *)data;
-  for (size_t i = 0; i < (size_t)(len & ~1); i += 2) {
-    uint16_t word = (data_ptr[i] << 8) | data_ptr[i + 1];
-    sum += word;
-  }
-
-  if (len & 1) {
-    uint16_t word = data_ptr[len - 1] << 8; // high byte, low byte 0
-    sum += word;
-  }
+  // Sum TCP segment; swapping the little-endian sum gives the big-endian
+  // one, including an odd last byte as the high byte of a padded word
+  sum += htons(csum_partial(data, len));
 
   while (sum >> 16) {
     sum = (sum & 0xFFFF) + (sum >> 16);
@@ -726,9 +668,7 @@ static int tcp_send_packet(uint32_t dest_ip, uint16_t dest_port,
 
   // Copy payload
   if (payload && payload_len > 0) {
-    for (uint32_t i = 0; i < payload_len; i++) {
-      buf[sizeof(tcp_header_t) + i] = payload[i];
-    }
+    memcpy(buf + sizeof(tcp_header_t), payload, payload_len);
   }
 
   // Calculate Checksum
@@ -740,7 +680,6 @@ static int tcp_send_packet(uint32_t dest_ip, uint16_t dest_port,
 
 // Process Incoming TCP
 int tcp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len) {
-  extern void puts(const char*);
   (void)src_ip;
   if (len < sizeof(tcp_header_t))
     return -1;
@@ -752,21 +691,20 @@ int tcp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len) {
     return 0;
   // We should check ports but ignoring for simplicity in demo
 
+  uint32_t hdr_len = (tcp->data_offset_reserved >> 4) * 4;
+  if (hdr_len < sizeof(tcp_header_t) || hdr_len > len)
+    return -1;
+
   uint32_t seq = __builtin_bswap32(tcp->sequence);
   uint32_t ack = __builtin_bswap32(tcp->ack_num);
-  uint32_t seg_len = len - ((tcp->data_offset_reserved >> 4) * 4);
+  uint32_t seg_len = len - hdr_len;
 
   if (tcb.state == TCP_SYN_SENT) {
-    puts("[TCP] Received packet in SYN_SENT state, flags=0x");
-    extern void putc(char);
-    const char hex[] = "0123456789ABCDEF";
-    putc(hex[(tcp->flags >> 4) & 0xF]);
-    putc(hex[tcp->flags & 0xF]);
-    puts("\n");
-    
+    TRACE_DEBUG(TR_TCP_RX_SYN_SENT, tcp->flags, 0, 0, 0);
+
     if ((tcp->flags & TCP_FLAG_SYN) && (tcp->flags & TCP_FLAG_ACK)) {
       // Received SYN-ACK
-      puts("[TCP] Got SYN-ACK! Sending ACK...\n");
+      TRACE_INFO(TR_TCP_SYNACK, seq, ack, 0, 0);
       tcb.rcv_nxt = seq + 1;
       tcb.snd_nxt = ack;
       tcb.state = TCP_ESTABLISHED;
@@ -782,14 +720,12 @@ int tcp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len) {
     }
     if (seg_len > 0) {
       // Data received
+      TRACE_DEBUG(TR_TCP_RX_DATA, seq, seg_len, 0, 0);
       // Simplified: Copy to buffer
-      uint32_t hdr_len = (tcp->data_offset_reserved >> 4) * 4;
       const uint8_t *data = packet + hdr_len;
 
-      if (tcb.rx_len + seg_len < 16384) {
-        for (uint32_t i = 0; i < seg_len; i++) {
-          tcb.rx_buffer[tcb.rx_len + i] = data[i];
-        }
+      if (tcb.rx_buffer && tcb.rx_len + seg_len < TCP_RX_BUFFER_SIZE) {
+        memcpy(tcb.rx_buffer + tcb.rx_len, data, seg_len);
         tcb.rx_len += seg_len;
         tcb.has_data = true;
 
@@ -850,13 +786,18 @@ int tcp_connect(uint32_t dest_ip, uint16_t dest_port) {
 
   // Send SYN with retries
   extern void puts(const char*);
-  extern void putc(char);
+
+  if (!tcb.rx_buffer) {
+    tcb.rx_buffer = kmalloc(TCP_RX_BUFFER_SIZE);
+    if (!tcb.rx_buffer) {
+      puts("[TCP] ERROR: Out of memory for receive buffer!\n");
+      return -1;
+    }
+  }
   
   for (int retry = 0; retry < 5; retry++) {
     if (retry > 0) {
-      puts("[TCP] Retry ");
-      putc('0' + retry);
-      puts("/5...\n");
+      kprintf("[TCP] Retry %d/5...\n", retry);
     }
     
     int sent = tcp_send_packet(tcb.remote_ip, tcb.remote_port, tcb.local_port, tcb.snd_nxt,
@@ -870,7 +811,7 @@ int tcp_connect(uint32_t dest_ip, uint16_t dest_port) {
     tcb.state = TCP_SYN_SENT;
 
     // Wait for SYN-ACK with aggressive polling
-    uint32_t start = get_ticks();
+    uint32_t start = clock_ms();
     int poll_count = 0;
     while (tcb.state != TCP_ESTABLISHED) {
       // Poll multiple times per tick for better responsiveness
@@ -891,7 +832,7 @@ int tcp_connect(uint32_t dest_ip, uint16_t dest_port) {
         }
       }
       
-      if (get_ticks() - start > 90) { // ~5 seconds timeout per retry
+      if (clock_ms() - start > 5000) { // 5 seconds timeout per retry
         puts("[TCP] Timeout - no SYN-ACK received\n");
         // Debug: check if any packets were received
         extern int debug_rx_state(void);
@@ -905,6 +846,7 @@ int tcp_connect(uint32_t dest_ip, uint16_t dest_port) {
   }
 
   tcb.state = TCP_CLOSED;
+  tcp_release_rx_buffer();
   puts("[TCP] Connection failed after all retries\n");
   return -1; // Failed after retries
 }
@@ -924,7 +866,7 @@ int tcp_send(int socket, const void *data, uint32_t len) {
 
 int tcp_receive(int socket, void *buffer, uint32_t max_len) {
   (void)socket;
-  uint32_t start = get_ticks();
+  uint32_t start = clock_ms();
   // Wait for data with aggressive polling
   while (!tcb.has_data && tcb.state == TCP_ESTABLISHED) {
     // Poll multiple times per tick for better responsiveness
@@ -934,7 +876,7 @@ int tcp_receive(int socket, void *buffer, uint32_t max_len) {
         break;
     }
     
-    if (get_ticks() - start > 360) // ~20 seconds timeout
+    if (clock_ms() - start > 20000) // 20 seconds timeout
       break;
   }
 
@@ -944,14 +886,14 @@ int tcp_receive(int socket, void *buffer, uint32_t max_len) {
   uint32_t available = tcb.rx_len - tcb.rx_processed;
   uint32_t to_copy = (available > max_len) ? max_len : available;
 
-  char *buf = (char *)buffer;
-  for (uint32_t i = 0; i < to_copy; i++) {
-    buf[i] = tcb.rx_buffer[tcb.rx_processed + i];
-  }
+  memcpy(buffer, tcb.rx_buffer + tcb.rx_processed, to_copy);
   tcb.rx_processed += to_copy;
 
   if (tcb.rx_processed == tcb.rx_len) {
     tcb.has_data = false; // All read
+    // Rewind so the next segments reuse the whole buffer
+    tcb.rx_len = 0;
+    tcb.rx_processed = 0;
   }
 
   return to_copy;
@@ -964,5 +906,6 @@ int tcp_close(int socket) {
                     tcb.rcv_nxt, TCP_FLAG_FIN | TCP_FLAG_ACK, NULL, 0);
     tcb.state = TCP_CLOSED;
   }
+  tcp_release_rx_buffer();
   return 0;
 }
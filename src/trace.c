@@ -0,0 +1,203 @@
+/*
+ * RO-DOS Kernel Trace Ring
+ * Lock-free multi-producer ring of binary trace records (see trace.h).
+ *
+ * Writers claim a slot with a locked xadd on trace_head, fill it and
+ * publish it by storing its sequence number last. Readers only accept a
+ * slot whose stored sequence matches the one they expect, so records that
+ * are half-written or already overwritten are skipped instead of printed
+ * as garbage.
+ */
+
+#include "../include/trace.h"
+#include "../include/clock.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TRACE_RING_SIZE 1024        /* Power of two */
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+static trace_record_t trace_ring[TRACE_RING_SIZE];
+static volatile uint32_t trace_head = 0;     /* Next sequence to hand out */
+static volatile uint32_t trace_floor = 0;    /* Sequences below this are cleared */
+
+/* Decode table, indexed by event ID. Format: %u decimal, %d signed decimal,
+ * %x hex, %I IPv4 */
+static const struct {
+    const char *subsys;
+    const char *fmt;
+} trace_events[TR_EVENT_COUNT] = {
+    [TR_NONE]            = {"trace", "empty"},
+    [TR_NETIF_TX]        = {"netif", "tx len=%u result=%d"},
+    [TR_NETIF_TX_BADARG] = {"netif", "tx rejected, invalid params len=%u"},
+    [TR_NETIF_TX_NODRV]  = {"netif", "tx rejected, no send_packet driver"},
+    [TR_IP_ROUTE]        = {"ip", "src=%I gw=%I"},
+    [TR_IP_RX_TCP]       = {"ip", "rx tcp src=%I len=%u"},
+    [TR_UDP_RX]          = {"udp", "rx src=%I sport=%u dport=%u len=%u"},
+    [TR_DHCP_RX]         = {"dhcp", "rx payload_len=%u"},
+    [TR_DHCP_RESULT]     = {"dhcp", "dhcp_process returned %d"},
+    [TR_TCP_RX_SYN_SENT] = {"tcp", "rx in SYN_SENT flags=0x%x"},
+    [TR_TCP_SYNACK]      = {"tcp", "SYN-ACK seq=%u ack=%u, sending ACK"},
+    [TR_TCP_RX_DATA]     = {"tcp", "rx data seq=%u len=%u"},
+};
+
+static const char trace_level_tag[] = "?EWID";
+
+void trace_emit(uint8_t level, uint16_t event, uint32_t a0, uint32_t a1,
+                uint32_t a2, uint32_t a3) {
+    uint32_t seq = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    trace_record_t *r = &trace_ring[seq & TRACE_RING_MASK];
+
+    r->seq = 0;
+    __asm__ volatile ("" ::: "memory");
+    r->event = event;
+    r->level = level;
+    r->tsc = clock_tsc();
+    r->arg[0] = a0;
+    r->arg[1] = a1;
+    r->arg[2] = a2;
+    r->arg[3] = a3;
+    __asm__ volatile ("" ::: "memory");
+    r->seq = seq + 1;
+}
+
+/* Oldest sequence still held in the ring */
+static uint32_t trace_first(void) {
+    uint32_t head = trace_head;
+    uint32_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    return first < trace_floor ? trace_floor : first;
+}
+
+uint32_t trace_count(void) {
+    return trace_head - trace_first();
+}
+
+uint32_t trace_total(void) {
+    return trace_head;
+}
+
+void trace_clear(void) {
+    trace_floor = trace_head;
+}
+
+int trace_get(uint32_t i, trace_record_t *out) {
+    uint32_t seq = trace_first() + i;
+    if (seq >= trace_head) return -1;
+
+    const trace_record_t *r = &trace_ring[seq & TRACE_RING_MASK];
+    if (r->seq != seq + 1) return -1;
+    *out = *r;
+    /* A writer may have lapped us while copying */
+    return (r->seq == seq + 1 && out->event < TR_EVENT_COUNT) ? 0 : -1;
+}
+
+/* Minimal appender used by the decoder */
+typedef struct {
+    char *buf;
+    int size;
+    int len;
+} trace_out_t;
+
+static void tr_putc(trace_out_t *o, char c) {
+    if (o->len < o->size - 1) o->buf[o->len++] = c;
+}
+
+static void tr_puts(trace_out_t *o, const char *s) {
+    while (*s) tr_putc(o, *s++);
+}
+
+static void tr_putu(trace_out_t *o, uint32_t v, int width, char pad) {
+    char tmp[11];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n < width--) tr_putc(o, pad);
+    while (n) tr_putc(o, tmp[--n]);
+}
+
+static void tr_putx(trace_out_t *o, uint32_t v) {
+    static const char hex[] = "0123456789ABCDEF";
+    bool started = false;
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        uint32_t d = (v >> shift) & 0xF;
+        if (d || started || shift == 0) {
+            tr_putc(o, hex[d]);
+            started = true;
+        }
+    }
+}
+
+static void tr_putip(trace_out_t *o, uint32_t ip) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        tr_putu(o, (ip >> shift) & 0xFF, 0, ' ');
+        if (shift) tr_putc(o, '.');
+    }
+}
+
+int trace_format(const trace_record_t *rec, char *buf, int size) {
+    trace_out_t o = {buf, size, 0};
+
+    /* [seconds.micros] since clock_init */
+    uint64_t us = 0;
+    if (clock_tsc_khz() && rec->tsc >= clock_tsc_base()) {
+        us = clock_cycles_to_us(rec->tsc - clock_tsc_base());
+    }
+    uint32_t frac;
+    uint32_t secs = (uint32_t)clock_div64(us, 1000000, &frac);
+
+    tr_putc(&o, '[');
+    tr_putu(&o, secs, 5, ' ');
+    tr_putc(&o, '.');
+    tr_putu(&o, frac, 6, '0');
+    tr_puts(&o, "] ");
+    tr_putc(&o, trace_level_tag[rec->level <= TRACE_LVL_DEBUG ? rec->level : 0]);
+    tr_putc(&o, ' ');
+
+    const char *subsys = trace_events[rec->event].subsys;
+    const char *fmt = trace_events[rec->event].fmt;
+    if (!subsys) {
+        subsys = "trace";
+        fmt = "unknown event";
+    }
+    tr_puts(&o, subsys);
+    tr_puts(&o, ": ");
+
+    int argi = 0;
+    for (const char *p = fmt; *p; p++) {
+        if (*p != '%' || !p[1] || argi >= 4) {
+            tr_putc(&o, *p);
+            continue;
+        }
+        uint32_t v = rec->arg[argi++];
+        switch (*++p) {
+            case 'u': tr_putu(&o, v, 0, ' '); break;
+            case 'd':
+                /* Args are stored as uint32_t; -1 comes back as 0xFFFFFFFF */
+                if ((int32_t)v < 0) {
+                    tr_putc(&o, '-');
+                    v = 0u - v;
+                }
+                tr_putu(&o, v, 0, ' ');
+                break;
+            case 'x': tr_putx(&o, v); break;
+            case 'I': tr_putip(&o, v); break;
+            default:  tr_putc(&o, *p); break;
+        }
+    }
+
+    o.buf[o.len] = '\0';
+    return o.len;
+}
+
+void trace_dump(void (*out)(const char *line, void *ctx), void *ctx) {
+    char line[128];
+    uint32_t n = trace_count();
+    for (uint32_t i = 0; i < n; i++) {
+        trace_record_t rec;
+        if (trace_get(i, &rec) != 0) continue;
+        trace_format(&rec, line, sizeof(line));
+        out(line, ctx);
+    }
+}
@@ -1,25 +1,74 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "../include/clock.h"
+#include "../include/cpu.h"
+#include "../include/kstring.h"
 
 /* String Operations */
 
+/*
+ * strlen, strchr and strcmp test a 32-bit word per step. MEM_HAS_ZERO
+ * flags the top bit of a byte in x that is zero; a borrow can also flag
+ * bytes above a real zero, so only the lowest flag is trusted. An aligned
+ * word never crosses a page, so reading the rest of the word holding the
+ * terminator is safe; the host ASan build must be told so.
+ */
+#define MEM_HAS_ZERO(x) (((x) - 0x01010101u) & ~(x) & 0x80808080u)
+
+/* Byte index of the lowest flag in a MEM_HAS_ZERO result */
+#define MEM_ZERO_INDEX(m) ((size_t)__builtin_ctz(m) >> 3)
+
+#ifdef __SANITIZE_ADDRESS__
+#define STR_WORD_SCAN __attribute__((no_sanitize_address))
+#else
+#define STR_WORD_SCAN
+#endif
+
+typedef uint32_t __attribute__((may_alias)) str_word_t;
+typedef uint32_t __attribute__((may_alias, aligned(1))) str_uword_t;
+
 /* Calculate string length */
-size_t strlen(const char *str) {
+STR_WORD_SCAN size_t strlen(const char *str) {
     if (!str) return 0;
-    size_t len = 0;
-    while (str[len]) len++;
-    return len;
+    const char *p = str;
+    while ((size_t)p & 3) {
+        if (!*p) return (size_t)(p - str);
+        p++;
+    }
+    for (;;) {
+        uint32_t z = MEM_HAS_ZERO(*(const str_word_t*)p);
+        if (z) return (size_t)(p - str) + MEM_ZERO_INDEX(z);
+        p += 4;
+    }
+}
+
+/* Copy string; returns a pointer to the terminator written in dest */
+char* stpcpy(char *dest, const char *src) {
+    if (!dest) return dest;
+    size_t len = strlen(src);
+    if (len) memcpy(dest, src, len);
+    dest[len] = '\0';
+    return dest + len;
 }
 
 /* Copy string from src to dest */
 char* strcpy(char *dest, const char *src) {
     if (!dest || !src) return dest;
-    char *ptr = dest;
-    while ((*ptr++ = *src++));
+    stpcpy(dest, src);
     return dest;
 }
 
+/* Copy into a buffer of size bytes, truncating; returns strlen(src) */
+size_t strlcpy(char *dest, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (!dest || size == 0) return len;
+    size_t n = (len < size) ? len : size - 1;
+    if (n) memcpy(dest, src, n);
+    dest[n] = '\0';
+    return len;
+}
+
 /* Copy at most n characters */
 char* strncpy(char *dest, const char *src, size_t n) {
     if (!dest || !src) return dest;
@@ -33,14 +82,33 @@ char* strncpy(char *dest, const char *src, size_t n) {
     return dest;
 }
 
-/* Compare two strings */
-int strcmp(const char *s1, const char *s2) {
-    if (!s1 || !s2) return 0;
-    while (*s1 && (*s1 == *s2)) {
-        s1++;
-        s2++;
+/* Compare two strings; NULL sorts before any string */
+STR_WORD_SCAN int strcmp(const char *s1, const char *s2) {
+    if (!s1 || !s2) return (s1 == s2) ? 0 : (s1 ? 1 : -1);
+    const unsigned char *a = (const unsigned char *)s1;
+    const unsigned char *b = (const unsigned char *)s2;
+    while ((size_t)a & 3) {
+        if (*a != *b || !*a) return *a - *b;
+        a++;
+        b++;
+    }
+    /* a is aligned, b may not be: load a word of b only if it stays
+     * inside one page */
+    for (;;) {
+        if (((size_t)b & 0xFFF) <= 0xFFC) {
+            uint32_t w = *(const str_word_t*)a;
+            if (w == *(const str_uword_t*)b && !MEM_HAS_ZERO(w)) {
+                a += 4;
+                b += 4;
+                continue;
+            }
+        }
+        /* The strings differ or end in these four bytes (or b is at a
+         * page edge) */
+        for (int i = 0; i < 4; i++, a++, b++) {
+            if (*a != *b || !*a) return *a - *b;
+        }
     }
-    return *(unsigned char *)s1 - *(unsigned char *)s2;
 }
 
 /* Compare first n characters */
@@ -57,9 +125,7 @@ int strncmp(const char *s1, const char *s2, size_t n) {
 /* Concatenate src to dest */
 char* strcat(char *dest, const char *src) {
     if (!dest || !src) return dest;
-    char *ptr = dest;
-    while (*ptr) ptr++;
-    while ((*ptr++ = *src++));
+    stpcpy(dest + strlen(dest), src);
     return dest;
 }
 
@@ -74,13 +140,25 @@ char* strncat(char *dest, const char *src, size_t n) {
 }
 
 /* Find character in string */
-char* strchr(const char *str, int c) {
+STR_WORD_SCAN char* strchr(const char *str, int c) {
     if (!str) return NULL;
-    while (*str) {
-        if (*str == (char)c) return (char*)str;
+    char ch = (char)c;
+    while ((size_t)str & 3) {
+        if (*str == ch) return (char*)str;
+        if (!*str) return NULL;
         str++;
     }
-    return (c == '\0') ? (char*)str : NULL;
+    /* Stop at the first byte that is either c or the terminator */
+    uint32_t pattern = (uint8_t)ch * 0x01010101u;
+    for (;;) {
+        uint32_t w = *(const str_word_t*)str;
+        uint32_t z = MEM_HAS_ZERO(w) | MEM_HAS_ZERO(w ^ pattern);
+        if (z) {
+            str += MEM_ZERO_INDEX(z);
+            return (*str == ch) ? (char*)str : NULL;
+        }
+        str += 4;
+    }
 }
 
 /* Find last occurrence of character */
@@ -345,65 +423,172 @@ uint32_t btoi(const char *str) {
 
 /* Memory Operations */
 
+/*
+ * The bulk of each operation runs as rep movsd / rep stosd (or 32-bit
+ * words for compares and searches) so it does not depend on the compiler
+ * optimizing a byte loop, which debug builds never do. Copies of 16 bytes
+ * or more first move single bytes until the destination is 4-byte
+ * aligned, then whole dwords, then the remaining 0-3 bytes. Large
+ * memcpy and memset calls go through cpu_ops, which cpu_init points at
+ * the SSE2 kernels when the CPU has them.
+ */
+#define MEM_WORD_MIN 16
+
+static inline void mem_copy_fwd(uint8_t *d, const uint8_t *s, size_t n) {
+    if (n >= MEM_WORD_MIN) {
+        size_t head = (0u - (size_t)d) & 3;
+        size_t words = (n - head) >> 2;
+        n = (n - head) & 3;
+        __asm__ volatile ("rep movsb\n\t"
+                          "mov %3, %2\n\t"
+                          "rep movsl"
+                          : "+D"(d), "+S"(s), "+c"(head)
+                          : "r"(words)
+                          : "memory");
+    }
+    __asm__ volatile ("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+}
+
+/* Same as mem_copy_fwd from the top down, for overlapping moves to a
+ * higher address. DF is set only inside the asm; the interrupt stubs
+ * clear it on entry. */
+static inline void mem_copy_bwd(uint8_t *d, const uint8_t *s, size_t n) {
+    uint8_t *dl = d + n - 1;
+    const uint8_t *sl = s + n - 1;
+    size_t tail = 0, words = 0;
+    if (n >= MEM_WORD_MIN) {
+        tail = (size_t)(dl + 1) & 3;
+        words = (n - tail) >> 2;
+        n = (n - tail) & 3;
+    } else {
+        tail = n;
+        n = 0;
+    }
+    __asm__ volatile ("std\n\t"
+                      "rep movsb\n\t"
+                      "sub $3, %0\n\t"
+                      "sub $3, %1\n\t"
+                      "mov %3, %2\n\t"
+                      "rep movsl\n\t"
+                      "add $3, %0\n\t"
+                      "add $3, %1\n\t"
+                      "mov %4, %2\n\t"
+                      "rep movsb\n\t"
+                      "cld"
+                      : "+D"(dl), "+S"(sl), "+c"(tail)
+                      : "r"(words), "r"(n)
+                      : "memory", "cc");
+}
+
+/* Baseline cpu_ops kernels */
+void mem_copy_rep(void *dest, const void *src, size_t n) {
+    mem_copy_fwd((uint8_t*)dest, (const uint8_t*)src, n);
+}
+
+/* Byte i of dest gets byte (i & 3) of pattern */
+void mem_fill_rep(void *dest, uint32_t pattern, size_t n) {
+    uint8_t *p = (uint8_t*)dest;
+    size_t i = 0;
+    if (n >= MEM_WORD_MIN) {
+        size_t head = (0u - (size_t)p) & 3;
+        for (; i < head; i++) p[i] = (uint8_t)(pattern >> (i * 8));
+        /* The aligned part starts head bytes into the pattern */
+        uint32_t word = head ? (pattern >> (head * 8)) | (pattern << (32 - head * 8)) : pattern;
+        size_t words = (n - head) >> 2;
+        uint8_t *w = p + head;
+        __asm__ volatile ("rep stosl" : "+D"(w), "+c"(words) : "a"(word) : "memory");
+        i = (size_t)(w - p);
+    }
+    for (; i < n; i++) p[i] = (uint8_t)(pattern >> ((i & 3) * 8));
+}
+
+/* Ones' complement sum of 16-bit words in memory order, folded but not
+ * inverted; an odd last byte counts as the low byte of a word */
+uint16_t mem_csum16(const void *data, size_t len) {
+    const uint16_t *buf = (const uint16_t*)data;
+    uint32_t sum = 0;
+    /* 0x10000 words of 0xFFFF would overflow sum, so fold as we go */
+    while (len > 1) {
+        size_t words = len >> 1;
+        if (words > 0x8000) words = 0x8000;
+        len -= words << 1;
+        while (words--) sum += *buf++;
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    if (len) sum += *(const uint8_t*)buf;
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
 /* Copy memory */
 void* memcpy(void *dest, const void *src, size_t n) {
     if (!dest || !src) return dest;
-    
-    uint8_t *d = (uint8_t*)dest;
-    const uint8_t *s = (const uint8_t*)src;
-    
-    while (n--) {
-        *d++ = *s++;
+    if (n >= CPU_OPS_MIN_BYTES) {
+        cpu_ops.copy(dest, src, n);
+        return dest;
     }
-    
+    mem_copy_fwd((uint8_t*)dest, (const uint8_t*)src, n);
     return dest;
 }
 
 /* Copy memory (handles overlapping regions) */
 void* memmove(void *dest, const void *src, size_t n) {
     if (!dest || !src || n == 0) return dest;
-    
+
     uint8_t *d = (uint8_t*)dest;
     const uint8_t *s = (const uint8_t*)src;
-    
-    if (d < s) {
-        /* Copy forward */
-        while (n--) {
-            *d++ = *s++;
-        }
+
+    if (d <= s || d >= s + n) {
+        /* Copy forward - safe unless dest starts inside src */
+        mem_copy_fwd(d, s, n);
     } else {
-        /* Copy backward */
-        d += n;
-        s += n;
-        while (n--) {
-            *--d = *--s;
-        }
+        mem_copy_bwd(d, s, n);
     }
-    
+
     return dest;
 }
 
 /* Set memory */
 void* memset(void *ptr, int value, size_t n) {
     if (!ptr) return ptr;
-    
+
     uint8_t *p = (uint8_t*)ptr;
-    uint8_t val = (uint8_t)value;
-    
-    while (n--) {
-        *p++ = val;
+    uint32_t fill = (uint8_t)value * 0x01010101u;
+
+    if (n >= CPU_OPS_MIN_BYTES) {
+        cpu_ops.fill(ptr, fill, n);
+        return ptr;
     }
-    
+    if (n >= MEM_WORD_MIN) {
+        size_t head = (0u - (size_t)p) & 3;
+        size_t words = (n - head) >> 2;
+        n = (n - head) & 3;
+        __asm__ volatile ("rep stosb\n\t"
+                          "mov %3, %1\n\t"
+                          "rep stosl"
+                          : "+D"(p), "+c"(head)
+                          : "a"(fill), "r"(words)
+                          : "memory");
+    }
+    __asm__ volatile ("rep stosb" : "+D"(p), "+c"(n) : "a"(fill) : "memory");
+
     return ptr;
 }
 
 /* Compare memory */
 int memcmp(const void *s1, const void *s2, size_t n) {
     if (!s1 || !s2) return 0;
-    
+
     const uint8_t *p1 = (const uint8_t*)s1;
     const uint8_t *p2 = (const uint8_t*)s2;
-    
+
+    /* Skip equal dwords; the byte loop finds the difference inside one */
+    while (n >= 4 && *(const uint32_t*)p1 == *(const uint32_t*)p2) {
+        p1 += 4;
+        p2 += 4;
+        n -= 4;
+    }
+
     while (n--) {
         if (*p1 != *p2) {
             return *p1 - *p2;
@@ -411,24 +596,37 @@ int memcmp(const void *s1, const void *s2, size_t n) {
         p1++;
         p2++;
     }
-    
+
     return 0;
 }
 
 /* Find byte in memory */
 void* memchr(const void *ptr, int value, size_t n) {
     if (!ptr) return NULL;
-    
+
     const uint8_t *p = (const uint8_t*)ptr;
     uint8_t val = (uint8_t)value;
-    
+
+    /* Bytes up to a dword boundary, then four at a time */
+    while (n && ((size_t)p & 3)) {
+        if (*p == val) return (void*)p;
+        p++;
+        n--;
+    }
+    uint32_t pattern = val * 0x01010101u;
+    while (n >= 4) {
+        uint32_t x = *(const uint32_t*)p ^ pattern;
+        if (MEM_HAS_ZERO(x)) break;
+        p += 4;
+        n -= 4;
+    }
     while (n--) {
         if (*p == val) {
             return (void*)p;
         }
         p++;
     }
-    
+
     return NULL;
 }
 
@@ -664,11 +862,19 @@ void reverse_array(int32_t *arr, size_t n) {
 
 /*  Sleep/Delay Functions */
 
-/* Sleep for specified milliseconds - simple busy-wait */
+/* Sleep for specified milliseconds - busy-waits on the TSC clock */
 void sleep_ms(uint32_t ms) {
     if (ms == 0) return;
-    
-    // Simple delay loop - approximately 1ms per iteration
+
+    if (clock_tsc_khz()) {
+        uint64_t end = clock_us() + (uint64_t)ms * 1000;
+        while (clock_us() < end) {
+            __asm__ volatile("pause");
+        }
+        return;
+    }
+
+    // Uncalibrated fallback: simple delay loop - approximately 1ms per iteration
     // This is a safe fallback that doesn't depend on system calls
     for (uint32_t i = 0; i < ms; i++) {
         // Approximate 1ms delay (adjust based on CPU speed)
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+Generate the kernel symbol table from `nm -n` output.
+
+Reads nm output on stdin and writes a C file that places the function
+symbols (sorted by address) into the .ksyms section. With empty input it
+produces an empty table, which is what the first link pass uses.
+
+NASM local labels (kmalloc.next_block) are skipped so samples and
+backtraces resolve to the enclosing function. GCC's clones and split-off
+parts in optimized builds (foo.constprop.0, foo.part.0, foo.cold) are
+kept under their full name.
+
+The table is compressed the way src/ksyms.c expects it:
+
+  addresses  one 32-bit base per block of KSYM_BLOCK symbols plus a 16-bit
+             offset from that base per symbol
+  names      a length byte followed by token bytes per symbol; each token
+             expands to a string from the token table. Tokens start as the
+             characters themselves, then the most frequent adjacent pair is
+             repeatedly merged into a free byte value (byte-pair encoding).
+             One 16-bit stream offset per block locates the names.
+"""
+
+import re
+import sys
+
+KSYM_BLOCK = 16
+
+GCC_CLONE_RE = re.compile(r'^[A-Za-z_][\w]*(\.(constprop|isra|part|cold|lto_priv|clone|localalias)(\.\d+)?)+$')
+
+
+def wanted(name):
+    return '.' not in name or GCC_CLONE_RE.match(name) is not None
+
+
+def build_tokens(names):
+    """Byte-pair encode names; returns (token strings, encoded names)."""
+    tokens = [None] * 256
+    for name in names:
+        for ch in name:
+            tokens[ord(ch)] = ch
+    free = [i for i in range(1, 256) if tokens[i] is None]
+    seqs = [[ord(ch) for ch in name] for name in names]
+
+    while free:
+        pairs = {}
+        for seq in seqs:
+            for a, b in zip(seq, seq[1:]):
+                pairs[(a, b)] = pairs.get((a, b), 0) + 1
+        if not pairs:
+            break
+        (a, b), count = max(pairs.items(), key=lambda kv: (kv[1], kv[0]))
+        # A token costs its expansion plus a terminator in the table
+        if count <= len(tokens[a]) + len(tokens[b]) + 1:
+            break
+        tok = free.pop(0)
+        tokens[tok] = tokens[a] + tokens[b]
+        for i, seq in enumerate(seqs):
+            out, j = [], 0
+            while j < len(seq):
+                if j + 1 < len(seq) and seq[j] == a and seq[j + 1] == b:
+                    out.append(tok)
+                    j += 2
+                else:
+                    out.append(seq[j])
+                    j += 1
+            seqs[i] = out
+    return tokens, seqs
+
+
+def c_array(out, ctype, name, values, per_line, fmt):
+    out.write('KSYMS const %s %s[] = {\n' % (ctype, name))
+    if not values:
+        values = [0]
+    for i in range(0, len(values), per_line):
+        out.write('    ' + ', '.join(fmt % v for v in values[i:i + per_line]) + ',\n')
+    out.write('};\n\n')
+
+
+def main():
+    syms = {}
+    for line in sys.stdin:
+        parts = line.split()
+        if len(parts) != 3:
+            continue
+        addr, kind, name = parts
+        if kind not in ('T', 't') or not wanted(name):
+            continue
+        syms.setdefault(int(addr, 16), name)
+
+    entries = sorted(syms.items())
+    addrs = [a for a, _ in entries]
+    names = [n for _, n in entries]
+
+    block_addrs, addr_offs = [], []
+    for i, addr in enumerate(addrs):
+        if i % KSYM_BLOCK == 0:
+            block_addrs.append(addr)
+        off = addr - block_addrs[-1]
+        if off > 0xFFFF:
+            sys.exit('gen_ksyms: block starting at 0x%08x spans more than 64 KB'
+                     % block_addrs[-1])
+        addr_offs.append(off)
+
+    tokens, seqs = build_tokens(names)
+    stream, block_names = [], []
+    for i, seq in enumerate(seqs):
+        if i % KSYM_BLOCK == 0:
+            block_names.append(len(stream))
+        if len(seq) > 255:
+            sys.exit('gen_ksyms: symbol %s is too long' % names[i])
+        stream.append(len(seq))
+        stream.extend(seq)
+    if len(stream) > 0xFFFF:
+        sys.exit('gen_ksyms: name stream exceeds 64 KB')
+
+    token_index, token_text, pos = [], [], 0
+    for tok in tokens:
+        token_index.append(pos)
+        text = tok or ''
+        token_text.append(text)
+        pos += len(text) + 1
+
+    out = sys.stdout
+    out.write('/* Generated by tools/gen_ksyms.py - do not edit */\n\n')
+    out.write('#include <stdint.h>\n\n')
+    out.write('#define KSYMS __attribute__((section(".ksyms"), used))\n\n')
+    out.write('KSYMS const uint32_t ksym_count = %d;\n\n' % len(entries))
+    c_array(out, 'uint32_t', 'ksym_block_addrs', block_addrs, 4, '0x%08x')
+    c_array(out, 'uint16_t', 'ksym_addr_offs', addr_offs, 8, '0x%04x')
+    c_array(out, 'uint16_t', 'ksym_block_names', block_names, 8, '%d')
+    c_array(out, 'uint8_t', 'ksym_names', stream, 12, '0x%02x')
+    c_array(out, 'uint16_t', 'ksym_token_index', token_index, 8, '%d')
+    out.write('KSYMS const char ksym_token_table[] =\n')
+    for i in range(0, len(token_text), 8):
+        out.write('    ' + ' '.join('"%s\\0"' % t for t in token_text[i:i + 8]) + '\n')
+    out.write('    "";\n')
+
+
+if __name__ == '__main__':
+    main()
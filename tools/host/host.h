@@ -0,0 +1,121 @@
+/*
+ * RO-DOS Host Harness Header
+ * Mock hardware for running kernel subsystems as a Linux process
+ *
+ * host_mocks.c provides every symbol the selected kernel sources import
+ * (console, keyboard, disk, clock, allocator, drivers). The disk is a
+ * plain image file, the network card is a pair of in-memory frame queues
+ * and the allocator is a shim over malloc with the kernel's heap limit.
+ */
+
+#ifndef _RODOS_HOST_H
+#define _RODOS_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/network.h"
+#include "host_env.h"
+
+/* Kernel entry points used by the harness */
+void cpu_init(void);
+int cmd_dispatch(const char *line);
+void cmd_init_silent(void);
+int dns_resolve(const char *hostname);
+int tcp_connect(uint32_t dest_ip, uint16_t dest_port);
+int tcp_receive(int socket, void *buffer, uint32_t max_len);
+int tcp_close(int socket);
+int tcp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len);
+int udp_process(uint32_t src_ip, const uint8_t *packet, uint32_t len);
+void scrollback_grow(void);
+void scrollback_capture_line(void);
+void scrollback_save_line(const char *line, const uint8_t *attrs, uint16_t line_num);
+void scrollback_scroll_up(void);
+void scrollback_scroll_down(void);
+int32_t scrollback_get_offset(void);
+void scrollback_reset(void);
+bool scrollback_is_active(void);
+
+/* Addresses of the mock interface and its peer */
+#define HOST_IP       IP_ADDR(10, 0, 2, 15)
+#define HOST_GW       IP_ADDR(10, 0, 2, 2)
+#define HOST_DNS      IP_ADDR(10, 0, 2, 3)
+#define HOST_NETMASK  IP_ADDR(255, 255, 255, 0)
+#define HOST_PEER_IP  IP_ADDR(10, 0, 2, 100)
+
+#define HOST_FRAME_MAX 1536
+
+/* Monotonic wall clock */
+uint64_t host_now_ns(void);
+
+/* Console: kernel output is counted and dropped unless echo is on */
+void host_console_echo(bool on);
+uint64_t host_console_bytes(void);
+
+/* Also copy kernel output into buf (NUL-terminated, truncated at size);
+ * size 0 stops capturing */
+void host_console_capture(char *buf, uint32_t size);
+uint32_t host_console_captured(void);
+
+/* Keyboard: queued keys are returned by c_getkey, ESC once empty */
+void host_keys_push(const char *s);
+void host_keys_push_key(uint16_t key);
+void host_keys_clear(void);
+
+/* Disk: file-backed, created zero-filled; LBAs past the end fail */
+int host_disk_open(const char *path, uint32_t sectors);
+void host_disk_close(void);
+uint64_t host_disk_reads(void);
+uint64_t host_disk_writes(void);
+
+/* Allocator shim: bytes and blocks currently held by kmalloc */
+uint32_t host_heap_used(void);
+uint32_t host_heap_blocks(void);
+
+/* Network: registers a mock interface configured as 10.0.2.15/24 */
+void host_net_init(void);
+void host_net_reset(void);
+int host_net_rx_push(const uint8_t *frame, uint32_t len);
+int host_net_tx_pop(uint8_t *frame, uint32_t max_len);
+uint32_t host_net_tx_pending(void);
+uint64_t host_net_tx_dropped(void);
+
+/* With the peer enabled, frames sent by the kernel are answered in the RX
+ * queue: TCP SYNs get a SYN-ACK and DNS queries an A record. */
+void host_net_set_peer(bool on);
+
+typedef struct {
+    bool established;
+    uint32_t remote_ip;        /* The kernel's view: the peer's address */
+    uint16_t local_port;       /* Kernel's port */
+    uint16_t remote_port;      /* Peer's port */
+    uint32_t peer_seq;         /* Next sequence number the peer sends */
+    uint32_t kernel_seq;       /* Next sequence number the kernel sends */
+} host_tcp_peer_t;
+
+const host_tcp_peer_t *host_net_tcp_peer(void);
+void host_net_tcp_advance(uint32_t len);
+
+/* Address the peer answers for hostname */
+uint32_t host_dns_answer_ip(const char *hostname);
+
+/* Frame builders; each returns the frame length */
+uint32_t host_build_udp(uint8_t *frame, uint32_t src_ip, uint32_t dst_ip,
+                        uint16_t sport, uint16_t dport,
+                        const uint8_t *payload, uint32_t len);
+uint32_t host_build_tcp(uint8_t *frame, uint32_t src_ip, uint32_t dst_ip,
+                        uint16_t sport, uint16_t dport, uint32_t seq,
+                        uint32_t ack, uint8_t flags,
+                        const uint8_t *payload, uint32_t len);
+uint32_t host_build_arp(uint8_t *frame, uint16_t opcode, uint32_t sender_ip,
+                        const uint8_t *sender_mac, uint32_t target_ip);
+uint32_t host_build_icmp(uint8_t *frame, uint32_t src_ip, uint8_t type,
+                         uint32_t len);
+
+/* DNS response payload for name with one A record; returns length */
+uint32_t host_build_dns_reply(uint8_t *out, uint16_t id, const char *name,
+                              uint32_t ip);
+
+/* DHCP reply payload matching the client's transaction; returns length */
+uint32_t host_build_dhcp_reply(uint8_t *out, uint8_t msg_type, uint32_t yiaddr);
+
+#endif /* _RODOS_HOST_H */
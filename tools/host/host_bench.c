@@ -0,0 +1,258 @@
+/*
+ * RO-DOS Host Benchmarks
+ * Times the network stack, filesystem commands, string/memory library and
+ * scrollback buffer built as a Linux process (make host-bench).
+ *
+ * Output mirrors the in-kernel BENCH command, with nanoseconds in place of
+ * TSC cycles:
+ *   BENCH-BEGIN host clock=ns
+ *   BENCH <name> iters=<n> bytes=<n> ns=<total> per_iter_ns=<n>
+ *   BENCH-END count=<n>
+ *
+ * Usage: host_bench [-d disk.img] [-f substring] [-s scale] [-v]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+
+/* utils.c */
+extern char *itoa(int32_t value, char *str, int base);
+
+/* crc32c.c */
+extern uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+/* kprintf.c */
+extern int ksnprintf(char *buf, size_t size, const char *fmt, ...);
+
+#define BENCH_DISK_SECTORS 8192     /* 4 MB covers the FS area (LBA 499..2748) */
+
+static const char *bench_filter = NULL;
+static uint32_t bench_scale = 1;
+static int bench_count = 0;
+static volatile uint32_t bench_sink;
+
+static bool bench_enabled(const char *name) {
+    return !bench_filter || strstr(name, bench_filter) != NULL;
+}
+
+static void bench_report(const char *name, uint32_t iters, uint32_t bytes,
+                         uint64_t ns) {
+    printf("BENCH %s iters=%u bytes=%u ns=%llu per_iter_ns=%llu\n", name,
+           iters, bytes, (unsigned long long)ns,
+           (unsigned long long)(iters ? ns / iters : 0));
+    fflush(stdout);
+    bench_count++;
+}
+
+static void bench_error(const char *name, const char *reason) {
+    printf("BENCH-ERROR %s %s\n", name, reason);
+    fflush(stdout);
+}
+
+/* Runs body iters times (after scaling) and reports it */
+#define BENCH(name, n, bytes, body)                                    \
+    do {                                                               \
+        if (!bench_enabled(name)) break;                               \
+        uint32_t iters_ = (n) * bench_scale;                           \
+        uint64_t t0_ = host_now_ns();                                  \
+        for (uint32_t i = 0; i < iters_; i++) { body; }                \
+        bench_report(name, iters_, (bytes), host_now_ns() - t0_);      \
+    } while (0)
+
+static void drain_tx(void) {
+    uint8_t frame[HOST_FRAME_MAX];
+    while (host_net_tx_pop(frame, sizeof(frame)) > 0)
+        ;
+}
+
+/* Checksums and frame parsing */
+
+static void bench_net(void) {
+    static uint8_t buf[1500];
+    static uint8_t frame[HOST_FRAME_MAX];
+    for (int i = 0; i < 1500; i++) buf[i] = (uint8_t)(i * 7);
+
+    BENCH("net.ip_checksum_1500", 200000, 1500,
+          bench_sink += ip_checksum(buf, 1500));
+    BENCH("net.tcp_checksum_1460", 200000, 1460,
+          bench_sink += tcp_checksum(HOST_PEER_IP, HOST_IP, buf, 1460));
+
+    static const uint8_t mac[6] = {0x52, 0x55, 0x0a, 0x00, 0x02, 0x64};
+    uint32_t n = host_build_arp(frame, 2, HOST_PEER_IP, mac, HOST_IP);
+    BENCH("net.rx_arp_reply", 200000, n, ip_receive(frame, n));
+
+    n = host_build_arp(frame, 1, HOST_PEER_IP, mac, HOST_IP);
+    BENCH("net.rx_arp_request", 100000, n, {
+        ip_receive(frame, n);
+        drain_tx();
+    });
+
+    n = host_build_icmp(frame, HOST_PEER_IP, 0, 64);
+    BENCH("net.rx_icmp_reply", 200000, n, ip_receive(frame, n));
+
+    uint8_t dns[512];
+    uint32_t dns_len = host_build_dns_reply(dns, 0xCAFE, "www.example.test",
+                                            IP_ADDR(198, 18, 0, 1));
+    n = host_build_udp(frame, HOST_DNS, HOST_IP, 53, 52000, dns, dns_len);
+    BENCH("net.rx_dns_reply", 200000, n, ip_receive(frame, n));
+
+    /* Resolver round trip through the mock peer; unique names defeat the
+     * single-entry cache */
+    host_net_set_peer(true);
+    char name[32];
+    BENCH("net.dns_resolve", 20000, 0, {
+        snprintf(name, sizeof(name), "h%u.bench.test", i);
+        if (dns_resolve(name) == 0) {
+            bench_error("net.dns_resolve", "no answer");
+            break;
+        }
+        drain_tx();
+    });
+
+    /* Established connection: data segment in, ACK out, read it back */
+    if (bench_enabled("net.tcp_rx_1k")) {
+        host_net_reset();
+        host_net_set_peer(true);
+        if (tcp_connect(HOST_PEER_IP, 80) != 0) {
+            bench_error("net.tcp_rx_1k", "connect failed");
+        } else {
+            const host_tcp_peer_t *peer = host_net_tcp_peer();
+            uint8_t payload[1024], out[1024];
+            memset(payload, 'x', sizeof(payload));
+            BENCH("net.tcp_rx_1k", 100000, 1024, {
+                uint32_t fn = host_build_tcp(frame, HOST_PEER_IP, HOST_IP,
+                                             peer->remote_port, peer->local_port,
+                                             peer->peer_seq, peer->kernel_seq,
+                                             TCP_FLAG_ACK | TCP_FLAG_PSH,
+                                             payload, sizeof(payload));
+                host_net_tcp_advance(sizeof(payload));
+                host_net_rx_push(frame, fn);
+                if (tcp_receive(0, out, sizeof(out)) != (int)sizeof(out)) {
+                    bench_error("net.tcp_rx_1k", "short read");
+                    break;
+                }
+                drain_tx();
+            });
+            tcp_close(0);
+        }
+    }
+    host_net_set_peer(false);
+    host_net_reset();
+}
+
+/* Filesystem commands against the file-backed disk */
+
+static void bench_fs(void) {
+    char cmd[64];
+
+    BENCH("fs.touch_del", 2000, 0, {
+        cmd_dispatch("TOUCH bench.tmp");
+        cmd_dispatch("DEL bench.tmp");
+    });
+
+    /* NANO fed from the key queue; ESC saves */
+    static char text[1025];
+    for (int i = 0; i < 1024; i++) text[i] = (char)('a' + i % 26);
+    text[1024] = '\0';
+    BENCH("fs.nano_save_1k", 1000, 1024, {
+        host_keys_clear();
+        host_keys_push(text);
+        cmd_dispatch("NANO bench.txt");
+    });
+
+    BENCH("fs.copy_del_1k", 1000, 1024, {
+        cmd_dispatch("COPY C:\\bench.txt C:\\bench2.txt");
+        cmd_dispatch("DEL bench2.txt");
+    });
+
+    BENCH("fs.type_1k", 20000, 1024, cmd_dispatch("TYPE bench.txt"));
+
+    for (int i = 0; i < 48; i++) {
+        snprintf(cmd, sizeof(cmd), "TOUCH f%02d.dat", i);
+        cmd_dispatch(cmd);
+    }
+    BENCH("fs.dir_50", 20000, 0, cmd_dispatch("DIR"));
+    BENCH("fs.load", 200, 0, cmd_init_silent());
+}
+
+/* utils.c string and memory library */
+
+static void bench_utils(void) {
+    static uint8_t src[4096], dst[4096 + 64];
+    static char s1[257], s2[257];
+    memset(s1, 'q', 256);
+    memset(s2, 'q', 256);
+    s1[256] = s2[256] = '\0';
+    char num[16], line[48];
+
+    BENCH("util.memcpy_4k", 200000, 4096, memcpy(dst, src, 4096));
+    BENCH("util.memset_4k", 200000, 4096, memset(dst, (int)i, 4096));
+    BENCH("util.memmove_4k_overlap", 200000, 4096, memmove(dst + 1, dst, 4096));
+    BENCH("util.memcmp_4k", 200000, 4096, bench_sink += memcmp(dst, dst + 64, 4096));
+    BENCH("util.strlen_256", 1000000, 256, bench_sink += strlen(s1));
+    BENCH("util.strcmp_256", 1000000, 256, bench_sink += strcmp(s1, s2));
+    BENCH("util.itoa", 1000000, 0, bench_sink += (uint32_t)itoa((int32_t)i, num, 10)[0]);
+    BENCH("util.crc32c_4k", 200000, 4096, bench_sink += crc32c(0, src, 4096));
+    BENCH("util.ksnprintf", 1000000, 0,
+          bench_sink += (uint32_t)ksnprintf(line, sizeof(line), "%ip %-8u %08X",
+                                            (uint32_t)i, (uint32_t)i, (uint32_t)i));
+}
+
+/* Scrollback ring */
+
+static void bench_scrollback(void) {
+    for (int i = 0; i < 80 * 25; i++) host_vga[i] = (uint16_t)(0x0700 | ('A' + i % 26));
+    /* As shell_main does at boot */
+    scrollback_grow();
+
+    BENCH("scroll.capture_line", 1000000, 160, scrollback_capture_line());
+    BENCH("scroll.page_up_down", 20000, 0, {
+        scrollback_scroll_up();
+        scrollback_scroll_down();
+    });
+    scrollback_reset();
+}
+
+int main(int argc, char **argv) {
+    const char *disk = "build/host/bench_disk.img";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            disk = argv[++i];
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            bench_filter = argv[++i];
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            bench_scale = (uint32_t)strtoul(argv[++i], NULL, 0);
+            if (!bench_scale) bench_scale = 1;
+        } else if (!strcmp(argv[i], "-v")) {
+            host_console_echo(true);
+        } else {
+            fprintf(stderr, "usage: %s [-d disk.img] [-f substring] [-s scale] [-v]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (host_disk_open(disk, BENCH_DISK_SECTORS) != 0) {
+        fprintf(stderr, "host_bench: cannot create %s\n", disk);
+        return 1;
+    }
+    cpu_init();
+    host_net_init();
+    cmd_init_silent();
+
+    printf("BENCH-BEGIN host clock=ns\n");
+    bench_net();
+    bench_fs();
+    bench_utils();
+    bench_scrollback();
+    printf("BENCH-END count=%d\n", bench_count);
+
+    host_disk_close();
+    return 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * RO-DOS Host Build Environment
+ * Force-included (-include) into every kernel source compiled for the host
+ * harness. Redirects the few hard-coded hardware addresses to host memory.
+ */
+
+#ifndef _RODOS_HOST_ENV_H
+#define _RODOS_HOST_ENV_H
+
+#include <stdint.h>
+
+/* 80x25 text screen that stands in for VGA memory at 0xB8000 */
+extern volatile uint16_t host_vga[80 * 25];
+#define VGA_MEMORY host_vga
+
+#endif /* _RODOS_HOST_ENV_H */
@@ -0,0 +1,804 @@
+/*
+ * RO-DOS Host Fuzzer
+ * Seeded random stress runs over the host build (make host-fuzz), meant to
+ * be run under AddressSanitizer/UBSan:
+ *
+ *   net     valid ARP/ICMP/DNS/DHCP/TCP frames plus mutations and random
+ *           bytes into ip_receive(), each in an exact-size heap buffer;
+ *           every frame the stack transmits must carry a valid IP header.
+ *           Resolver calls with random host names go through the mock peer.
+ *   fs      random filesystem command sequences (NANO fed from the key
+ *           queue); DIR and every file's contents must survive a reload
+ *           from the disk image.
+ *   scroll  random scrollback captures and paging; returning to the live
+ *           view must restore the screen exactly.
+ *   mem     memcpy, memmove (both directions, overlapping), memset,
+ *           memcmp, memchr and the cpu_ops kernels (mem_*_rep, simd_*,
+ *           mem_csum16) over random lengths and alignments, against byte
+ *           loops.
+ *   str     strlen, strchr, strcmp and memchr on strings that end at a
+ *           page boundary with an unmapped page behind it, and ksnprintf
+ *           against libc's snprintf.
+ *
+ * Usage: host_fuzz [-d disk.img] [-s seed] [-n iterations]
+ *                  [-t net|fs|scroll|mem|str|all]
+ * A failure prints the seed and iteration; rerun with -s to reproduce.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "host.h"
+
+#define FUZZ_DISK_SECTORS 8192
+
+static uint64_t rng_state;
+static uint64_t fuzz_seed;
+static uint32_t fuzz_iter;
+static const char *fuzz_target = "";
+
+static uint32_t rnd(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static uint32_t rnd_below(uint32_t n) { return n ? rnd() % n : 0; }
+static bool chance(uint32_t percent) { return rnd_below(100) < percent; }
+
+static void fuzz_fail(const char *what) {
+    fprintf(stderr, "FUZZ-FAIL %s seed=%llu iter=%u: %s\n", fuzz_target,
+            (unsigned long long)fuzz_seed, fuzz_iter, what);
+    exit(1);
+}
+
+static void rnd_bytes(uint8_t *p, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) p[i] = (uint8_t)rnd();
+}
+
+/* Lower-case label characters, occasionally junk */
+static void rnd_hostname(char *out, uint32_t max_len) {
+    uint32_t len = 1 + rnd_below(chance(10) ? max_len - 1 : 40);
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t r = rnd_below(40);
+        out[i] = r < 26 ? (char)('a' + r) : r < 36 ? (char)('0' + r - 26) :
+                 r < 39 ? '.' : (char)(1 + rnd_below(255));
+    }
+    out[len] = '\0';
+}
+
+/* Network */
+
+static uint8_t tx_frame[HOST_FRAME_MAX];
+
+/* Everything the stack sends must be a well-formed frame */
+static void check_tx(void) {
+    int len;
+    while ((len = host_net_tx_pop(tx_frame, sizeof(tx_frame))) > 0) {
+        if ((uint32_t)len < sizeof(eth_header_t)) fuzz_fail("runt TX frame");
+        uint16_t type = (uint16_t)(tx_frame[12] << 8 | tx_frame[13]);
+        if (type != ETH_TYPE_IP) continue;
+
+        const uint8_t *ip = tx_frame + sizeof(eth_header_t);
+        if ((uint32_t)len < sizeof(eth_header_t) + sizeof(ip_header_t))
+            fuzz_fail("TX IP frame shorter than its header");
+        if (ip[0] != 0x45) fuzz_fail("TX IP version/IHL");
+        uint32_t total = (uint32_t)(ip[2] << 8 | ip[3]);
+        if (total != (uint32_t)len - sizeof(eth_header_t))
+            fuzz_fail("TX IP total_length does not match frame length");
+        if (ip_checksum(ip, sizeof(ip_header_t)) != 0)
+            fuzz_fail("TX IP header checksum");
+    }
+}
+
+static uint32_t build_dns(uint8_t *frame) {
+    uint8_t dns[1024];
+    char name[256];
+    rnd_hostname(name, 200);
+    uint32_t n = host_build_dns_reply(dns, (uint16_t)rnd(), name, rnd());
+    if (chance(30)) {
+        /* Random question/answer counts */
+        dns[4] = (uint8_t)rnd_below(3); dns[5] = (uint8_t)rnd();
+        dns[6] = (uint8_t)rnd_below(3); dns[7] = (uint8_t)rnd();
+    }
+    if (chance(20)) {
+        /* Stack extra random records on the end */
+        uint32_t extra = rnd_below(300);
+        rnd_bytes(dns + n, extra);
+        n += extra;
+    }
+    return host_build_udp(frame, HOST_DNS, HOST_IP, 53, (uint16_t)rnd(), dns, n);
+}
+
+static uint32_t build_dhcp(uint8_t *frame) {
+    uint8_t dhcp[600];
+    uint32_t n = host_build_dhcp_reply(dhcp, chance(50) ? 2 : 5,
+                                       IP_ADDR(10, 0, 2, 15));
+    if (chance(50)) {
+        /* Scramble the options area */
+        uint32_t at = 240 + rnd_below(n - 240);
+        rnd_bytes(dhcp + at, n - at);
+    }
+    if (chance(30)) n = 236 + rnd_below(n - 236 + 1);
+    return host_build_udp(frame, HOST_GW, IP_ADDR(255, 255, 255, 255), 67, 68,
+                          dhcp, n);
+}
+
+static uint32_t build_tcp(uint8_t *frame) {
+    const host_tcp_peer_t *peer = host_net_tcp_peer();
+    uint8_t payload[1400];
+    uint32_t len = chance(30) ? 0 : rnd_below(sizeof(payload));
+    rnd_bytes(payload, len);
+    uint8_t flags = chance(70) ? TCP_FLAG_ACK | (chance(20) ? TCP_FLAG_FIN : 0)
+                               : (uint8_t)rnd();
+    uint32_t n = host_build_tcp(frame, HOST_PEER_IP, HOST_IP, peer->remote_port,
+                                peer->local_port, peer->peer_seq,
+                                peer->kernel_seq, flags, payload, len);
+    host_net_tcp_advance(len);
+    if (chance(20)) {
+        /* Data offset anywhere from 0 to 60 bytes */
+        frame[sizeof(eth_header_t) + sizeof(ip_header_t) + 12] =
+            (uint8_t)(rnd_below(16) << 4);
+    }
+    return n;
+}
+
+static uint32_t build_frame(uint8_t *frame) {
+    static const uint8_t mac[6] = {0x52, 0x55, 0x0a, 0x00, 0x02, 0x64};
+    uint32_t n;
+
+    switch (rnd_below(8)) {
+    case 0:
+        n = host_build_arp(frame, (uint16_t)(1 + rnd_below(2)), rnd(), mac,
+                           chance(50) ? HOST_IP : rnd());
+        break;
+    case 1:
+        n = host_build_icmp(frame, HOST_PEER_IP, (uint8_t)rnd_below(9),
+                            8 + rnd_below(1000));
+        break;
+    case 2:
+        n = build_dns(frame);
+        break;
+    case 3:
+        n = build_dhcp(frame);
+        break;
+    case 4:
+    case 5:
+        n = build_tcp(frame);
+        break;
+    case 6: {
+        uint8_t payload[1400];
+        uint32_t len = rnd_below(sizeof(payload));
+        rnd_bytes(payload, len);
+        n = host_build_udp(frame, rnd(), HOST_IP, (uint16_t)rnd(),
+                           (uint16_t)rnd(), payload, len);
+        break;
+    }
+    default:
+        n = sizeof(eth_header_t) + rnd_below(HOST_FRAME_MAX - sizeof(eth_header_t));
+        rnd_bytes(frame, n);
+        frame[12] = 0x08;
+        frame[13] = chance(50) ? 0x00 : 0x06;
+        break;
+    }
+
+    /* Mutations: byte flips, header field damage, truncation */
+    if (chance(30)) {
+        uint32_t flips = 1 + rnd_below(8);
+        while (flips--) frame[rnd_below(n)] ^= (uint8_t)(1u << rnd_below(8));
+    }
+    if (chance(15) && n > 38) {
+        /* UDP length field / TCP sequence number */
+        frame[38 + rnd_below(2)] = (uint8_t)rnd();
+    }
+    if (chance(15)) n = rnd_below(n + 1);
+    return n;
+}
+
+static void fuzz_net(uint32_t iterations) {
+    static uint8_t frame[HOST_FRAME_MAX];
+    char name[256];
+
+    fuzz_target = "net";
+    host_net_reset();
+
+    for (fuzz_iter = 0; fuzz_iter < iterations; fuzz_iter++) {
+        if (fuzz_iter % 256 == 0) {
+            /* Fresh interface config; sometimes bring up a connection so
+             * segments reach the ESTABLISHED path */
+            host_net_reset();
+            host_net_set_peer(true);
+            if (chance(50) && tcp_connect(HOST_PEER_IP, 80) != 0)
+                fuzz_fail("tcp_connect through the mock peer failed");
+            host_net_set_peer(false);
+            check_tx();
+        }
+
+        if (chance(1)) {
+            host_net_set_peer(true);
+            rnd_hostname(name, sizeof(name) - 1);
+            dns_resolve(name);
+            host_net_set_peer(false);
+            /* Drop replies the resolver did not consume */
+            while (netif_receive(netif_get_default(), tx_frame, sizeof(tx_frame)) > 0)
+                ;
+            check_tx();
+            continue;
+        }
+
+        uint32_t n = build_frame(frame);
+        uint8_t *buf = malloc(n ? n : 1);
+        memcpy(buf, frame, n);
+        ip_receive(buf, n);
+        free(buf);
+        check_tx();
+    }
+    host_net_reset();
+    printf("FUZZ net iterations=%u OK\n", iterations);
+}
+
+/* Filesystem */
+
+extern int fs_count;    /* commands.c */
+
+static const char *fs_names[] = {
+    "a.txt", "b.txt", "c.txt", "notes", "readme.md", "x", "data.bin",
+    "long_file_name_for_testing.txt", "docs", "tmp", "A.TXT",
+};
+#define FS_NAMES (sizeof(fs_names) / sizeof(fs_names[0]))
+
+static const char *fs_dirs[] = {"docs", "tmp", "src"};
+#define FS_DIRS (sizeof(fs_dirs) / sizeof(fs_dirs[0]))
+
+static const char *rnd_name(char *junk, uint32_t size) {
+    if (chance(5)) {
+        uint32_t len = 1 + rnd_below(size - 1);
+        for (uint32_t i = 0; i < len; i++) junk[i] = (char)(33 + rnd_below(94));
+        junk[len] = '\0';
+        return junk;
+    }
+    return fs_names[rnd_below(FS_NAMES)];
+}
+
+static void fs_nano_keys(void) {
+    host_keys_clear();
+    uint32_t len = chance(10) ? 4200 : rnd_below(600);
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t r = rnd_below(100);
+        uint16_t key = r < 85 ? (uint16_t)(32 + rnd_below(95)) :
+                       r < 92 ? 13 : r < 97 ? 8 : r < 98 ? 11 :
+                       (uint16_t)rnd();
+        if (key == 27 || (key == 3 && !chance(20))) key = 'z';
+        host_keys_push_key(key);
+    }
+}
+
+/* DIR plus the contents of every candidate file, as printed */
+static char fs_snap_before[1 << 20], fs_snap_after[1 << 20];
+
+static void fs_snapshot(char *out) {
+    char cmd[96];
+    host_console_capture(out, sizeof(fs_snap_before));
+    cmd_dispatch("DIR");
+    for (uint32_t i = 0; i < FS_NAMES; i++) {
+        snprintf(cmd, sizeof(cmd), "TYPE %s", fs_names[i]);
+        cmd_dispatch(cmd);
+    }
+    host_console_capture(NULL, 0);
+}
+
+static void fuzz_fs(uint32_t iterations) {
+    char cmd[256], junk[96], junk2[96];
+
+    fuzz_target = "fs";
+    cmd_dispatch("CD \\");
+
+    for (fuzz_iter = 0; fuzz_iter < iterations; fuzz_iter++) {
+        if (fs_count >= 64) {
+            /* Past 64 entries files outnumber the content slots and which
+             * ones keep their data after a reload is arbitrary */
+            host_keys_push("Y");
+            cmd_dispatch("FORMAT");
+            cmd_dispatch("CD \\");
+        }
+
+        const char *a = rnd_name(junk, sizeof(junk) - 1);
+        const char *b = rnd_name(junk2, sizeof(junk2) - 1);
+        const char *d = fs_dirs[rnd_below(FS_DIRS)];
+
+        switch (rnd_below(16)) {
+        case 0: case 1:
+            snprintf(cmd, sizeof(cmd), "TOUCH %s", a);
+            break;
+        case 2: case 3: case 4:
+            fs_nano_keys();
+            snprintf(cmd, sizeof(cmd), "NANO %s", a);
+            break;
+        case 5: case 6:
+            snprintf(cmd, sizeof(cmd), "DEL %s", a);
+            break;
+        case 7:
+            snprintf(cmd, sizeof(cmd), chance(50) ? "COPY %s %s" : "COPY C:\\%s C:\\%s", a, b);
+            break;
+        case 8:
+            snprintf(cmd, sizeof(cmd), "REN %s %s", a, b);
+            break;
+        case 9:
+            snprintf(cmd, sizeof(cmd), "MKDIR %s", d);
+            break;
+        case 10:
+            snprintf(cmd, sizeof(cmd), "RMDIR %s", d);
+            break;
+        case 11:
+            if (chance(50)) snprintf(cmd, sizeof(cmd), "CD %s", d);
+            else snprintf(cmd, sizeof(cmd), chance(50) ? "CD .." : "CD \\");
+            break;
+        case 12:
+            snprintf(cmd, sizeof(cmd), "TYPE %s", a);
+            break;
+        case 13: {
+            static const char *readers[] = {"WC", "HEAD", "TAIL", "STAT", "FILE", "HASH"};
+            snprintf(cmd, sizeof(cmd), "%s %s", readers[rnd_below(6)], a);
+            break;
+        }
+        case 14:
+            snprintf(cmd, sizeof(cmd), chance(50) ? "GREP a %s" : "FIND %s", a);
+            break;
+        default:
+            snprintf(cmd, sizeof(cmd), chance(50) ? "DIR" : "TREE");
+            break;
+        }
+        cmd_dispatch(cmd);
+        host_keys_clear();
+
+        if (fuzz_iter % 32 == 31) {
+            /* Everything visible must round-trip through the disk */
+            fs_snapshot(fs_snap_before);
+            cmd_init_silent();
+            fs_snapshot(fs_snap_after);
+            if (strcmp(fs_snap_before, fs_snap_after) != 0) {
+                fprintf(stderr, "--- before reload ---\n%s\n--- after reload ---\n%s\n",
+                        fs_snap_before, fs_snap_after);
+                fuzz_fail("filesystem changed across reload from disk");
+            }
+        }
+    }
+    printf("FUZZ fs iterations=%u OK\n", iterations);
+}
+
+/* Scrollback */
+
+static void fuzz_scroll(uint32_t iterations) {
+    static uint16_t live[80 * 25];
+    bool have_live = false;
+
+    fuzz_target = "scroll";
+    scrollback_reset();
+
+    for (fuzz_iter = 0; fuzz_iter < iterations; fuzz_iter++) {
+        bool scrolled = scrollback_is_active();
+
+        switch (rnd_below(6)) {
+        case 0:
+            if (!scrolled) {
+                /* New output on the live screen */
+                for (int i = 0; i < 80; i++)
+                    host_vga[rnd_below(80 * 25)] = (uint16_t)rnd();
+            }
+            break;
+        case 1: {
+            uint32_t lines = 1 + rnd_below(scrolled ? 3 : 40);
+            while (lines--) scrollback_capture_line();
+            break;
+        }
+        case 2: {
+            char line[80];
+            uint8_t attrs[80];
+            rnd_bytes((uint8_t *)line, sizeof(line));
+            rnd_bytes(attrs, sizeof(attrs));
+            scrollback_save_line(chance(10) ? NULL : line,
+                                 chance(10) ? NULL : attrs, (uint16_t)rnd());
+            break;
+        }
+        case 3:
+            if (!scrolled) {
+                for (int i = 0; i < 80 * 25; i++) live[i] = host_vga[i];
+                have_live = true;
+            }
+            scrollback_scroll_up();
+            break;
+        case 4:
+            scrollback_scroll_down();
+            break;
+        default:
+            /* shell_main backs the ring; captures before that are
+             * dropped */
+            if (chance(3)) scrollback_grow();
+            if (chance(20)) scrollback_reset();
+            break;
+        }
+
+        int32_t off = scrollback_get_offset();
+        if (off < 0 || off > 500) fuzz_fail("scroll offset out of range");
+        if ((off > 0) != scrollback_is_active()) fuzz_fail("active flag disagrees with offset");
+
+        if (scrolled && off == 0 && have_live) {
+            for (int i = 0; i < 80 * 25; i++) {
+                if (host_vga[i] != live[i]) fuzz_fail("live screen not restored");
+            }
+        }
+    }
+    scrollback_reset();
+    printf("FUZZ scroll iterations=%u OK\n", iterations);
+}
+
+/* Memory and string primitives */
+
+/* utils.c, simd.c and kprintf.c replace libc's versions in this program,
+ * so the references are byte loops; volatile keeps the compiler from
+ * turning them back into calls to the code under test. */
+extern void mem_fill_rep(void *dest, uint32_t pattern, size_t n);
+extern void mem_copy_rep(void *dest, const void *src, size_t n);
+extern uint16_t mem_csum16(const void *data, size_t len);
+extern void simd_copy(void *dest, const void *src, size_t n, bool nt);
+extern void simd_fill(void *dest, uint32_t pattern, size_t n, bool nt);
+extern uint16_t simd_csum16(const void *data, size_t len);
+extern int ksnprintf(char *buf, size_t size, const char *fmt, ...);
+
+#define MEM_FUZZ_LONG   (256 * 1024 + 4096)    /* past SIMD_NT_BYTES */
+#define MEM_FUZZ_BUF    (2 * MEM_FUZZ_LONG + 64)
+
+static uint8_t mem_buf[MEM_FUZZ_BUF];
+static uint8_t mem_ref[MEM_FUZZ_BUF];
+static uint8_t mem_src[MEM_FUZZ_BUF];
+
+static void ref_move(void *dest, const void *src, size_t n) {
+    volatile uint8_t *d = dest;
+    const volatile uint8_t *s = src;
+    if (d <= s) {
+        for (size_t i = 0; i < n; i++) d[i] = s[i];
+    } else {
+        for (size_t i = n; i-- > 0;) d[i] = s[i];
+    }
+}
+
+static void ref_fill(void *dest, uint32_t pattern, size_t n) {
+    volatile uint8_t *d = dest;
+    for (size_t i = 0; i < n; i++) d[i] = (uint8_t)(pattern >> ((i & 3) * 8));
+}
+
+static int ref_cmp(const void *a, const void *b, size_t n) {
+    const volatile uint8_t *x = a, *y = b;
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] != y[i]) return x[i] - y[i];
+    }
+    return 0;
+}
+
+static const void *ref_chr(const void *p, int value, size_t n) {
+    const volatile uint8_t *s = p;
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == (uint8_t)value) return (const void *)&s[i];
+    }
+    return NULL;
+}
+
+static uint16_t ref_csum16(const void *data, size_t len) {
+    const volatile uint8_t *p = data;
+    uint64_t sum = 0;
+    size_t i = 0;
+    for (; i + 1 < len; i += 2) sum += (uint32_t)(p[i] | p[i + 1] << 8);
+    if (i < len) sum += p[i];
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+static size_t ref_strlen(const char *s) {
+    const volatile char *p = s;
+    size_t n = 0;
+    while (p[n]) n++;
+    return n;
+}
+
+static const char *ref_strchr(const char *s, int c) {
+    const volatile char *p = s;
+    for (;; p++) {
+        if (*p == (char)c) return (const char *)p;
+        if (!*p) return NULL;
+    }
+}
+
+static int ref_strcmp(const char *a, const char *b) {
+    const volatile unsigned char *x = (const unsigned char *)a;
+    const volatile unsigned char *y = (const unsigned char *)b;
+    while (*x && *x == *y) x++, y++;
+    return *x - *y;
+}
+
+static int sign(int v) { return (v > 0) - (v < 0); }
+
+/* Mostly short, often around the dword and cpu_ops thresholds, now and
+ * then past the non-temporal threshold */
+static size_t mem_len(void) {
+    switch (rnd_below(8)) {
+    case 0: case 1: case 2: return rnd_below(40);
+    case 3: return 240 + rnd_below(32);
+    case 4: case 5: return rnd_below(4096);
+    case 6: return rnd_below(32768);
+    default: return chance(3) ? MEM_FUZZ_LONG - rnd_below(8192) : rnd_below(1024);
+    }
+}
+
+/* The written range plus 64 bytes either side must match the reference */
+static void mem_check(const char *what, size_t at, size_t n) {
+    size_t lo = at > 64 ? at - 64 : 0;
+    size_t hi = at + n + 64 < MEM_FUZZ_BUF ? at + n + 64 : MEM_FUZZ_BUF;
+    for (size_t i = lo; i < hi; i++) {
+        if (mem_buf[i] != mem_ref[i]) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "%s n=%zu differs at byte %zu", what, n, i);
+            fuzz_fail(msg);
+        }
+    }
+}
+
+static void fuzz_mem(uint32_t iterations) {
+    fuzz_target = "mem";
+    rnd_bytes(mem_buf, MEM_FUZZ_BUF);
+    ref_move(mem_ref, mem_buf, MEM_FUZZ_BUF);
+    rnd_bytes(mem_src, MEM_FUZZ_BUF);
+
+    for (fuzz_iter = 0; fuzz_iter < iterations; fuzz_iter++) {
+        size_t n = mem_len();
+        size_t at = rnd_below(MEM_FUZZ_BUF - n + 1);
+        size_t from = rnd_below(MEM_FUZZ_BUF - n + 1);
+        uint32_t pattern = rnd();
+        bool nt = chance(50);
+
+        switch (rnd_below(10)) {
+        case 0:
+            memcpy(mem_buf + at, mem_src + from, n);
+            ref_move(mem_ref + at, mem_src + from, n);
+            mem_check("memcpy", at, n);
+            break;
+        case 1: {
+            /* Overlapping moves both ways, usually only a few bytes apart */
+            if (chance(70)) {
+                size_t shift = rnd_below(70);
+                from = chance(50) ? (at >= shift ? at - shift : 0)
+                                  : (at + shift <= MEM_FUZZ_BUF - n ? at + shift : at);
+            }
+            memmove(mem_buf + at, mem_buf + from, n);
+            ref_move(mem_ref + at, mem_ref + from, n);
+            mem_check(from < at ? "memmove backward" : "memmove forward", at, n);
+            break;
+        }
+        case 2: {
+            int value = chance(20) ? (int)rnd() : (int)rnd_below(256);
+            memset(mem_buf + at, value, n);
+            ref_fill(mem_ref + at, (uint8_t)value * 0x01010101u, n);
+            mem_check("memset", at, n);
+            break;
+        }
+        case 3:
+            mem_fill_rep(mem_buf + at, pattern, n);
+            ref_fill(mem_ref + at, pattern, n);
+            mem_check("mem_fill_rep", at, n);
+            break;
+        case 4:
+            simd_fill(mem_buf + at, pattern, n, nt);
+            ref_fill(mem_ref + at, pattern, n);
+            mem_check(nt ? "simd_fill nt" : "simd_fill", at, n);
+            break;
+        case 5:
+            if (chance(50)) {
+                simd_copy(mem_buf + at, mem_src + from, n, nt);
+                ref_move(mem_ref + at, mem_src + from, n);
+                mem_check(nt ? "simd_copy nt" : "simd_copy", at, n);
+            } else {
+                mem_copy_rep(mem_buf + at, mem_src + from, n);
+                ref_move(mem_ref + at, mem_src + from, n);
+                mem_check("mem_copy_rep", at, n);
+            }
+            break;
+        case 6: {
+            uint16_t want = ref_csum16(mem_src + from, n);
+            if (mem_csum16(mem_src + from, n) != want) fuzz_fail("mem_csum16");
+            if (simd_csum16(mem_src + from, n) != want) fuzz_fail("simd_csum16");
+            break;
+        }
+        case 7: {
+            /* Equal runs with at most one difference */
+            ref_move(mem_buf + at, mem_src + from, n);
+            ref_move(mem_ref + at, mem_src + from, n);
+            if (n && chance(70)) mem_buf[at + rnd_below(n)] = (uint8_t)rnd();
+            int got = memcmp(mem_buf + at, mem_src + from, n);
+            if (sign(got) != sign(ref_cmp(mem_buf + at, mem_src + from, n)))
+                fuzz_fail("memcmp");
+            ref_move(mem_ref + at, mem_buf + at, n);
+            break;
+        }
+        default: {
+            int value = chance(50) && n ? mem_src[from + rnd_below(n)] : (int)rnd_below(256);
+            if (chance(10)) value |= 0x100;
+            if (memchr(mem_src + from, value, n) != ref_chr(mem_src + from, value, n))
+                fuzz_fail("memchr");
+            break;
+        }
+        }
+    }
+    printf("FUZZ mem iterations=%u OK\n", iterations);
+}
+
+/* Random strings over a small alphabet, so searches and compares hit */
+static void rnd_string(char *out, size_t len) {
+    static const char alphabet[] = "abcd\x80\xff";
+    for (size_t i = 0; i < len; i++) out[i] = alphabet[rnd_below(sizeof(alphabet) - 1)];
+    out[len] = '\0';
+}
+
+/* One conversion between literal text, through ksnprintf and libc's
+ * snprintf, into a buffer of random size */
+static void fuzz_format(void) {
+    static const char convs[] = "duxXcs%";
+    char fmt[32], want[128], got[128], str[16];
+    char conv = convs[rnd_below(sizeof(convs) - 1)];
+    int fn = 0;
+
+    if (chance(50)) fmt[fn++] = "ab:. "[rnd_below(5)];
+    fmt[fn++] = '%';
+    if (conv != '%') {
+        if (chance(30)) fmt[fn++] = '-';
+        /* libc leaves '0' with %c and %s undefined */
+        if (chance(30) && conv != 'c' && conv != 's') fmt[fn++] = '0';
+        if (chance(50)) fn += snprintf(fmt + fn, 4, "%u", rnd_below(20));
+    }
+    fmt[fn++] = conv;
+    if (chance(50)) fmt[fn++] = "ab:. "[rnd_below(5)];
+    fmt[fn] = '\0';
+
+    uint32_t v = chance(30) ? rnd_below(10) : rnd();
+    size_t size = chance(20) ? rnd_below(24) : sizeof(got);
+    int wn, gn;
+    ref_fill(got, 0x5A5A5A5A, sizeof(got));
+    switch (conv) {
+    case 's':
+        rnd_string(str, rnd_below(sizeof(str)));
+        wn = snprintf(want, sizeof(want), fmt, str);
+        gn = ksnprintf(got, size, fmt, str);
+        break;
+    case 'c':
+        v = 1 + rnd_below(255);
+        /* fall through */
+    case 'd':
+        wn = snprintf(want, sizeof(want), fmt, (int32_t)v);
+        gn = ksnprintf(got, size, fmt, (int32_t)v);
+        break;
+    default:
+        wn = snprintf(want, sizeof(want), fmt, v);
+        gn = ksnprintf(got, size, fmt, v);
+        break;
+    }
+
+    if (gn != wn) fuzz_fail("ksnprintf length");
+    if (size) {
+        size_t keep = (size_t)wn < size - 1 ? (size_t)wn : size - 1;
+        if (ref_cmp(got, want, keep) != 0 || got[keep] != '\0')
+            fuzz_fail("ksnprintf output");
+    }
+    if (size < sizeof(got) && (uint8_t)got[size] != 0x5A)
+        fuzz_fail("ksnprintf wrote past size");
+}
+
+/* %ip and %mac have no libc counterpart */
+static void fuzz_format_net(void) {
+    char want[64], got[64];
+    uint8_t mac[6];
+    uint32_t ip = rnd();
+    rnd_bytes(mac, sizeof(mac));
+    snprintf(want, sizeof(want), "%u.%u.%u.%u %02x:%02x:%02x:%02x:%02x:%02x",
+             ip >> 24, ip >> 16 & 0xFF, ip >> 8 & 0xFF, ip & 0xFF,
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    ksnprintf(got, sizeof(got), "%ip %mac", ip, mac);
+    if (ref_strcmp(got, want) != 0) fuzz_fail("ksnprintf %ip/%mac");
+}
+
+/* Strings end at the last bytes of a page followed by an unmapped one, so
+ * a word-at-a-time scan that reads past the page faults */
+static void fuzz_str(uint32_t iterations) {
+    fuzz_target = "str";
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uint8_t *map = mmap(NULL, 4 * page, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) fuzz_fail("mmap");
+    /* [a page][guard][b page][guard] */
+    char *pa = (char *)map, *pb = (char *)map + 2 * page;
+    mprotect(map + page, page, PROT_NONE);
+    mprotect(map + 3 * page, page, PROT_NONE);
+
+    for (fuzz_iter = 0; fuzz_iter < iterations; fuzz_iter++) {
+        size_t la = rnd_below(chance(80) ? 48 : page - 1);
+        /* Usually flush against the guard page, else anywhere */
+        size_t ea = chance(60) ? page - 1 : la + rnd_below(page - la);
+        char *a = pa + ea - la;
+        rnd_string(a, la);
+
+        /* b: a copy of a, maybe cut short, changed or extended */
+        size_t lb = la;
+        char *tmp = (char *)mem_src;
+        ref_move(tmp, a, la);
+        if (la && chance(40)) tmp[rnd_below(la)] = "abcd\x80\xff"[rnd_below(6)];
+        if (chance(20)) lb = rnd_below(la + 1);
+        if (chance(20) && lb + 8 < page) {
+            rnd_string(tmp + lb, rnd_below(8));
+            lb = ref_strlen(tmp + lb) + lb;
+        }
+        tmp[lb] = '\0';
+        size_t eb = chance(60) ? page - 1 : lb + rnd_below(page - lb);
+        char *b = pb + eb - lb;
+        ref_move(b, tmp, lb + 1);
+
+        if (strlen(a) != la) fuzz_fail("strlen");
+        int c = chance(20) ? 0 : chance(10) ? (int)rnd() : (uint8_t)"abcde\x80\xff"[rnd_below(7)];
+        if (strchr(a, c) != ref_strchr(a, c)) fuzz_fail("strchr");
+        if (sign(strcmp(a, b)) != sign(ref_strcmp(a, b))) fuzz_fail("strcmp");
+        if (sign(strcmp(b, a)) != sign(ref_strcmp(b, a))) fuzz_fail("strcmp (swapped)");
+        size_t n = rnd_below(la + 2);
+        if (memchr(a, c, n) != ref_chr(a, c, n)) fuzz_fail("memchr");
+
+        fuzz_format();
+        if (chance(10)) fuzz_format_net();
+    }
+    munmap(map, 4 * page);
+    printf("FUZZ str iterations=%u OK\n", iterations);
+}
+
+int main(int argc, char **argv) {
+    const char *disk = "build/host/fuzz_disk.img";
+    const char *target = "all";
+    uint32_t iterations = 100000;
+
+    fuzz_seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            disk = argv[++i];
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            fuzz_seed = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            target = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-d disk.img] [-s seed] [-n iterations] "
+                    "[-t net|fs|scroll|mem|str|all]\n", argv[0]);
+            return 2;
+        }
+    }
+    rng_state = fuzz_seed * 0x9E3779B97F4A7C15ull + 1;
+
+    if (host_disk_open(disk, FUZZ_DISK_SECTORS) != 0) {
+        fprintf(stderr, "host_fuzz: cannot create %s\n", disk);
+        return 1;
+    }
+    cpu_init();
+    host_net_init();
+    cmd_init_silent();
+
+    printf("FUZZ-BEGIN seed=%llu\n", (unsigned long long)fuzz_seed);
+    bool all = !strcmp(target, "all");
+    if (all || !strcmp(target, "net")) fuzz_net(iterations);
+    if (all || !strcmp(target, "fs")) fuzz_fs(iterations / 10);
+    if (all || !strcmp(target, "scroll")) fuzz_scroll(iterations);
+    if (all || !strcmp(target, "mem")) fuzz_mem(iterations);
+    if (all || !strcmp(target, "str")) fuzz_str(iterations);
+    printf("FUZZ-END\n");
+
+    host_disk_close();
+    return 0;
+}
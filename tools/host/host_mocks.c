@@ -0,0 +1,623 @@
+/*
+ * RO-DOS Host Mocks
+ * Stand-ins for the assembly runtime, drivers and hardware that the kernel
+ * sources in the host build link against (see host.h).
+ *
+ * This file must not include <stdio.h>: it defines the kernel's putc and
+ * puts, whose signatures differ from the C library's.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "host.h"
+#include "../../include/pmm.h"
+#include "../../include/irqpool.h"
+#include "../../include/fpu.h"
+
+volatile uint16_t host_vga[80 * 25];
+
+/* Time */
+
+static uint64_t host_start_ns = 0;
+
+uint64_t host_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t host_uptime_ns(void) {
+    if (!host_start_ns) host_start_ns = host_now_ns();
+    return host_now_ns() - host_start_ns;
+}
+
+/* No TSC calibration on the host: callers take their PIT-tick fallbacks
+ * and trace timestamps decode as zero. */
+uint64_t clock_tsc(void) { return 0; }
+uint32_t clock_tsc_khz(void) { return 0; }
+uint64_t clock_tsc_base(void) { return 0; }
+uint64_t clock_ns(void) { return host_uptime_ns(); }
+uint64_t clock_us(void) { return host_uptime_ns() / 1000; }
+uint32_t clock_ms(void) { return (uint32_t)(host_uptime_ns() / 1000000); }
+uint64_t clock_cycles_to_us(uint64_t cycles) { return cycles / 1000; }
+
+uint64_t clock_div64(uint64_t n, uint32_t d, uint32_t *rem) {
+    if (rem) *rem = (uint32_t)(n % d);
+    return n / d;
+}
+
+uint32_t get_ticks(void) {
+    return (uint32_t)(host_uptime_ns() * 182 / 10000000000ull);
+}
+
+/* Every x86-64 host has SSE2 enabled, so cpu_init picks the simd.c
+ * kernels here too */
+bool fpu_fxsr = true;
+bool fpu_sse2 = true;
+void fpu_init(void) {}
+
+/* Console */
+
+static bool console_echo = false;
+static uint64_t console_bytes = 0;
+static char *capture_buf = NULL;
+static uint32_t capture_size = 0, capture_len = 0;
+
+void host_console_echo(bool on) { console_echo = on; }
+uint64_t host_console_bytes(void) { return console_bytes; }
+
+void host_console_capture(char *buf, uint32_t size) {
+    capture_buf = size ? buf : NULL;
+    capture_size = size;
+    capture_len = 0;
+    if (capture_buf) capture_buf[0] = '\0';
+}
+
+uint32_t host_console_captured(void) { return capture_len; }
+
+void c_putc(char c) {
+    console_bytes++;
+    if (console_echo) (void)!write(1, &c, 1);
+    if (capture_buf && capture_len < capture_size - 1) {
+        capture_buf[capture_len++] = c;
+        capture_buf[capture_len] = '\0';
+    }
+}
+
+void c_puts(const char *s) {
+    if (capture_buf) {
+        while (*s) c_putc(*s++);
+        return;
+    }
+    size_t n = strlen(s);
+    console_bytes += n;
+    if (console_echo) (void)!write(1, s, n);
+}
+
+void c_write(const char *s, uint32_t len) {
+    if (capture_buf) {
+        for (uint32_t i = 0; i < len; i++) c_putc(s[i]);
+        return;
+    }
+    console_bytes += len;
+    if (console_echo) (void)!write(1, s, len);
+}
+
+void putc(char c) { c_putc(c); }
+void puts(const char *s) { c_puts(s); }
+void c_cls(void) {}
+void set_attr(uint8_t a) { (void)a; }
+
+/* Keyboard */
+
+#define HOST_KEYS 8192
+
+static uint16_t key_queue[HOST_KEYS];
+static uint32_t key_head = 0, key_tail = 0;
+
+void host_keys_push_key(uint16_t key) {
+    if (key_tail - key_head < HOST_KEYS) key_queue[key_tail++ % HOST_KEYS] = key;
+}
+
+void host_keys_push(const char *s) {
+    while (*s) host_keys_push_key((uint8_t)*s++);
+}
+
+void host_keys_clear(void) { key_head = key_tail = 0; }
+
+uint16_t c_getkey_nonblock(void) {
+    return key_head == key_tail ? 0 : key_queue[key_head++ % HOST_KEYS];
+}
+
+/* Blocking reads end interactive commands (NANO saves on ESC) */
+uint16_t c_getkey(void) {
+    return key_head == key_tail ? 27 : key_queue[key_head++ % HOST_KEYS];
+}
+
+/* Disk */
+
+static int disk_fd = -1;
+static uint32_t disk_sectors = 0;
+static uint64_t disk_reads = 0, disk_writes = 0;
+
+int host_disk_open(const char *path, uint32_t sectors) {
+    host_disk_close();
+    disk_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (disk_fd < 0) return -1;
+    if (ftruncate(disk_fd, (off_t)sectors * 512) != 0) {
+        host_disk_close();
+        return -1;
+    }
+    disk_sectors = sectors;
+    disk_reads = disk_writes = 0;
+    return 0;
+}
+
+void host_disk_close(void) {
+    if (disk_fd >= 0) close(disk_fd);
+    disk_fd = -1;
+    disk_sectors = 0;
+}
+
+uint64_t host_disk_reads(void) { return disk_reads; }
+uint64_t host_disk_writes(void) { return disk_writes; }
+
+static bool disk_range_ok(uint32_t lba, uint32_t count) {
+    return disk_fd >= 0 && count > 0 && lba < disk_sectors &&
+           count <= disk_sectors - lba;
+}
+
+int disk_read_lba(uint32_t lba, uint32_t count, void *buffer) {
+    if (!disk_range_ok(lba, count)) return -1;
+    size_t n = (size_t)count * 512;
+    if (pread(disk_fd, buffer, n, (off_t)lba * 512) != (ssize_t)n) return -1;
+    disk_reads += count;
+    return 0;
+}
+
+int disk_write_lba(uint32_t lba, uint32_t count, void *buffer) {
+    if (!disk_range_ok(lba, count)) return -1;
+    size_t n = (size_t)count * 512;
+    if (pwrite(disk_fd, buffer, n, (off_t)lba * 512) != (ssize_t)n) return -1;
+    disk_writes += count;
+    return 0;
+}
+
+/* Allocator shim - malloc with a size header, capped at the kernel's
+ * 16 MB heap so out-of-memory paths still run */
+
+#define HOST_HEAP_SIZE (16u * 1024 * 1024)
+#define HOST_HEAP_HDR  16
+
+static uint32_t heap_used = 0, heap_blocks = 0;
+
+uint32_t host_heap_used(void) { return heap_used; }
+uint32_t host_heap_blocks(void) { return heap_blocks; }
+
+void *kmalloc(uint32_t size) {
+    if (size == 0 || size > HOST_HEAP_SIZE - heap_used) return NULL;
+    uint8_t *p = malloc((size_t)size + HOST_HEAP_HDR);
+    if (!p) return NULL;
+    *(uint32_t *)p = size;
+    heap_used += size;
+    heap_blocks++;
+    return p + HOST_HEAP_HDR;
+}
+
+void kfree(void *ptr) {
+    if (!ptr) return;
+    uint8_t *p = (uint8_t *)ptr - HOST_HEAP_HDR;
+    heap_used -= *(uint32_t *)p;
+    heap_blocks--;
+    free(p);
+}
+
+void *krealloc(void *ptr, uint32_t size) {
+    if (!ptr) return kmalloc(size);
+    if (size == 0) {
+        kfree(ptr);
+        return NULL;
+    }
+    uint32_t old = *(uint32_t *)((uint8_t *)ptr - HOST_HEAP_HDR);
+    void *p = kmalloc(size);
+    if (!p) return NULL;
+    memcpy(p, ptr, old < size ? old : size);
+    kfree(ptr);
+    return p;
+}
+
+void mem_get_stats(uint32_t *stats) {
+    stats[0] = HOST_HEAP_SIZE - heap_used;
+    stats[1] = heap_used;
+    stats[2] = heap_blocks;
+    stats[3] = HOST_HEAP_SIZE - heap_used;
+}
+
+/* The host heap stands in for all of physical memory */
+static const e820_entry_t host_e820 = { PMM_BASE, HOST_HEAP_SIZE, E820_USABLE, 1 };
+
+uint32_t pmm_total_pages(void) { return HOST_HEAP_SIZE / PMM_PAGE_SIZE; }
+uint32_t pmm_free_page_count(void) { return 0; }
+
+const e820_entry_t *pmm_e820(uint32_t *count) {
+    *count = 1;
+    return &host_e820;
+}
+
+/* Network */
+
+#define HOST_QUEUE 256
+
+typedef struct {
+    uint8_t data[HOST_FRAME_MAX];
+    uint32_t len;
+} host_frame_t;
+
+typedef struct {
+    host_frame_t slot[HOST_QUEUE];
+    uint32_t head, tail;
+    uint64_t dropped;
+} host_queue_t;
+
+static host_queue_t rx_queue, tx_queue;
+static bool peer_on = false;
+static host_tcp_peer_t tcp_peer;
+
+static const uint8_t host_mac[6] = {0x52, 0x54, 0x00, 0x12, 0x34, 0x56};
+static const uint8_t peer_mac[6] = {0x52, 0x55, 0x0a, 0x00, 0x02, 0x02};
+
+static int queue_push(host_queue_t *q, const uint8_t *data, uint32_t len) {
+    if (len > HOST_FRAME_MAX || q->tail - q->head >= HOST_QUEUE) {
+        q->dropped++;
+        return -1;
+    }
+    host_frame_t *f = &q->slot[q->tail++ % HOST_QUEUE];
+    memcpy(f->data, data, len);
+    f->len = len;
+    return (int)len;
+}
+
+static int queue_pop(host_queue_t *q, uint8_t *data, uint32_t max_len) {
+    if (q->head == q->tail) return 0;
+    host_frame_t *f = &q->slot[q->head++ % HOST_QUEUE];
+    uint32_t n = f->len < max_len ? f->len : max_len;
+    memcpy(data, f->data, n);
+    return (int)n;
+}
+
+static uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+static void wr16(uint8_t *p, uint16_t v) { p[0] = v >> 8; p[1] = (uint8_t)v; }
+static void wr32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = (uint8_t)v;
+}
+
+static uint32_t build_eth(uint8_t *frame, uint16_t ethertype) {
+    memcpy(frame, host_mac, 6);
+    memcpy(frame + 6, peer_mac, 6);
+    wr16(frame + 12, ethertype);
+    return sizeof(eth_header_t);
+}
+
+static uint32_t build_ip(uint8_t *frame, uint32_t src_ip, uint32_t dst_ip,
+                         uint8_t proto, uint32_t payload_len) {
+    uint8_t *ip = frame + build_eth(frame, ETH_TYPE_IP);
+    memset(ip, 0, sizeof(ip_header_t));
+    ip[0] = 0x45;
+    wr16(ip + 2, (uint16_t)(sizeof(ip_header_t) + payload_len));
+    ip[8] = 64;
+    ip[9] = proto;
+    wr32(ip + 12, src_ip);
+    wr32(ip + 16, dst_ip);
+    uint16_t sum = ip_checksum(ip, sizeof(ip_header_t));
+    memcpy(ip + 10, &sum, 2);
+    return sizeof(eth_header_t) + sizeof(ip_header_t);
+}
+
+uint32_t host_build_udp(uint8_t *frame, uint32_t src_ip, uint32_t dst_ip,
+                        uint16_t sport, uint16_t dport,
+                        const uint8_t *payload, uint32_t len) {
+    uint32_t off = build_ip(frame, src_ip, dst_ip, IP_PROTO_UDP,
+                            sizeof(udp_header_t) + len);
+    uint8_t *udp = frame + off;
+    wr16(udp, sport);
+    wr16(udp + 2, dport);
+    wr16(udp + 4, (uint16_t)(sizeof(udp_header_t) + len));
+    wr16(udp + 6, 0);
+    memcpy(udp + sizeof(udp_header_t), payload, len);
+    return off + sizeof(udp_header_t) + len;
+}
+
+uint32_t host_build_tcp(uint8_t *frame, uint32_t src_ip, uint32_t dst_ip,
+                        uint16_t sport, uint16_t dport, uint32_t seq,
+                        uint32_t ack, uint8_t flags,
+                        const uint8_t *payload, uint32_t len) {
+    uint32_t off = build_ip(frame, src_ip, dst_ip, IP_PROTO_TCP,
+                            sizeof(tcp_header_t) + len);
+    uint8_t *tcp = frame + off;
+    memset(tcp, 0, sizeof(tcp_header_t));
+    wr16(tcp, sport);
+    wr16(tcp + 2, dport);
+    wr32(tcp + 4, seq);
+    wr32(tcp + 8, ack);
+    tcp[12] = (sizeof(tcp_header_t) / 4) << 4;
+    tcp[13] = flags;
+    wr16(tcp + 14, 8192);
+    if (len) memcpy(tcp + sizeof(tcp_header_t), payload, len);
+    uint16_t sum = tcp_checksum(src_ip, dst_ip, tcp,
+                                (uint16_t)(sizeof(tcp_header_t) + len));
+    memcpy(tcp + 16, &sum, 2);
+    return off + sizeof(tcp_header_t) + len;
+}
+
+uint32_t host_build_arp(uint8_t *frame, uint16_t opcode, uint32_t sender_ip,
+                        const uint8_t *sender_mac, uint32_t target_ip) {
+    uint8_t *arp = frame + build_eth(frame, ETH_TYPE_ARP);
+    wr16(arp, 1);
+    wr16(arp + 2, ETH_TYPE_IP);
+    arp[4] = 6;
+    arp[5] = 4;
+    wr16(arp + 6, opcode);
+    memcpy(arp + 8, sender_mac, 6);
+    wr32(arp + 14, sender_ip);
+    memset(arp + 18, 0, 6);
+    wr32(arp + 24, target_ip);
+    return sizeof(eth_header_t) + 28;
+}
+
+uint32_t host_build_icmp(uint8_t *frame, uint32_t src_ip, uint8_t type,
+                         uint32_t len) {
+    uint32_t off = build_ip(frame, src_ip, HOST_IP, IP_PROTO_ICMP, len);
+    uint8_t *icmp = frame + off;
+    for (uint32_t i = 0; i < len; i++) icmp[i] = (uint8_t)i;
+    icmp[0] = type;
+    icmp[1] = 0;
+    memset(icmp + 2, 0, 2);
+    uint16_t sum = ip_checksum(icmp, (int)len);
+    memcpy(icmp + 2, &sum, 2);
+    return off + len;
+}
+
+static uint32_t encode_qname(uint8_t *out, const char *name) {
+    uint32_t n = 0;
+    while (*name) {
+        const char *dot = name;
+        while (*dot && *dot != '.') dot++;
+        uint32_t label = (uint32_t)(dot - name);
+        if (label > 63) label = 63;
+        out[n++] = (uint8_t)label;
+        memcpy(out + n, name, label);
+        n += label;
+        name = *dot ? dot + 1 : dot;
+    }
+    out[n++] = 0;
+    return n;
+}
+
+uint32_t host_build_dns_reply(uint8_t *out, uint16_t id, const char *name,
+                              uint32_t ip) {
+    wr16(out, id);
+    wr16(out + 2, 0x8180);
+    wr16(out + 4, 1);
+    wr16(out + 6, 1);
+    wr16(out + 8, 0);
+    wr16(out + 10, 0);
+    uint32_t n = 12;
+    n += encode_qname(out + n, name);
+    wr16(out + n, 1);
+    wr16(out + n + 2, 1);
+    n += 4;
+    wr16(out + n, 0xC00C);
+    wr16(out + n + 2, 1);
+    wr16(out + n + 4, 1);
+    wr32(out + n + 6, 300);
+    wr16(out + n + 10, 4);
+    wr32(out + n + 12, ip);
+    return n + 16;
+}
+
+uint32_t host_build_dhcp_reply(uint8_t *out, uint8_t msg_type, uint32_t yiaddr) {
+    memset(out, 0, 548);
+    out[0] = 2;
+    out[1] = 1;
+    out[2] = 6;
+    uint32_t xid = 0x12345678;          /* dhcp_client.c compares it raw */
+    memcpy(out + 4, &xid, 4);
+    wr32(out + 16, yiaddr);
+    memcpy(out + 28, host_mac, 6);
+    wr32(out + 236, 0x63825363);
+    uint8_t *opt = out + 240;
+    uint32_t n = 0;
+    opt[n++] = 53; opt[n++] = 1; opt[n++] = msg_type;
+    opt[n++] = 54; opt[n++] = 4; wr32(opt + n, HOST_GW); n += 4;
+    opt[n++] = 1;  opt[n++] = 4; wr32(opt + n, HOST_NETMASK); n += 4;
+    opt[n++] = 3;  opt[n++] = 4; wr32(opt + n, HOST_GW); n += 4;
+    opt[n++] = 6;  opt[n++] = 4; wr32(opt + n, HOST_DNS); n += 4;
+    opt[n++] = 255;
+    return 240 + n;
+}
+
+uint32_t host_dns_answer_ip(const char *hostname) {
+    uint32_t h = 5381;
+    while (*hostname) h = h * 33 + (uint8_t)*hostname++;
+    return IP_ADDR(198, 18, (h >> 8) & 0xFF, h & 0xFF);
+}
+
+/* Answer SYNs and DNS queries sent by the kernel */
+static void peer_reply(const uint8_t *frame, uint32_t len) {
+    static uint8_t reply[HOST_FRAME_MAX];
+    const uint32_t l3 = sizeof(eth_header_t);
+
+    if (len < l3 + sizeof(ip_header_t) || rd16(frame + 12) != ETH_TYPE_IP) return;
+    const uint8_t *ip = frame + l3;
+    uint32_t src = rd32(ip + 12), dst = rd32(ip + 16);
+    const uint8_t *l4 = ip + sizeof(ip_header_t);
+    uint32_t l4_len = len - l3 - sizeof(ip_header_t);
+
+    if (ip[9] == IP_PROTO_TCP && l4_len >= sizeof(tcp_header_t)) {
+        uint8_t flags = l4[13];
+        if ((flags & TCP_FLAG_SYN) && !(flags & TCP_FLAG_ACK)) {
+            tcp_peer.established = true;
+            tcp_peer.remote_ip = dst;
+            tcp_peer.local_port = rd16(l4);
+            tcp_peer.remote_port = rd16(l4 + 2);
+            tcp_peer.kernel_seq = rd32(l4 + 4) + 1;
+            tcp_peer.peer_seq = 0x10000000;
+            uint32_t n = host_build_tcp(reply, dst, src, tcp_peer.remote_port,
+                                        tcp_peer.local_port, tcp_peer.peer_seq,
+                                        tcp_peer.kernel_seq,
+                                        TCP_FLAG_SYN | TCP_FLAG_ACK, NULL, 0);
+            tcp_peer.peer_seq++;
+            queue_push(&rx_queue, reply, n);
+        }
+    } else if (ip[9] == IP_PROTO_UDP && l4_len > sizeof(udp_header_t) + 12 &&
+               rd16(l4 + 2) == 53) {
+        const uint8_t *q = l4 + sizeof(udp_header_t);
+        uint32_t q_len = l4_len - sizeof(udp_header_t);
+        char name[256];
+        uint32_t i = 12, n = 0;
+        while (i < q_len && q[i] && n < sizeof(name) - 64) {
+            uint32_t label = q[i++];
+            if (n) name[n++] = '.';
+            for (uint32_t k = 0; k < label && i < q_len; k++) name[n++] = (char)q[i++];
+        }
+        name[n] = '\0';
+        uint8_t dns[512];
+        uint32_t dns_len = host_build_dns_reply(dns, rd16(q), name,
+                                                host_dns_answer_ip(name));
+        uint32_t fn = host_build_udp(reply, dst, src, 53, rd16(l4), dns, dns_len);
+        queue_push(&rx_queue, reply, fn);
+    }
+}
+
+static int mock_send(network_interface_t *iface, const uint8_t *data, uint32_t len) {
+    (void)iface;
+    if (peer_on) peer_reply(data, len);
+    return queue_push(&tx_queue, data, len);
+}
+
+static int mock_recv(network_interface_t *iface, uint8_t *data, uint32_t max_len) {
+    (void)iface;
+    return queue_pop(&rx_queue, data, max_len);
+}
+
+void host_net_init(void) {
+    network_interface_t iface;
+    memset(&iface, 0, sizeof(iface));
+    memcpy(iface.name, "mock0", 6);
+    memcpy(iface.mac_addr, host_mac, 6);
+    iface.link_up = true;
+    iface.send_packet = mock_send;
+    iface.recv_packet = mock_recv;
+
+    netif_init();
+    netif_register(&iface);
+    arp_init();
+    host_net_reset();
+}
+
+void host_net_reset(void) {
+    network_interface_t *iface = netif_get_default();
+    if (iface) {
+        iface->ip_addr = HOST_IP;
+        iface->netmask = HOST_NETMASK;
+        iface->gateway = HOST_GW;
+        iface->dns_server = HOST_DNS;
+        iface->link_up = true;
+    }
+    rx_queue.head = rx_queue.tail = 0;
+    tx_queue.head = tx_queue.tail = 0;
+    memset(&tcp_peer, 0, sizeof(tcp_peer));
+}
+
+int host_net_rx_push(const uint8_t *frame, uint32_t len) {
+    return queue_push(&rx_queue, frame, len);
+}
+
+int host_net_tx_pop(uint8_t *frame, uint32_t max_len) {
+    return queue_pop(&tx_queue, frame, max_len);
+}
+
+uint32_t host_net_tx_pending(void) { return tx_queue.tail - tx_queue.head; }
+uint64_t host_net_tx_dropped(void) { return tx_queue.dropped; }
+void host_net_set_peer(bool on) { peer_on = on; }
+const host_tcp_peer_t *host_net_tcp_peer(void) { return &tcp_peer; }
+void host_net_tcp_advance(uint32_t len) { tcp_peer.peer_seq += len; }
+
+int debug_rx_state(void) { return 0; }
+
+/* Hardware the host build does not model */
+
+int cmd_bench(const char *args) { (void)args; return 0; }
+int cmd_netmode(const char *args) { (void)args; return 0; }
+int cmd_profile(const char *args) { (void)args; return 0; }
+int cmd_boottime(const char *args) { (void)args; return 0; }
+int cmd_backtrace(const char *args) { (void)args; return 0; }
+int heapprof_top(const char *args) { (void)args; return 0; }
+int heapprof_leaks(const char *args) { (void)args; return 0; }
+int irqpool_stats(uint32_t cls, irqpool_stats_t *st) { (void)cls; (void)st; return -1; }
+void boot_mark(uint32_t phase) { (void)phase; }
+
+bool serial_present(void) { return false; }
+void serial_set_mirror(bool on) { (void)on; }
+bool serial_get_mirror(void) { return false; }
+
+void sys_beep(uint32_t freq, uint32_t duration) { (void)freq; (void)duration; }
+void sys_reboot(void) {}
+void sys_shutdown(void) {}
+
+int sys_get_time(uint8_t *hours, uint8_t *minutes, uint8_t *seconds) {
+    *hours = 12; *minutes = 0; *seconds = 0;
+    return 0;
+}
+
+int sys_get_date(uint8_t *day, uint8_t *month, uint16_t *year) {
+    *day = 1; *month = 1; *year = 2025;
+    return 0;
+}
+
+uint32_t pci_config_read(uint8_t bus, uint8_t dev, uint8_t func, uint8_t off) {
+    (void)bus; (void)dev; (void)func; (void)off;
+    return 0xFFFFFFFF;
+}
+
+int wifi_driver_init(void) { return -1; }
+int wifi_driver_test(void) { return -1; }
+
+int gpu_driver_test(void) { return -1; }
+uint32_t *gpu_setup_framebuffer(void) { return NULL; }
+int gpu_flush(void) { return -1; }
+void gpu_clear(uint32_t color) { (void)color; }
+void gpu_fill_rect(int x, int y, int w, int h, uint32_t color) {
+    (void)x; (void)y; (void)w; (void)h; (void)color;
+}
+void gpu_draw_char(int x, int y, uint8_t c, uint32_t fg, uint32_t bg) {
+    (void)x; (void)y; (void)c; (void)fg; (void)bg;
+}
+void gpu_draw_string(int x, int y, const uint8_t *str, uint32_t fg, uint32_t bg) {
+    (void)x; (void)y; (void)str; (void)fg; (void)bg;
+}
+void gpu_disable_scanout(void) {}
+int gpu_get_width(void) { return 0; }
+int gpu_get_height(void) { return 0; }
+
+int gui_notepad(const char *args) { (void)args; return -1; }
+int gui_paint(const char *args) { (void)args; return -1; }
+int gui_sysinfo(const char *args) { (void)args; return -1; }
+int gui_filebrowser(const char *args) { (void)args; return -1; }
+int gui_clock(const char *args) { (void)args; return -1; }
+void gui_draw_cursor(int x, int y) { (void)x; (void)y; }
+
+int mouse_init(void) { return -1; }
+void mouse_poll(void) {}
+int mouse_get_x(void) { return 0; }
+int mouse_get_y(void) { return 0; }
+bool mouse_get_left(void) { return false; }
@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+"""
+RO-DOS headless performance runner.
+
+Boots the floppy image under QEMU with the console on COM1, drives a fixed
+command script over the serial line and records:
+
+  boot.to_prompt        host wall time from QEMU start to the first prompt
+  boot.guest_total      guest time from kernel entry to the prompt (BOOTTIME)
+  bench.<name>          per_iter cycles reported by the in-kernel BENCH command
+  cmd.<workload>        host wall time from sending a command to the next prompt
+
+Results are written as JSON. With --baseline the run is compared against a
+checked-in results file and the script exits non-zero when any metric got
+slower than the allowed threshold (cycle counts and wall times have separate
+thresholds because wall time under emulation is much noisier). A missing or
+empty baseline is an error too, so an unconfigured gate cannot pass; use
+--allow-no-baseline (or PERF_ALLOW_NO_BASELINE=1) to only record results.
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import http.server
+import json
+import os
+import re
+import socketserver
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+PROMPT_RE = re.compile(rb'[A-Z]:\\[^\r\n>]*> ')
+BENCH_RE = re.compile(rb'BENCH (\S+) iters=(\d+) bytes=(\d+) cycles=(\d+) per_iter=(\d+)')
+BOOT_TOTAL_RE = re.compile(rb'BOOTTIME total=(\d+\.\d+) ms')
+
+# Guest-visible address forwarded to the local HTTP server (see guestfwd below)
+HTTP_GUEST_IP = '10.0.2.100'
+HTTP_PAYLOAD = bytes(range(256)) * 64          # 16 KB, deterministic
+
+# (metric name, commands, timeout per command in seconds)
+WORKLOADS = [
+    ('boottime', ['BOOTTIME'], 30),
+    ('bench', ['BENCH'], 300),
+    ('fs.mkdir_cd', ['MKDIR PERFTMP', 'CD PERFTMP'], 30),
+    ('fs.touch_x8', ['TOUCH F%d.TXT' % i for i in range(8)], 60),
+    ('fs.dir', ['DIR'], 30),
+    ('fs.copy_x4', ['COPY F%d.TXT G%d.TXT' % (i, i) for i in range(4)], 60),
+    ('fs.del_x12', ['DEL F%d.TXT' % i for i in range(8)] +
+                   ['DEL G%d.TXT' % i for i in range(4)], 60),
+    ('fs.sync', ['CD ..', 'RMDIR PERFTMP', 'SYNC'], 30),
+    ('net.netstart', ['NETSTART'], 60),
+    ('net.wget_16k', ['WGET http://%s/perf.bin' % HTTP_GUEST_IP], 60),
+    ('shell.help', ['HELP'], 30),
+]
+
+
+class PayloadHandler(http.server.BaseHTTPRequestHandler):
+    def do_GET(self):
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(len(HTTP_PAYLOAD)))
+        self.send_header('Connection', 'close')
+        self.end_headers()
+        self.wfile.write(HTTP_PAYLOAD)
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+class Console:
+    """Serial console of a QEMU child process (stdin/stdout)."""
+
+    def __init__(self, argv, log_path):
+        self.proc = subprocess.Popen(argv, stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT)
+        self.buf = b''
+        self.lock = threading.Lock()
+        self.log = open(log_path, 'wb') if log_path else None
+        self.reader = threading.Thread(target=self._pump, daemon=True)
+        self.reader.start()
+
+    def _pump(self):
+        while True:
+            chunk = self.proc.stdout.read1(4096)
+            if not chunk:
+                break
+            with self.lock:
+                self.buf += chunk
+            if self.log:
+                self.log.write(chunk)
+                self.log.flush()
+
+    def mark(self):
+        with self.lock:
+            return len(self.buf)
+
+    def wait_prompt(self, start, timeout):
+        """Wait for a shell prompt after offset start; return the text before it."""
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            with self.lock:
+                m = PROMPT_RE.search(self.buf, start)
+                if m:
+                    return self.buf[start:m.start()]
+            if self.proc.poll() is not None:
+                raise RuntimeError('QEMU exited (status %d)' % self.proc.returncode)
+            time.sleep(0.01)
+        raise TimeoutError('no prompt within %ds' % timeout)
+
+    def send(self, line):
+        self.proc.stdin.write(line.encode('ascii') + b'\r')
+        self.proc.stdin.flush()
+
+    def command(self, line, timeout):
+        start = self.mark()
+        t0 = time.monotonic()
+        self.send(line)
+        out = self.wait_prompt(start + len(line), timeout)
+        return out, (time.monotonic() - t0) * 1000.0
+
+    def close(self):
+        if self.proc.poll() is None:
+            self.proc.kill()
+        self.proc.wait()
+        if self.log:
+            self.log.close()
+
+
+def qemu_argv(args, hdd, http_port):
+    netdev = 'user,id=net0,guestfwd=tcp:%s:80-tcp:127.0.0.1:%d' % (HTTP_GUEST_IP, http_port)
+    argv = [args.qemu,
+            '-drive', 'file=%s,if=floppy,format=raw,snapshot=on' % args.image,
+            '-drive', 'file=%s,if=ide,format=raw' % hdd,
+            '-boot', 'a', '-m', '32M',
+            '-device', 'virtio-net-pci,disable-modern=on,netdev=net0',
+            '-netdev', netdev,
+            '-display', 'none', '-serial', 'stdio', '-monitor', 'none',
+            '-no-reboot']
+    if args.accel:
+        argv += ['-accel', args.accel]
+    return argv
+
+
+def run(args):
+    metrics = {}
+    errors = []
+
+    httpd = socketserver.TCPServer(('127.0.0.1', 0), PayloadHandler)
+    threading.Thread(target=httpd.serve_forever, daemon=True).start()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        # Fresh, empty HDD every run so filesystem state never skews timings
+        hdd = os.path.join(tmp, 'perf_hdd.img')
+        with open(hdd, 'wb') as f:
+            f.truncate(args.hdd_mb * 1024 * 1024)
+
+        con = Console(qemu_argv(args, hdd, httpd.server_address[1]), args.log)
+        try:
+            t0 = time.monotonic()
+            con.wait_prompt(0, args.boot_timeout)
+            metrics['boot.to_prompt'] = {'value': round((time.monotonic() - t0) * 1000.0, 1),
+                                         'unit': 'ms'}
+
+            for name, cmds, timeout in WORKLOADS:
+                total = 0.0
+                try:
+                    for c in cmds:
+                        out, ms = con.command(c, timeout)
+                        total += ms
+                        if name == 'boottime':
+                            m = BOOT_TOTAL_RE.search(out)
+                            if m:
+                                metrics['boot.guest_total'] = {
+                                    'value': float(m.group(1)), 'unit': 'ms'}
+                        if name == 'bench':
+                            for m in BENCH_RE.finditer(out):
+                                metrics['bench.' + m.group(1).decode()] = {
+                                    'value': int(m.group(5)), 'unit': 'cycles'}
+                            for line in out.splitlines():
+                                if line.startswith(b'BENCH-ERROR'):
+                                    errors.append(line.decode(errors='replace').strip())
+                except (TimeoutError, RuntimeError) as e:
+                    errors.append('%s: %s' % (name, e))
+                    if isinstance(e, RuntimeError):
+                        break
+                    continue
+                metrics['cmd.' + name] = {'value': round(total, 1), 'unit': 'ms'}
+        except (TimeoutError, RuntimeError) as e:
+            errors.append('boot: %s' % e)
+        finally:
+            con.close()
+            httpd.shutdown()
+
+    return {
+        'schema': 1,
+        'image': args.image,
+        'qemu': args.qemu,
+        'accel': args.accel or 'tcg',
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime()),
+        'metrics': metrics,
+        'errors': errors,
+    }
+
+
+def compare(results, baseline, cycle_pct, wall_pct):
+    """Print a comparison table; return the number of regressions."""
+    base = baseline.get('metrics', {})
+    cur = results.get('metrics', {})
+    regressions = 0
+    print('%-34s %14s %14s %8s' % ('metric', 'baseline', 'current', 'delta'))
+    for name in sorted(base):
+        b = base[name]['value']
+        if name not in cur:
+            print('%-34s %14s %14s %8s  MISSING' % (name, b, '-', '-'))
+            regressions += 1
+            continue
+        c = cur[name]['value']
+        limit = cycle_pct if base[name].get('unit') == 'cycles' else wall_pct
+        delta = (c - b) * 100.0 / b if b else 0.0
+        flag = ''
+        if delta > limit:
+            flag = '  REGRESSION (>%g%%)' % limit
+            regressions += 1
+        print('%-34s %14s %14s %+7.1f%%%s' % (name, b, c, delta, flag))
+    for name in sorted(set(cur) - set(base)):
+        print('%-34s %14s %14s %8s  new' % (name, '-', cur[name]['value'], '-'))
+    return regressions
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument('--qemu', default='qemu-system-i386')
+    ap.add_argument('--image', default='build/rodos.img')
+    ap.add_argument('--out', default='build/perf.json')
+    ap.add_argument('--baseline', help='results file to compare against')
+    ap.add_argument('--threshold', type=float, default=10.0,
+                    help='allowed slowdown in %% for cycle metrics (default 10)')
+    ap.add_argument('--wall-threshold', type=float, default=25.0,
+                    help='allowed slowdown in %% for wall-time metrics (default 25)')
+    ap.add_argument('--allow-no-baseline', action='store_true',
+                    default=os.environ.get('PERF_ALLOW_NO_BASELINE') == '1',
+                    help='pass when the baseline is missing or has no metrics')
+    ap.add_argument('--accel', help='QEMU accelerator, e.g. kvm (default tcg)')
+    ap.add_argument('--boot-timeout', type=int, default=120)
+    ap.add_argument('--hdd-mb', type=int, default=100)
+    ap.add_argument('--log', help='save the raw serial transcript here')
+    args = ap.parse_args()
+
+    if not os.path.exists(args.image):
+        sys.exit('perf: %s not found - run "make" first' % args.image)
+
+    results = run(args)
+    os.makedirs(os.path.dirname(os.path.abspath(args.out)), exist_ok=True)
+    with open(args.out, 'w') as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+        f.write('\n')
+    print('perf: %d metrics written to %s' % (len(results['metrics']), args.out))
+
+    status = 0
+    for e in results['errors']:
+        print('perf: error: %s' % e)
+        status = 1
+
+    if args.baseline:
+        baseline = {}
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                baseline = json.load(f)
+        if not baseline.get('metrics'):
+            print('perf: %s is missing or has no metrics - run "make perf-baseline" '
+                  'on the reference machine' % args.baseline)
+            if not args.allow_no_baseline:
+                print('perf: failing; set PERF_ALLOW_NO_BASELINE=1 to run without a baseline')
+                sys.exit(1)
+            sys.exit(status)
+        n = compare(results, baseline, args.threshold, args.wall_threshold)
+        if n:
+            print('perf: %d regression(s) against %s' % (n, args.baseline))
+            status = 1
+    sys.exit(status)
+
+
+if __name__ == '__main__':
+    main()